@@ -1,2 +1,13 @@
 glslang shader.vert --target-env vulkan1.0 --vn vertexShaderCode -o shader.vert.c
-glslang shader.frag --target-env vulkan1.0 --vn fragmentShaderCode -o shader.frag.c
\ No newline at end of file
+glslang shader.frag --target-env vulkan1.0 --vn fragmentShaderCode -o shader.frag.c
+glslang -V shader_bindless.vert --target-env vulkan1.0 -o shader_bindless.vert.spv
+glslang -V shader_bindless.frag --target-env vulkan1.0 -o shader_bindless.frag.spv
+glslang -V shader_culled.vert --target-env vulkan1.0 -o shader_culled.vert.spv
+glslang -V cull.comp --target-env vulkan1.0 -o cull.comp.spv
+glslang -V cull.comp -DOCCLUSION --target-env vulkan1.0 -o cull_occlusion.comp.spv
+glslang -V hiz.comp --target-env vulkan1.0 -o hiz.comp.spv
+glslang -V sprite.vert --target-env vulkan1.0 -o sprite.vert.spv
+glslang -V sprite.frag --target-env vulkan1.0 -o sprite.frag.spv
+glslang -V particles.comp --target-env vulkan1.0 -o particles.comp.spv
+glslang -V particle.vert --target-env vulkan1.0 -o particle.vert.spv
+glslang -V particle.frag --target-env vulkan1.0 -o particle.frag.spv
\ No newline at end of file
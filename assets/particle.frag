@@ -0,0 +1,12 @@
+#version 450
+
+layout (location = 0) in vec2 vCorner;
+layout (location = 1) in vec4 vColor;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    // a soft disc inside the square
+    float falloff = 1.0 - smoothstep(0.5, 1.0, length(vCorner));
+    outColor = vec4(vColor.rgb, vColor.a * falloff);
+}
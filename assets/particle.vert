@@ -0,0 +1,30 @@
+#version 450
+
+// one instance per live particle, see ParticleInstance
+layout (location = 0) in vec4 aPositionSize;
+layout (location = 1) in vec4 aColor;
+
+layout (location = 0) out vec2 vCorner;
+layout (location = 1) out vec4 vColor;
+
+layout (binding = 0) uniform ParticleUniform {
+    mat4 viewProj;
+    vec4 cameraRight;
+    vec4 cameraUp;
+    vec4 emitter;
+    vec4 gravity;
+    uint emitCount;
+    uint seed;
+    float lifetime;
+    float speed;
+    float size;
+} params;
+
+void main() {
+    // strip order: (-1, -1), (1, -1), (-1, 1), (1, 1), a camera facing square around the particle
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1) * 2.0 - 1.0;
+    vec3 position = aPositionSize.xyz + (params.cameraRight.xyz * corner.x + params.cameraUp.xyz * corner.y) * aPositionSize.w;
+    gl_Position = params.viewProj * vec4(position, 1.0);
+    vCorner = corner;
+    vColor = aColor;
+}
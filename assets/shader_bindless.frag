@@ -0,0 +1,15 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec3 vColor;
+layout (location = 2) in vec2 vUV;
+layout (location = 3) flat in uint vTexture;
+
+layout (location = 0) out vec4 oColor;
+
+layout (set = 1, binding = 0) uniform sampler2D uTextures[];
+
+void main() {
+    oColor = texture(uTextures[nonuniformEXT(vTexture)], vUV);
+}
@@ -0,0 +1,32 @@
+#version 450
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aUV;
+layout (location = 3) in uint aTexture;
+
+layout (location = 0) out vec3 vPos;
+layout (location = 1) out vec3 vColor;
+layout (location = 2) out vec2 vUV;
+layout (location = 3) flat out uint vTexture;
+
+layout (binding = 0) uniform UBO {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// positions may be quantized to the mesh's bounds, see VertexDecode
+layout (push_constant) uniform MeshDecode {
+    vec4 scale;
+    vec4 bias;
+} decode;
+
+void main() {
+    vec3 position = aPos * decode.scale.xyz + decode.bias.xyz;
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(position, 1.0);
+    vPos = vec3(gl_Position);
+    vColor = aColor;
+    vUV = aUV;
+    vTexture = aTexture;
+}
@@ -0,0 +1,12 @@
+#version 450
+
+layout (location = 0) in vec2 vUV;
+layout (location = 1) in vec4 vColor;
+
+layout (location = 0) out vec4 oColor;
+
+layout (set = 0, binding = 0) uniform sampler2D uPage;
+
+void main() {
+    oColor = texture(uPage, vUV) * vColor;
+}
@@ -0,0 +1,24 @@
+#version 450
+
+// one instance per sprite, see SpriteInstance
+layout (location = 0) in vec4 aRect;
+layout (location = 1) in vec4 aUV;
+layout (location = 2) in vec4 aColor;
+
+layout (location = 0) out vec2 vUV;
+layout (location = 1) out vec4 vColor;
+
+// framebuffer pixels to NDC
+layout (push_constant) uniform Screen {
+    vec2 scale;
+    vec2 offset;
+} screen;
+
+void main() {
+    // strip order: (0, 0), (1, 0), (0, 1), (1, 1)
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 position = aRect.xy + corner * aRect.zw;
+    gl_Position = vec4(position * screen.scale + screen.offset, 0.0, 1.0);
+    vUV = mix(aUV.xy, aUV.zw, corner);
+    vColor = aColor;
+}
@@ -0,0 +1,44 @@
+#ifndef KRISVERS_VKHELLOWORLD_BINDLESS_HPP
+#define KRISVERS_VKHELLOWORLD_BINDLESS_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <vector>
+
+// One big, partially bound, update-after-bind array of combined image samplers. The set is bound once
+// per command buffer and draws pick their texture with the index returned by add(). Requires
+// VK_EXT_descriptor_indexing or Vulkan 1.2, see DeviceCaps::descriptorIndexing.
+struct TextureTable {
+    static constexpr u32 INVALID_INDEX = ~0u;
+    static constexpr u32 MAX_TEXTURES = 16384;
+
+    VkDevice device = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    u32 capacity = 0;
+    u32 count = 0;
+    std::vector<u32> freeIndices;
+
+    TextureTable(VkDevice device) : device(device) {}
+    ~TextureTable() {
+        cleanup();
+    }
+
+    bool create(u32 maxTextures);
+    void cleanup();
+
+    u32 add(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void write(u32 index, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // the slot must no longer be referenced by any pending command buffer before it is reused
+    void remove(u32 index);
+
+    bool isCreated() const {
+        return set != VK_NULL_HANDLE;
+    }
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef KRISVERS_VKHELLOWORLD_BUDGET_HPP
+#define KRISVERS_VKHELLOWORLD_BUDGET_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <caps.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+// Device memory per heap against what the heap can take. With VK_EXT_memory_budget both numbers come from the
+// driver, which also counts other processes and its own allocations; without it the budget is a share of the heap's
+// size and the usage is only what this process allocated. Every allocation goes through allocateMemory() and
+// freeMemory(), which keep the per heap and per category totals here.
+//
+// The budget is soft: allocating past it usually still works, but the OS starts paging the process out of VRAM and
+// frame times fall off a cliff, or the next allocation fails on drivers that don't page. Whatever can live with less,
+// streamed textures mostly, asks fits() before it grows and evicts or downsamples instead, see SpriteBatch.
+struct MemoryBudget {
+    enum Category : u32 {
+        CATEGORY_TEXTURES = 0,
+        CATEGORY_MESHES,
+        CATEGORY_UNIFORMS,
+        CATEGORY_STAGING,
+        // attachments and the other images the GPU renders into
+        CATEGORY_TARGETS,
+        CATEGORY_OTHER,
+        CATEGORY_COUNT,
+    };
+
+    // of a heap's size, without the extension; the rest is left to the OS and everything else on the GPU
+    static constexpr f64 FALLBACK_SHARE = 0.8;
+    // of the budget, past it fits() says no; what the driver allocates behind our back needs some room too
+    static constexpr f64 SOFT_LIMIT = 0.9;
+
+    struct Heap {
+        VkDeviceSize size = 0;
+        VkMemoryHeapFlags flags = 0;
+        VkDeviceSize budget = 0;
+        // the driver's figure as of the last update(), or 0 without the extension
+        VkDeviceSize reportedUsage = 0;
+        // allocated through here, and what of it was already in reportedUsage
+        VkDeviceSize tracked = 0;
+        VkDeviceSize trackedAtUpdate = 0;
+        VkDeviceSize peak = 0;
+        VkDeviceSize categories[CATEGORY_COUNT] = {};
+    };
+
+    struct Allocation {
+        VkDeviceSize size;
+        u32 heap;
+        Category category;
+    };
+
+    bool extension = false;
+    PFN_vkGetPhysicalDeviceMemoryProperties2 getMemoryProperties2 = nullptr;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    // caps every device local heap's budget when not 0, to try a small GPU's limits on a big one
+    VkDeviceSize cap = 0;
+    Heap heaps[VK_MAX_MEMORY_HEAPS];
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+    u64 overBudget = 0;
+    u64 failures = 0;
+    mutable std::mutex mutex;
+
+    MemoryBudget() = default;
+    MemoryBudget(MemoryBudget const&) = delete;
+    MemoryBudget& operator=(MemoryBudget const&) = delete;
+
+    static MemoryBudget& instance();
+
+    // after the device is created with caps.enable(), budgetCap in bytes or 0
+    void init(VkInstance instance, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkDeviceSize budgetCap);
+    // asks the driver again, its numbers move with every allocation anywhere on the GPU. Cheap enough for once per
+    // stats period and before deciding whether to grow, not for every allocation.
+    void update();
+
+    // whether size more bytes stay under the soft limit of the heap, always true before init()
+    bool fits(u32 heap, VkDeviceSize size) const;
+    VkDeviceSize usage(u32 heap) const;
+
+    void record(VkDeviceMemory memory, u32 memoryType, VkDeviceSize size, Category category);
+    void forget(VkDeviceMemory memory);
+    void failed(u32 memoryType, VkDeviceSize size, Category category, VkResult result);
+
+    static const char* categoryName(Category category);
+    // a line per heap this process uses for the periodic stats: usage against budget, then by category
+    void print() const;
+
+private:
+    VkDeviceSize usageLocked(Heap const& heap) const;
+};
+
+#endif
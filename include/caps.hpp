@@ -0,0 +1,44 @@
+#ifndef KRISVERS_VKHELLOWORLD_CAPS_HPP
+#define KRISVERS_VKHELLOWORLD_CAPS_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <vector>
+
+// Optional device features the renderer can take advantage of. Filled by query() before device
+// creation, then enable() appends the extensions and feature structs needed for what was found.
+struct DeviceCaps {
+    u32 apiVersion = VK_API_VERSION_1_0;
+    std::vector<VkExtensionProperties> extensions;
+
+    bool descriptorIndexing = false;
+    u32 maxBindlessTextures = 0;
+    bool descriptorUpdateTemplate = false;
+    bool pipelineStatistics = false;
+    bool multiDrawIndirect = false;
+    bool drawIndirectFirstInstance = false;
+    u32 maxDrawIndirectCount = 1;
+    // VK_KHR_draw_indirect_count, lets the GPU decide how many indirect draws are consumed
+    bool drawIndirectCount = false;
+    // nanoseconds per timestamp tick, 0 if graphics and compute queues can't write timestamps
+    f32 timestampPeriod = 0.0f;
+    // core 1.2 or VK_KHR_timeline_semaphore, queues then sync through QueueTimeline semaphores instead of fences
+    bool timelineSemaphore = false;
+    // VK_KHR_present_id together with VK_KHR_present_wait, tells when a given present reached the display
+    bool presentWait = false;
+    // VK_EXT_memory_budget, the driver's per heap budget and usage instead of guessing from the heap sizes
+    bool memoryBudget = false;
+
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+
+    bool hasExtension(const char* name) const;
+
+    void query(VkInstance instance, VkPhysicalDevice physicalDevice, u32 instanceApiVersion);
+    void enable(std::vector<const char*>& deviceExtensions, const void** pNext);
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef KRISVERS_VKHELLOWORLD_COMMANDS_HPP
+#define KRISVERS_VKHELLOWORLD_COMMANDS_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <vector>
+
+// Primary command buffers recorded once per (frame in flight, swapchain image) pair and resubmitted as is.
+// Each buffer remembers the version it was recorded at; invalidate() bumps the version whenever the scene or
+// pipeline changes and resize() does the same for a new swapchain, so only stale buffers get re-recorded.
+// A pair is only ever submitted from its own frame slot, so waiting on that slot's fence makes it safe to reset.
+struct StaticCommandBuffers {
+    VkDevice device = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+
+    u32 frameCount = 0;
+    u32 imageCount = 0;
+
+    std::vector<VkCommandBuffer> buffers;
+    std::vector<u64> recordedVersions;
+    u64 version = 1;
+
+    StaticCommandBuffers(VkDevice device, VkCommandPool pool) : device(device), pool(pool) {}
+    StaticCommandBuffers(StaticCommandBuffers const&) = delete;
+    StaticCommandBuffers& operator=(StaticCommandBuffers const&) = delete;
+    ~StaticCommandBuffers() {
+        cleanup();
+    }
+
+    // the pool must have been created with VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+    bool resize(u32 frames, u32 images);
+    void cleanup();
+
+    void invalidate() {
+        ++version;
+    }
+
+    VkCommandBuffer get(u32 frame, u32 image) const {
+        return buffers[frame * imageCount + image];
+    }
+
+    bool isStale(u32 frame, u32 image) const {
+        return recordedVersions[frame * imageCount + image] != version;
+    }
+
+    void markRecorded(u32 frame, u32 image) {
+        recordedVersions[frame * imageCount + image] = version;
+    }
+};
+
+#endif
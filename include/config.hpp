@@ -0,0 +1,89 @@
+#ifndef KRISVERS_VKHELLOWORLD_CONFIG_HPP
+#define KRISVERS_VKHELLOWORLD_CONFIG_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <hostalloc.hpp>
+
+#include <string>
+#include <vector>
+
+// The settings that decide what a run costs, gathered in one place so a perf run can be reproduced from what it
+// printed. A named profile gives every setting its default, then each layer overrides what it names:
+//
+//     profile < config file < environment < command line
+//
+// The profile is picked the same way: --config-profile or --profile, VKHELLOWORLD_PROFILE, "profile = ..." in the
+// file, otherwise "debug", or "release" in NDEBUG builds; "serial" is debug with one frame in flight on one queue.
+// The file is --config <path>, VKHELLOWORLD_CONFIG or vkhelloworld.cfg when present, one "key = value" per line with
+// # comments. Each key is also VKHELLOWORLD_<KEY> in the environment (upper case, dashes as underscores) and
+// --<key> <value> on the command line, booleans as --<key> and --no-<key>.
+struct Config {
+    enum Key : u32 {
+        KEY_VALIDATION = 0,
+        KEY_DEBUG_MESSENGER,
+        KEY_LOG_SEVERITY,
+        KEY_LOG_RATE,
+        KEY_LOG_MUTE,
+        KEY_FRAMES_IN_FLIGHT,
+        KEY_SWAPCHAIN_IMAGES,
+        KEY_PRESENT_MODE,
+        KEY_TARGET_FPS,
+        KEY_ASYNC_QUEUES,
+        KEY_LATENCY_STATS,
+        KEY_STARTUP_REPORT,
+        KEY_TRACE,
+        KEY_HOST_ALLOCATOR,
+        KEY_MEMORY_STATS,
+        KEY_MEMORY_BUDGET,
+        KEY_DIRECT_UPLOAD,
+        KEY_COUNT,
+    };
+
+    std::string profile;
+    std::string file;
+
+    bool validation = false;
+    bool debugMessenger = false;
+    VkDebugUtilsMessageSeverityFlagBitsEXT logSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+    u32 logRate = 10;
+    std::vector<s32> logMute;
+    u32 framesInFlight = 2;
+    u32 swapchainImages = 3;
+    // MAX_ENUM lets the swapchain pick
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAX_ENUM_KHR;
+    f64 targetFps = 0.0;
+    // compute and transfer work on their own queue families when the device has them
+    bool asyncQueues = true;
+    bool latencyStats = false;
+    bool startupReport = false;
+    // Chrome trace written on exit, needs the PROFILER build option
+    std::string trace;
+    // off, track or pool, see HostAllocator
+    HostAllocator::Mode hostAllocation = HostAllocator::MODE_OFF;
+    // device memory per heap and category with the periodic stats
+    bool memoryStats = false;
+    // MiB, caps the budget of every device local heap to see what a smaller GPU would do, 0 for the driver's
+    u32 memoryBudget = 0;
+    // meshes, uniforms and instances written straight into device local memory when the device has it mapped,
+    // false always goes through host memory and staging copies
+    bool directUpload = true;
+
+    // where each setting's value came from: the profile, the file, the environment or the command line
+    const char* sources[KEY_COUNT] = {};
+
+    // the profile, the file and the environment. Prints what went wrong and returns false on a bad value.
+    bool load(int argc, char** argv);
+    // for main's argument loop: consumes argv[i] and its value if it is a config flag, false if it isn't one.
+    // A bad value sets *error.
+    bool parseArgument(int argc, char** argv, int& i, bool* error);
+
+    void print() const;
+
+private:
+    bool applyProfile(const char* name);
+    bool set(Key key, const char* value, const char* source);
+    std::string value(Key key) const;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef KRISVERS_VKHELLOWORLD_CULLING_HPP
+#define KRISVERS_VKHELLOWORLD_CULLING_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <linmath.h>
+#include <descriptors.hpp>
+#include <rendergraph.hpp>
+
+#include <vector>
+
+struct DeviceCaps;
+
+// Matches CullObject in assets/cull.comp (std430) and the per-instance attributes of assets/shader_culled.vert.
+// sphere is the world space bounding sphere, xyz center and w radius.
+struct CullObject {
+    f32 sphere[4];
+    u32 indexCount;
+    u32 firstIndex;
+    s32 vertexOffset;
+    u32 textureIndex;
+};
+
+// Matches the CullUniform block in assets/cull.comp (std140). viewProj, viewport and the depth fields are only
+// read by the occlusion variant, viewport maps NDC xy to depth pixels as scale.xy, bias.xy.
+struct CullUniform {
+    f32 planes[6][4];
+    mat4x4 viewProj;
+    f32 viewport[4];
+    u32 objectCount;
+    u32 depthWidth;
+    u32 depthHeight;
+    u32 pyramidLevels;
+};
+
+// Gribb/Hartmann plane extraction for a [0, 1] depth range, planes are normalized and point inwards.
+void extractFrustumPlanes(f32 planes[6][4], mat4x4 viewProj);
+bool sphereInFrustum(f32 const planes[6][4], f32 const sphere[4]);
+
+// Reference CPU path, compacts visible objects into `commands` and returns how many were written.
+u32 cullObjects(CullUniform const& uniform, CullObject const* objects, VkDrawIndexedIndirectCommand* commands);
+
+// Culls CullObjects against the frustum in a compute shader and compacts the survivors into an indirect
+// command buffer plus a draw count, so the CPU never looks at per-object visibility. Every frame in flight has
+// its own uniform, command and count buffers, so recordCull() and recordDraw() can be recorded once and
+// resubmitted. Without VK_KHR_draw_indirect_count the shader writes every object in place with an instance
+// count of 0 or 1 instead of compacting, and recordDraw() issues all of them. The count buffer holds the number
+// of visible objects either way.
+// firstInstance of each command is the object index, the culled pipeline reads the object buffer per instance,
+// so DeviceCaps::drawIndirectFirstInstance is required.
+//
+// Created with `occlusion`, the module must be cull.comp built with -DOCCLUSION and culling runs in two phases on
+// the graphics queue. The early phase draws what was visible last frame, a HiZPyramid is built from that depth,
+// then the late phase tests every object against it, remembers the result for the next frame and draws only the
+// objects that just became visible. setPyramid() has to be called before the first cull is recorded.
+struct GpuCuller {
+    static constexpr u32 GROUP_SIZE = 64;
+
+    enum Phase : u32 {
+        EARLY = 0,
+        LATE = 1,
+    };
+
+    struct Frame {
+        VkBuffer uniformBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory uniformMemory = VK_NULL_HANDLE;
+        CullUniform* uniform = nullptr;
+
+        VkBuffer commandBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory commandMemory = VK_NULL_HANDLE;
+        VkBuffer countBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory countMemory = VK_NULL_HANDLE;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+
+        // the late phase of the occlusion cull writes its own commands and count through lateSet
+        VkBuffer lateCommandBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory lateCommandMemory = VK_NULL_HANDLE;
+        VkBuffer lateCountBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory lateCountMemory = VK_NULL_HANDLE;
+
+        VkDescriptorSet lateSet = VK_NULL_HANDLE;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+
+    bool compact = false;
+    bool multiDraw = false;
+    bool occlusion = false;
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    DescriptorAllocator descriptorAllocator;
+
+    u32 objectCapacity = 0;
+    u32 objectCount = 0;
+    VkBuffer objectBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory objectMemory = VK_NULL_HANDLE;
+    CullObject* objects = nullptr;
+
+    // one flag per object, written by the late phase and read by the next frame's early phase
+    VkBuffer visibilityBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory visibilityMemory = VK_NULL_HANDLE;
+    u32* visibility = nullptr;
+    u32 pyramidLevels = 0;
+
+    std::vector<Frame> frames;
+
+    GpuCuller() = default;
+    GpuCuller(GpuCuller const&) = delete;
+    GpuCuller& operator=(GpuCuller const&) = delete;
+    ~GpuCuller() {
+        cleanup();
+    }
+
+    // queueFamilies lists every family touching the buffers, more than one makes them concurrently shared
+    bool create(VkDevice device, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkShaderModule cullModule, u32 frameCount, u32 maxObjects, std::vector<u32> const& queueFamilies, bool occlusion = false);
+    void cleanup();
+
+    // the object buffer is host visible and shared by all frames, only call this while none of them are in flight.
+    // Also forgets last frame's visibility, so the next early phase draws nothing.
+    void setObjects(CullObject const* objects, u32 count);
+    void setFrustum(u32 frame, mat4x4 viewProj);
+
+    // points the occlusion cull at a pyramid built over a depthExtent sized attachment that was rendered with
+    // `viewport`, only while no frame is in flight
+    void setPyramid(VkImageView pyramidView, VkSampler sampler, u32 levels, VkExtent2D depthExtent, VkViewport const& viewport);
+    // without occlusion the late phase only tests the frustum, the pyramid is not read and needn't be built
+    void setOcclusionEnabled(bool enabled);
+
+    // clears the count and dispatches the cull, outside of a render pass on a compute capable queue
+    void recordCull(VkCommandBuffer commandBuffer, u32 frame, Phase phase = EARLY) const;
+    // the same cull as a compute pass of graph, which imports the command and count buffers to be left ready for
+    // the indirect draw and, with occlusion, the visibility flags. pyramid is the graph's Hi-Z image, read by the
+    // late phase. Returns the pass.
+    u32 addCullPass(RenderGraph& graph, u32 frame, Phase phase, u32 pyramid = RenderGraph::INVALID) const;
+    // the culled pipeline, vertex/index buffers and descriptor sets must already be bound
+    void recordDraw(VkCommandBuffer commandBuffer, u32 frame, Phase phase = EARLY) const;
+
+    bool isCreated() const {
+        return pipeline != VK_NULL_HANDLE;
+    }
+
+private:
+    // waitForVisibility orders the cull after the previous late phase's flags, a graph does that itself
+    void recordDispatch(VkCommandBuffer commandBuffer, u32 frame, Phase phase, bool waitForVisibility) const;
+};
+
+#endif
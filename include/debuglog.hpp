@@ -0,0 +1,93 @@
+#ifndef KRISVERS_VKHELLOWORLD_DEBUGLOG_HPP
+#define KRISVERS_VKHELLOWORLD_DEBUGLOG_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Debug messenger output that never does I/O on the thread that raised the message. The callback filters by severity
+// and message ID, applies a per-ID rate limit, copies the message into a bounded lock-free MPSC ring and returns; a
+// background thread drains the ring, formats and writes everything it found with a single flush.
+//
+// Producers only ever CAS the ring's tail and store into their slot, a full ring drops the message instead of waiting.
+// Messages longer than a slot are truncated. Dropped and rate limited messages are counted and reported by the writer.
+struct DebugLog {
+    static constexpr u32 CAPACITY = 256;
+    static constexpr u32 MESSAGE_SIZE = 2048;
+    static constexpr u32 ID_NAME_SIZE = 96;
+    // rate limit buckets, message IDs that collide share a budget
+    static constexpr u32 RATE_BUCKETS = 256;
+
+    struct Message {
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+        VkDebugUtilsMessageTypeFlagsEXT type;
+        s32 idNumber;
+        char idName[ID_NAME_SIZE];
+        char text[MESSAGE_SIZE];
+        bool truncated;
+    };
+
+    struct Slot {
+        // position + 1 once written, position + CAPACITY once read, see Vyukov's bounded queue
+        std::atomic<u64> sequence;
+        Message message;
+    };
+
+    struct RateBucket {
+        std::atomic<u64> windowStartMs{ 0 };
+        std::atomic<u32> count{ 0 };
+    };
+
+    // messages below this don't reach the callback at all, see messengerSeverities()
+    VkDebugUtilsMessageSeverityFlagBitsEXT minimumSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+    // per message ID and second, 0 is unlimited
+    u32 perIdPerSecond = 10;
+    // messageIdNumber values that are never shown, only read by the callback once start() returned
+    std::vector<s32> mutedIds;
+
+    // on the heap, the ring is over half a megabyte
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<u64> tail{ 0 };
+    alignas(64) u64 head = 0;
+    RateBucket rateBuckets[RATE_BUCKETS];
+
+    std::atomic<u64> dropped{ 0 };
+    std::atomic<u64> rateLimited{ 0 };
+    u64 reportedDropped = 0;
+    u64 reportedRateLimited = 0;
+    u64 lastReportMs = 0;
+
+    std::thread writer;
+    std::atomic<bool> stopping{ false };
+
+    DebugLog();
+    DebugLog(DebugLog const&) = delete;
+    DebugLog& operator=(DebugLog const&) = delete;
+    ~DebugLog() {
+        cleanup();
+    }
+
+    void start();
+    // writes whatever is still queued and stops the writer, only once no messenger can call the callback any more
+    void cleanup();
+
+    // what to put in VkDebugUtilsMessengerCreateInfoEXT::messageSeverity
+    VkDebugUtilsMessageSeverityFlagsEXT messengerSeverities() const;
+    // pUserData must be the DebugLog
+    static VKAPI_ATTR VkBool32 VKAPI_CALL callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* callbackData, void* userData);
+
+    // false if the message was filtered, rate limited or dropped
+    bool push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, s32 idNumber, const char* idName, const char* text);
+
+private:
+    bool allow(s32 idNumber);
+    // writes out what is queued, returns how many messages that was
+    u32 drain();
+    void writerLoop();
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef KRISVERS_VKHELLOWORLD_DESCRIPTORS_HPP
+#define KRISVERS_VKHELLOWORLD_DESCRIPTORS_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <vector>
+
+struct DeviceCaps;
+
+// Collects descriptor writes for any number of sets and submits them with a single vkUpdateDescriptorSets.
+// Info structs are stored by index and only resolved to pointers in flush(), so the vectors may grow freely.
+struct DescriptorWriter {
+    VkDevice device;
+
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+
+    DescriptorWriter(VkDevice device) : device(device) {}
+
+    void writeBuffer(VkDescriptorSet set, u32 binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+    void writeImage(VkDescriptorSet set, u32 binding, VkDescriptorType type, VkImageView imageView, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    void reserve(usize count);
+    void flush();
+    void clear();
+};
+
+// Wraps VkDescriptorUpdateTemplate (Vulkan 1.1 or VK_KHR_descriptor_update_template). The driver reads every
+// entry straight out of a user struct, so updating a set costs one call with no VkWriteDescriptorSet building.
+struct DescriptorTemplate {
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate handle = VK_NULL_HANDLE;
+
+    PFN_vkCreateDescriptorUpdateTemplate createTemplate = nullptr;
+    PFN_vkDestroyDescriptorUpdateTemplate destroyTemplate = nullptr;
+    PFN_vkUpdateDescriptorSetWithTemplate updateWithTemplate = nullptr;
+
+    DescriptorTemplate() = default;
+    DescriptorTemplate(DescriptorTemplate const&) = delete;
+    DescriptorTemplate& operator=(DescriptorTemplate const&) = delete;
+    ~DescriptorTemplate() {
+        cleanup();
+    }
+
+    bool create(VkDevice device, DeviceCaps const& caps, VkDescriptorSetLayout layout, VkDescriptorUpdateTemplateEntry const* entries, u32 entryCount);
+    void cleanup();
+
+    void update(VkDescriptorSet set, const void* data) const {
+        updateWithTemplate(device, set, handle, data);
+    }
+
+    bool isCreated() const {
+        return handle != VK_NULL_HANDLE;
+    }
+};
+
+// Hands out descriptor sets from pools that are created on demand. Pool sizes are derived from per-type ratios
+// times the set count, and each new pool doubles the set count up to maxSetsPerPool. Exhausted pools are kept
+// until reset(), which returns every set at once with vkResetDescriptorPool and recycles the pools. Use one
+// allocator per frame in flight for transient sets and reset it once that frame's fence has signalled.
+struct DescriptorAllocator {
+    struct PoolRatio {
+        VkDescriptorType type;
+        f32 ratio;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    std::vector<PoolRatio> ratios;
+    VkDescriptorPoolCreateFlags flags = 0;
+
+    u32 setsPerPool = 0;
+    u32 maxSetsPerPool = 4096;
+
+    VkDescriptorPool current = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> fullPools;
+    std::vector<VkDescriptorPool> readyPools;
+
+    u32 allocatedSets = 0;
+
+    DescriptorAllocator() = default;
+    DescriptorAllocator(DescriptorAllocator const&) = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator const&) = delete;
+    DescriptorAllocator(DescriptorAllocator&& other) noexcept;
+    ~DescriptorAllocator() {
+        cleanup();
+    }
+
+    void init(VkDevice device, u32 initialSets, std::vector<PoolRatio> const& ratios, VkDescriptorPoolCreateFlags flags = 0);
+    void cleanup();
+
+    bool allocate(VkDescriptorSetLayout layout, VkDescriptorSet* set, const void* pNext = nullptr);
+    void reset();
+
+    usize poolCount() const {
+        return fullPools.size() + readyPools.size() + (current != VK_NULL_HANDLE ? 1 : 0);
+    }
+
+private:
+    VkDescriptorPool grabPool();
+};
+
+#endif
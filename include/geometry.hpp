@@ -0,0 +1,138 @@
+#ifndef KRISVERS_VKHELLOWORLD_GEOMETRY_HPP
+#define KRISVERS_VKHELLOWORLD_GEOMETRY_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <vertex.hpp>
+
+#include <vector>
+
+// First-fit allocator over [0, capacity) in whatever unit the caller uses. Free ranges are kept sorted by offset
+// and merged with their neighbours on free(), so a pool that is filled and emptied returns to a single range.
+struct RangeAllocator {
+    struct Range {
+        u32 offset;
+        u32 size;
+    };
+
+    std::vector<Range> freeRanges;
+    u32 capacity = 0;
+    u32 used = 0;
+
+    void init(u32 capacity);
+    bool allocate(u32 size, u32* offset);
+    void free(u32 offset, u32 size);
+};
+
+// Where a mesh lives inside a GeometryPool, ready for vkCmdDrawIndexed(indexCount, ..., firstIndex, vertexOffset, ...)
+// once the pool is bound with indexType and decode is pushed.
+struct MeshRange {
+    s32 vertexOffset;
+    u32 vertexCount;
+    u32 firstIndex;
+    u32 indexCount;
+    VkIndexType indexType;
+    VertexDecode decode;
+};
+
+// All meshes share one device local vertex buffer and one index buffer, suballocated per mesh, so drawing any
+// of them only needs bind() once per command buffer. Indices stay relative to the mesh, the draw's vertexOffset
+// moves them to its vertices. Meshes of up to 65536 vertices store 16 bit indices in the same index buffer, which
+// is allocated in 32 bit words, so switching between the two only rebinds it with the other index type.
+//
+// Streaming goes through one host visible staging area per frame in flight: addMesh() copies into the current
+// frame's area and recordUploads() turns everything staged into buffer copies. Call beginFrame() once that frame's
+// fence has signalled; it recycles the staging area and only then gives back the ranges of meshes removed while
+// the frame was last in flight, so an evicted mesh is never overwritten under a draw that still uses it.
+//
+// Where the device has DIRECT_WRITE_MEMORY with room for both buffers they live there instead, addMesh() writes
+// straight to the mesh's ranges and there is no staging area and nothing for recordUploads() to copy. The same range
+// recycling keeps those writes away from anything in flight, and the submit makes them visible to the GPU.
+struct GeometryPool {
+    static constexpr u32 INVALID_MESH = ~0u;
+
+    // every index of a mesh this small fits in 16 bits
+    static VkIndexType indexTypeFor(u32 vertexCount) {
+        return vertexCount <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+
+    struct Frame {
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+        u8* staging = nullptr;
+        VkDeviceSize stagingUsed = 0;
+
+        std::vector<VkBufferCopy> vertexCopies;
+        std::vector<VkBufferCopy> indexCopies;
+        std::vector<u32> retiredMeshes;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    u32 vertexStride = 0;
+
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory indexMemory = VK_NULL_HANDLE;
+
+    // the buffers are persistently mapped DIRECT_WRITE_MEMORY
+    bool directWrite = false;
+    u8* vertexMapped = nullptr;
+    u8* indexMapped = nullptr;
+
+    RangeAllocator vertexRanges;
+    RangeAllocator indexRanges;
+
+    std::vector<MeshRange> meshes;
+    std::vector<bool> resident;
+    std::vector<u32> freeMeshIds;
+
+    std::vector<Frame> frames;
+    VkDeviceSize stagingCapacity = 0;
+    u32 currentFrame = 0;
+
+    GeometryPool() = default;
+    GeometryPool(GeometryPool const&) = delete;
+    GeometryPool& operator=(GeometryPool const&) = delete;
+    ~GeometryPool() {
+        cleanup();
+    }
+
+    // queueFamilies lists every family that uploads or draws, more than one makes the buffers concurrently shared.
+    // allowDirectWrite false always stages, e.g. to compare the two.
+    bool create(VkDevice device, VkPhysicalDevice physicalDevice, u32 vertexStride, u32 maxVertices, u32 maxIndices, u32 frameCount, VkDeviceSize stagingSize, std::vector<u32> const& queueFamilies, bool allowDirectWrite = true);
+    void cleanup();
+
+    void beginFrame(u32 frame);
+
+    // vertices are vertexStride bytes each, already encoded. INVALID_MESH when the pool or this frame's staging
+    // area is full, a later frame may have room again
+    u32 addMesh(void const* vertices, u32 vertexCount, u32 const* indices, u32 indexCount, VertexDecode const& decode = {});
+    // indices already in indexTypeFor(vertexCount), e.g. straight out of a cooked mesh file
+    u32 addMesh(void const* vertices, u32 vertexCount, void const* indices, VkIndexType indexType, u32 indexCount, VertexDecode const& decode);
+    void removeMesh(u32 mesh);
+
+    bool hasPendingUploads() const {
+        Frame const& f = frames[currentFrame];
+        return !f.vertexCopies.empty() || !f.indexCopies.empty();
+    }
+
+    // outside of a render pass, before anything draws the new meshes. consumerStages is where the data is used
+    // next, 0 skips the barrier for a queue that is waited on right after, like a transfer only one.
+    void recordUploads(VkCommandBuffer commandBuffer, VkPipelineStageFlags consumerStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+    void bind(VkCommandBuffer commandBuffer, VkIndexType indexType = VK_INDEX_TYPE_UINT32) const;
+
+    MeshRange const& mesh(u32 id) const {
+        return meshes[id];
+    }
+
+private:
+    void destroyBuffers();
+
+    // reserves ranges and staging for a mesh and copies its vertices, the caller writes the indices. With directWrite
+    // both go straight to the mesh's ranges.
+    u32 stage(void const* vertices, u32 vertexCount, u32 indexCount, VertexDecode const& decode, void** indexStaging);
+};
+
+#endif
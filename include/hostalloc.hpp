@@ -0,0 +1,120 @@
+#ifndef KRISVERS_VKHELLOWORLD_HOSTALLOC_HPP
+#define KRISVERS_VKHELLOWORLD_HOSTALLOC_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// VkAllocationCallbacks for the driver's host allocations, so they show up somewhere. Every create and destroy passes
+// hostAllocator(<the object's type>), which is nullptr (the driver's own malloc) unless init() turned it on. Each object
+// type gets its own callbacks so allocations are counted per type as well as per VkSystemAllocationScope. Command scope
+// allocations only live for the call, a steady stream of them is the churn worth chasing.
+//
+// With MODE_POOL small allocations with at most 16 byte alignment come from size class free lists instead of malloc.
+// Pool memory is kept for the rest of the run, the free lists only ever grow to the high water mark.
+//
+// Whatever mode is chosen has to stay for the whole run: an object must be destroyed with callbacks compatible with
+// the ones it was created with, so init() comes before the instance is created.
+struct HostAllocator {
+    enum Mode : u32 {
+        MODE_OFF = 0,
+        MODE_TRACK,
+        MODE_POOL,
+    };
+
+    static constexpr u32 SCOPE_COUNT = 5;
+    // the object types this program creates, anything else is counted as the last, unknown
+    static constexpr u32 TAG_COUNT = 23;
+    // every allocation is preceded by one, it says how to free it
+    static constexpr usize HEADER_SIZE = 16;
+    // blocks of 64 B to 2 KiB, the header included
+    static constexpr u32 SIZE_CLASS_COUNT = 6;
+    static constexpr usize MIN_CLASS_SIZE = 64;
+    static constexpr usize CHUNK_SIZE = 64 * 1024;
+
+    struct Counters {
+        std::atomic<u64> allocations{ 0 };
+        std::atomic<u64> reallocations{ 0 };
+        std::atomic<u64> frees{ 0 };
+        std::atomic<u64> pooled{ 0 };
+        std::atomic<u64> liveBytes{ 0 };
+        std::atomic<u64> peakBytes{ 0 };
+        std::atomic<u64> maxAlignment{ 0 };
+        // reported through the internal allocation notifications, e.g. executable memory for shaders
+        std::atomic<u64> internalBytes{ 0 };
+    };
+
+    // one per object type
+    struct Tag {
+        VkObjectType type;
+        const char* name;
+        VkAllocationCallbacks callbacks;
+        Counters scopes[SCOPE_COUNT];
+    };
+
+    struct SizeClass {
+        std::mutex mutex;
+        void* freeList = nullptr;
+        std::vector<void*> chunks;
+    };
+
+    // plain totals at one point in time
+    struct Totals {
+        u64 allocations = 0;
+        u64 reallocations = 0;
+        u64 frees = 0;
+        u64 pooled = 0;
+        u64 liveBytes = 0;
+        u64 peakBytes = 0;
+        u64 maxAlignment = 0;
+        u64 internalBytes = 0;
+    };
+
+    Mode mode = MODE_OFF;
+    Tag tags[TAG_COUNT];
+    SizeClass sizeClasses[SIZE_CLASS_COUNT];
+    std::atomic<u64> liveBytes{ 0 };
+    std::atomic<u64> peakBytes{ 0 };
+
+    // what the last printChurn() saw, per tag
+    Totals lastChurn[TAG_COUNT];
+
+    HostAllocator();
+    HostAllocator(HostAllocator const&) = delete;
+    HostAllocator& operator=(HostAllocator const&) = delete;
+    ~HostAllocator();
+
+    static HostAllocator& instance();
+
+    void init(Mode mode);
+    const VkAllocationCallbacks* callbacks(VkObjectType type) const;
+
+    Totals totals(Tag const& tag) const;
+    Totals scopeTotals(u32 scope) const;
+
+    // one line for the periodic stats: live and peak bytes and the allocations per second since the last call,
+    // with the object types that made the most of them
+    void printChurn(f64 seconds);
+    // everything per object type and scope, live bytes left at exit are leaks or objects nobody destroyed
+    void printReport() const;
+
+private:
+    void* allocate(Tag& tag, usize size, usize alignment, VkSystemAllocationScope scope);
+    void* reallocate(Tag& tag, void* original, usize size, usize alignment, VkSystemAllocationScope scope);
+    void release(void* memory);
+
+    static VKAPI_ATTR void* VKAPI_CALL allocationCallback(void* userData, usize size, usize alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void* VKAPI_CALL reallocationCallback(void* userData, void* original, usize size, usize alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL freeCallback(void* userData, void* memory);
+    static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(void* userData, usize size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(void* userData, usize size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+};
+
+inline const VkAllocationCallbacks* hostAllocator(VkObjectType type) {
+    return HostAllocator::instance().callbacks(type);
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef KRISVERS_VKHELLOWORLD_LATENCY_HPP
+#define KRISVERS_VKHELLOWORLD_LATENCY_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <caps.hpp>
+
+#include <chrono>
+#include <vector>
+
+// Timestamps every frame at the points that make up its latency, from the input poll to the display, and keeps the
+// last CAPACITY frames in a ring. The present id handed to VkPresentIdKHR is the frame's own id, so with
+// VK_KHR_present_wait the frame is marked displayed when a zero-timeout vkWaitForPresentKHR first succeeds for it.
+// That is polled once per loop iteration, so display times are late by up to a frame, and under MAILBOX a frame
+// that was replaced before scanout counts as displayed with the one that replaced it.
+struct LatencyTracker {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr u32 CAPACITY = 512;
+
+    enum Marker : u32 {
+        MARKER_POLL = 0,
+        MARKER_UNIFORM = 1,
+        MARKER_SUBMIT = 2,
+        MARKER_PRESENT = 3,
+        MARKER_DISPLAY = 4,
+        MARKER_COUNT = 5,
+    };
+
+    struct Frame {
+        u64 id = 0;
+        Clock::time_point times[MARKER_COUNT];
+        // bit per marker that was reached
+        u32 marked = 0;
+    };
+
+    // averages and maxima, in milliseconds from the poll, over the frames that reached each marker
+    struct Summary {
+        u32 frames[MARKER_COUNT] = {};
+        f64 averageMs[MARKER_COUNT] = {};
+        f64 maxMs[MARKER_COUNT] = {};
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+
+    std::vector<Frame> ring = std::vector<Frame>(CAPACITY);
+    u64 nextId = 1;
+    // oldest presented frame not yet seen on the display
+    u64 firstUndisplayed = 1;
+    // first frame not yet in a summary
+    u64 firstUnsummarized = 1;
+
+    // display times only with caps.presentWait enabled on the device
+    void init(VkDevice device, DeviceCaps const& caps);
+
+    // starts a frame at its input poll, returns its id
+    u64 beginFrame();
+    void mark(Marker marker);
+
+    // the current frame's id for VkPresentIdKHR, 0 without present wait
+    u64 presentId() const {
+        return waitForPresent != nullptr ? nextId - 1 : 0;
+    }
+
+    // marks every presented frame on swapchain that has reached the display
+    void pollDisplay(VkSwapchainKHR swapchain);
+    // a new swapchain never shows what was presented to the old one
+    void dropPending();
+
+    Frame const* find(u64 id) const {
+        Frame const& frame = ring[id % CAPACITY];
+        return frame.id == id ? &frame : nullptr;
+    }
+
+    // frames begun since the last summary that have either been displayed or can no longer be
+    Summary summarize();
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef KRISVERS_VKHELLOWORLD_LOD_HPP
+#define KRISVERS_VKHELLOWORLD_LOD_HPP
+
+#include <types.hpp>
+
+// The levels of detail of one mesh in a GeometryPool, finest first. error is how far a level strays from the full
+// mesh in world units and never shrinks from one level to the next.
+struct LodChain {
+    static constexpr u32 MAX_LODS = 4;
+
+    u32 count = 0;
+    u32 firstIndex[MAX_LODS];
+    u32 indexCount[MAX_LODS];
+    f32 error[MAX_LODS];
+};
+
+// Pixels a world unit covers at distance 1 under a perspective projection spanning fovY radians over
+// viewportHeight pixels, i.e. viewportHeight / (2 tan(fovY / 2)).
+f32 lodProjectionScale(f32 fovY, f32 viewportHeight);
+
+// Picks for each instance the coarsest level whose error, projected at the instance's distance from the eye, stays
+// within thresholdPixels, and returns how many triangles the picks add up to. Positions come as separate x, y and
+// z arrays so four instances go through each SSE2 or NEON instruction, the level is found by comparing squared
+// distances against per level limits, without a divide or square root per instance.
+u64 selectLods(LodChain const& chain, f32 const* x, f32 const* y, f32 const* z, u32 count, f32 const eye[3], f32 projectionScale, f32 thresholdPixels, u8* lods);
+
+// One instance at a time, same result as selectLods().
+u64 selectLodsScalar(LodChain const& chain, f32 const* x, f32 const* y, f32 const* z, u32 count, f32 const eye[3], f32 projectionScale, f32 thresholdPixels, u8* lods);
+
+#endif
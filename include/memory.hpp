@@ -0,0 +1,38 @@
+#ifndef KRISVERS_VKHELLOWORLD_MEMORY_HPP
+#define KRISVERS_VKHELLOWORLD_MEMORY_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <budget.hpp>
+
+#include <vector>
+
+// findMemoryType() when no type in typeBits has all the flags
+constexpr u32 MEMORY_TYPE_NONE = ~0u;
+
+// Device local memory the CPU writes straight into: integrated GPUs, resizable BAR and software ICDs. Uploads there
+// skip the staging copy. Without resizable BAR a discrete GPU only has a 256 MiB window of it, so ask the budget.
+constexpr VkMemoryPropertyFlags DIRECT_WRITE_MEMORY = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+// Of the types in typeBits with all of flags, the one with the fewest other properties whose heap still has room
+// for size under the MemoryBudget, so a plain device local buffer doesn't take up the direct write window and a
+// staging buffer doesn't land in it. Ignores the budget when no heap has room, MEMORY_TYPE_NONE if no type has the
+// flags.
+u32 findMemoryType(u32 typeBits, VkMemoryPropertyFlags flags, VkPhysicalDeviceMemoryProperties const& props, VkDeviceSize size = 0);
+
+// DIRECT_WRITE_MEMORY in typeBits with room for size, ~0u for any buffer
+bool hasDirectWriteMemory(VkPhysicalDeviceMemoryProperties const& props, u32 typeBits, VkDeviceSize size);
+// For what the CPU writes and the GPU reads: DIRECT_WRITE_MEMORY when allowed and there is room, otherwise host
+// visible memory that the GPU reads across the bus
+VkMemoryPropertyFlags hostWriteMemory(VkPhysicalDeviceMemoryProperties const& props, u32 typeBits, VkDeviceSize size, bool allowDirectWrite = true);
+
+// vkAllocateMemory for requirements, counted under category in the MemoryBudget. Prints what went wrong and returns
+// false when no type fits or the allocation fails.
+bool allocateMemory(VkDevice device, VkPhysicalDeviceMemoryProperties const& memoryProperties, VkMemoryRequirements const& requirements, VkMemoryPropertyFlags flags, MemoryBudget::Category category, VkDeviceMemory* memory);
+// vkFreeMemory for what allocateMemory() returned, VK_NULL_HANDLE is fine
+void freeMemory(VkDevice device, VkDeviceMemory memory);
+
+// Creates a buffer with its own dedicated allocation. More than one queue family makes it concurrently shared.
+bool createBuffer(VkDevice device, VkPhysicalDeviceMemoryProperties const& memoryProperties, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags, MemoryBudget::Category category, std::vector<u32> const& queueFamilies, VkBuffer* buffer, VkDeviceMemory* memory);
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef KRISVERS_VKHELLOWORLD_MESH_HPP
+#define KRISVERS_VKHELLOWORLD_MESH_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <vertex.hpp>
+
+#include <vector>
+
+// One level of detail, a range of MeshData::indices over the shared vertices. error is roughly how far its surface
+// strays from the full mesh, in model units.
+struct MeshLod {
+    u32 firstIndex;
+    u32 indexCount;
+    f32 error;
+};
+
+// An indexed triangle list on the CPU. normals holds three floats per vertex, or nothing when the source had none.
+// Without lods every index belongs to the one full detail level.
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<f32> normals;
+    std::vector<u32> indices;
+    std::vector<MeshLod> lods;
+};
+
+// Reads positions, texture coordinates, normals and the common `v x y z r g b` vertex color extension. Polygons are
+// fanned into triangles and every distinct corner becomes a vertex, optimizeMesh() merges the duplicates.
+bool loadObj(const char* path, MeshData* mesh);
+
+// Cook time optimization, in order: identical vertices are merged, triangles reordered for post-transform cache
+// hits (Forsyth's linear-speed algorithm), the resulting clusters sorted outside in to cut overdraw, and vertices
+// renumbered in first-use order so fetches walk the vertex buffer forwards.
+void optimizeMesh(MeshData& mesh, u32 cacheSize = 32);
+
+// Appends up to lodCount - 1 coarser index lists, each about half the triangles of the one before, by quadric error
+// edge collapses (Garland and Heckbert) that keep the surviving vertex in place, so every level draws from the same
+// vertex buffer. Vertices on open borders and on attribute seams never move. Run after optimizeMesh(), the new
+// levels get their own cache optimization. Stops early once a level cannot shrink much anymore.
+void generateLods(MeshData& mesh, u32 lodCount, u32 cacheSize = 32);
+
+// Post-transform cache misses per triangle with a FIFO of cacheSize entries, 3 is the worst and 0.5 near the best.
+f32 averageCacheMissRatio(std::vector<u32> const& indices, u32 vertexCount, u32 cacheSize = 32);
+
+// Layout of a cooked mesh file: this header, then vertexCount encoded vertices at vertexDataOffset and indexCount
+// indices of indexType at indexDataOffset, both 16 byte aligned. The data is exactly what GeometryPool stores, so
+// loading is one copy from the mapped file into staging. The indices hold every level of detail back to back,
+// lods[0] being the full mesh.
+struct CookedMeshHeader {
+    static constexpr u32 MAGIC = 0x4853454d; // "MESH"
+    static constexpr u32 VERSION = 2;
+    static constexpr u32 MAX_LODS = 4;
+
+    u32 magic;
+    u32 version;
+    u32 position;
+    u32 color;
+    u32 uv;
+    u32 normal;
+    u32 vertexStride;
+    u32 vertexCount;
+    u32 indexCount;
+    u32 indexType;
+    VertexDecode decode;
+    f32 boundsMin[4];
+    f32 boundsMax[4];
+    u64 vertexDataOffset;
+    u64 indexDataOffset;
+    u32 lodCount;
+    MeshLod lods[MAX_LODS];
+
+    VertexFormat format() const {
+        return { static_cast<VertexFormat::Position>(position), static_cast<VertexFormat::Color>(color), static_cast<VertexFormat::Uv>(uv), static_cast<VertexFormat::Normal>(normal) };
+    }
+};
+
+bool cookMesh(MeshData const& mesh, VertexFormat const& format, const char* path);
+
+// A cooked mesh file mapped read-only, the pointers stay valid until close().
+struct CookedMesh {
+    CookedMeshHeader const* header = nullptr;
+    void const* vertices = nullptr;
+    void const* indices = nullptr;
+
+    void* mapping = nullptr;
+    usize mappingSize = 0;
+
+    CookedMesh() = default;
+    CookedMesh(CookedMesh const&) = delete;
+    CookedMesh& operator=(CookedMesh const&) = delete;
+    ~CookedMesh() {
+        close();
+    }
+
+    bool open(const char* path);
+    void close();
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef KRISVERS_VKHELLOWORLD_OCCLUSION_HPP
+#define KRISVERS_VKHELLOWORLD_OCCLUSION_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <descriptors.hpp>
+
+#include <vector>
+
+// A max-depth mip chain over a depth attachment for occlusion tests. Level 0 is half the depth resolution and each
+// texel keeps the farthest depth under it; odd edges fold their extra row or column into the last texel, so a
+// depth pixel p always lands in texel min(p >> (level + 1), size - 1). Built with one compute dispatch per level
+// from assets/hiz.comp and kept in VK_IMAGE_LAYOUT_GENERAL for the cull to sample.
+struct HiZPyramid {
+    static constexpr u32 GROUP_SIZE = 8;
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    DescriptorAllocator descriptorAllocator;
+
+    VkImage depthImage = VK_NULL_HANDLE;
+    VkImageAspectFlags depthAspect = 0;
+    VkExtent2D depthExtent = {};
+
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    std::vector<VkImageView> levelViews;
+    // sets[i] reads level i - 1 (the depth attachment for level 0) and writes level i
+    std::vector<VkDescriptorSet> sets;
+    VkExtent2D extent = {};
+    u32 levelCount = 0;
+
+    HiZPyramid() = default;
+    HiZPyramid(HiZPyramid const&) = delete;
+    HiZPyramid& operator=(HiZPyramid const&) = delete;
+    ~HiZPyramid() {
+        cleanup();
+    }
+
+    bool create(VkDevice device, VkPhysicalDevice physicalDevice, VkShaderModule reduceModule);
+    void cleanup();
+
+    // (re)creates the pyramid for a depth attachment that has VK_IMAGE_USAGE_SAMPLED_BIT, the old one must be idle
+    bool resize(VkImage depthImage, VkImageView depthView, VkFormat depthFormat, VkExtent2D depthExtent);
+
+    // outside of a render pass, the depth attachment must be in DEPTH_STENCIL_ATTACHMENT_OPTIMAL and is put back there
+    void record(VkCommandBuffer commandBuffer) const;
+    // only the dispatches and the barriers between levels, for a RenderGraph pass that reads the depth attachment as
+    // ACCESS_SAMPLED_COMPUTE and writes the pyramid as ACCESS_STORAGE_WRITE_COMPUTE; the graph does the rest
+    void recordReduce(VkCommandBuffer commandBuffer) const;
+
+    bool isCreated() const {
+        return image != VK_NULL_HANDLE;
+    }
+
+private:
+    void destroyImage();
+};
+
+bool supportsDepthSampling(VkPhysicalDevice physicalDevice, VkFormat depthFormat);
+
+// Splits a single color + depth pass for the two-phase cull. The early pass clears and stores depth for the pyramid,
+// the late pass loads both attachments and leaves color in finalColorLayout. Both stay compatible with any render
+// pass using the same formats, so existing pipelines and framebuffers work with them.
+bool createTwoPhaseRenderPasses(VkDevice device, VkFormat colorFormat, VkFormat depthFormat, VkImageLayout finalColorLayout, VkRenderPass* earlyPass, VkRenderPass* latePass);
+
+#endif
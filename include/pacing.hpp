@@ -0,0 +1,55 @@
+#ifndef KRISVERS_VKHELLOWORLD_PACING_HPP
+#define KRISVERS_VKHELLOWORLD_PACING_HPP
+
+#include <types.hpp>
+#include <timeline.hpp>
+
+#include <chrono>
+#include <deque>
+
+// Caps the frame rate by sleeping before input is sampled rather than after the frame is submitted, so the sleep
+// eats into queueing instead of into the age of the input. The loop calls waitForFrame() once its frame slot is free,
+// samples input right after it returns, and hands the graphics timeline value of each submit to frameSubmitted().
+//
+// Latency is measured from the input sample to submit and to the GPU finishing the frame, the latter as first
+// observed by poll(), which runs after the slot wait, where the oldest frame in flight is the one that just finished.
+// Neither includes the compositor or scanout.
+struct FramePacer {
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        u32 frames = 0;
+        f64 sleepMs = 0.0;
+        f64 inputToSubmitMs = 0.0;
+        f64 inputToGpuMs = 0.0;
+        u32 gpuFrames = 0;
+    };
+
+    struct InFlight {
+        u64 value;
+        Clock::time_point input;
+    };
+
+    // 0 leaves the rate to the present mode
+    f64 targetFrameSeconds = 0.0;
+
+    Clock::time_point nextFrame = Clock::now();
+    Clock::time_point input = Clock::now();
+    std::deque<InFlight> inFlight;
+    Stats stats;
+
+    // sleeps until the next frame is due, the last stretch is spun since sleeps overshoot by up to a scheduler tick
+    void waitForFrame();
+    void frameSubmitted(u64 graphicsValue);
+    // records the latency of every frame the graphics queue has finished
+    void poll(QueueTimeline& graphicsTimeline);
+
+    // the stats since the last call
+    Stats takeStats() {
+        Stats s = stats;
+        stats = {};
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef KRISVERS_VKHELLOWORLD_PARTICLES_HPP
+#define KRISVERS_VKHELLOWORLD_PARTICLES_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <linmath.h>
+#include <descriptors.hpp>
+
+#include <vector>
+
+// Matches the ParticleUniform block shared by assets/particles.comp and assets/particle.vert (std140). emitter is
+// xyz position and w the radius particles are spawned in, gravity.w is the step in seconds and size is the
+// billboard half extent in world units.
+struct ParticleUniform {
+    mat4x4 viewProj;
+    f32 cameraRight[4];
+    f32 cameraUp[4];
+    f32 emitter[4];
+    f32 gravity[4];
+    u32 emitCount;
+    u32 seed;
+    f32 lifetime;
+    f32 speed;
+    f32 size;
+    u32 padding[3];
+};
+
+// Matches the per-instance attributes of assets/particle.vert, what the simulation writes for every particle alive
+// after its step.
+struct ParticleInstance {
+    f32 position[3];
+    f32 size;
+    u32 color;
+};
+
+// Particles that live entirely on the GPU. The simulation state, a particle buffer, a dead list of free slots and
+// two alive lists used in turn, is only ever touched by compute shaders, in four dispatches recorded once per frame
+// in flight: begin takes this frame's emission out of the dead list and sizes the indirect dispatches, emit spawns
+// particles into the freed slots, simulate moves every live particle and appends it to the other alive list and its
+// frame's instance buffer, or pushes it back on the dead list, and end flips the lists and writes the instance
+// count into the frame's indirect draw. The CPU never reads a count back.
+//
+// The instance buffer and draw arguments are per frame in flight, so a simulation step only waits on the fence of
+// its own slot and can run on the compute queue while graphics still draws the previous frame's particles. Steps
+// must be submitted in frame order on one queue, they share the state.
+struct ParticleSystem {
+    static constexpr u32 GROUP_SIZE = 64;
+
+    // specialization constant 0 of assets/particles.comp
+    enum Stage : u32 {
+        STAGE_RESET = 0,
+        STAGE_BEGIN = 1,
+        STAGE_EMIT = 2,
+        STAGE_SIMULATE = 3,
+        STAGE_END = 4,
+        STAGE_COUNT = 5,
+    };
+
+    struct Frame {
+        VkBuffer uniformBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory uniformMemory = VK_NULL_HANDLE;
+        ParticleUniform* uniform = nullptr;
+
+        VkBuffer instanceBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory instanceMemory = VK_NULL_HANDLE;
+        VkBuffer drawBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory drawMemory = VK_NULL_HANDLE;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline computePipelines[STAGE_COUNT] = {};
+    VkPipeline drawPipeline = VK_NULL_HANDLE;
+    DescriptorAllocator descriptorAllocator;
+
+    u32 capacity = 0;
+    VkBuffer particleBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory particleMemory = VK_NULL_HANDLE;
+    VkBuffer deadBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory deadMemory = VK_NULL_HANDLE;
+    VkBuffer aliveBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory aliveMemory = VK_NULL_HANDLE;
+    // counters followed by the indirect dispatch arguments of emit and simulate
+    VkBuffer counterBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory counterMemory = VK_NULL_HANDLE;
+
+    std::vector<Frame> frames;
+
+    // particles per second and how long each lives, the emission in a step carries its fraction over to the next
+    f32 emitRate = 0.0f;
+    f32 lifetime = 2.0f;
+    f32 emitRemainder = 0.0f;
+    u32 step = 0;
+
+    ParticleSystem() = default;
+    ParticleSystem(ParticleSystem const&) = delete;
+    ParticleSystem& operator=(ParticleSystem const&) = delete;
+    ~ParticleSystem() {
+        cleanup();
+    }
+
+    // computeModule is assets/particles.comp, the draw pipeline is for subpass 0 of renderPass and depth tests without
+    // writing. queueFamilies lists every family touching the buffers, more than one makes them concurrently shared.
+    bool create(VkDevice device, VkPhysicalDevice physicalDevice, VkRenderPass renderPass, VkShaderModule computeModule, VkShaderModule vertexModule, VkShaderModule fragmentModule, u32 maxParticles, u32 frameCount, std::vector<u32> const& queueFamilies);
+    void cleanup();
+
+    // marks every particle dead and empties both alive lists, once before the first step and only with nothing in flight
+    void recordReset(VkCommandBuffer commandBuffer) const;
+
+    // fills the frame's uniform for a step of dt seconds, only once that frame's fence has signalled
+    void update(u32 frame, f32 dt, mat4x4 viewProj, mat4x4 view, f32 const emitterPosition[3]);
+
+    // one simulation step writing the frame's instances, outside of a render pass on a compute capable queue.
+    // Depends only on the frame's uniform contents, so it can be recorded once and resubmitted.
+    void recordSimulate(VkCommandBuffer commandBuffer, u32 frame) const;
+    // inside a render pass of the one the system was created for, after the viewport and scissor are set
+    void recordDraw(VkCommandBuffer commandBuffer, u32 frame) const;
+
+    bool isCreated() const {
+        return drawPipeline != VK_NULL_HANDLE;
+    }
+};
+
+#endif
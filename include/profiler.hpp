@@ -0,0 +1,95 @@
+#ifndef KRISVERS_VKHELLOWORLD_PROFILER_HPP
+#define KRISVERS_VKHELLOWORLD_PROFILER_HPP
+
+#include <types.hpp>
+
+// Scoped CPU zones, compiled in with VKHELLOWORLD_PROFILER (the PROFILER CMake option) and to nothing otherwise.
+//
+//     PROFILE_ZONE("record");                  // until the end of the enclosing scope
+//     PROFILE_ZONE_BEGIN(acquire, "acquire");  // for code that can't get a scope of its own
+//     PROFILE_ZONE_END(acquire);
+//
+// Zone names must be string literals or otherwise outlive the profiler. Each thread writes finished zones into its
+// own ring with no locking, the only lock is taken once per thread to register its ring. The rings keep the last
+// RING_CAPACITY zones per thread, writeChromeTrace() exports them as trace-event JSON for about:tracing or Perfetto.
+#ifdef VKHELLOWORLD_PROFILER
+
+#include <atomic>
+
+namespace profiler {
+
+constexpr u32 RING_CAPACITY = 1 << 16;
+
+struct Zone {
+    const char* name;
+    u64 startNs;
+    u64 endNs;
+};
+
+struct Ring {
+    Zone zones[RING_CAPACITY];
+    // zones ever written, the writer alone advances it
+    std::atomic<u64> head{ 0 };
+    u32 threadIndex = 0;
+    const char* threadName = nullptr;
+};
+
+// nanoseconds since the profiler's epoch, the first call
+u64 now();
+// the calling thread's ring, registered on first use
+Ring& threadRing();
+// shows up as the thread's name in the trace
+void setThreadName(const char* name);
+
+inline void record(const char* name, u64 startNs, u64 endNs) {
+    Ring& ring = threadRing();
+    u64 head = ring.head.load(std::memory_order_relaxed);
+    ring.zones[head % RING_CAPACITY] = { name, startNs, endNs };
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+// safe while other threads keep recording, zones they overwrite during the export are left out
+bool writeChromeTrace(const char* path);
+
+struct ScopedZone {
+    const char* name;
+    u64 startNs;
+    bool open = true;
+
+    explicit ScopedZone(const char* zoneName) : name(zoneName), startNs(now()) {}
+    ScopedZone(ScopedZone const&) = delete;
+    ScopedZone& operator=(ScopedZone const&) = delete;
+    ~ScopedZone() {
+        end();
+    }
+
+    void end() {
+        if (open) {
+            record(name, startNs, now());
+            open = false;
+        }
+    }
+};
+
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ::profiler::ScopedZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_ZONE_BEGIN(var, name) ::profiler::ScopedZone profileZone_##var(name)
+#define PROFILE_ZONE_END(var) profileZone_##var.end()
+#define PROFILE_THREAD_NAME(name) ::profiler::setThreadName(name)
+#define PROFILE_WRITE_TRACE(path) ::profiler::writeChromeTrace(path)
+
+#else
+
+// the arguments are still evaluated, so a name that is only there for the profiler doesn't warn as unused
+#define PROFILE_ZONE(name) ((void)(name))
+#define PROFILE_ZONE_BEGIN(var, name) ((void)(name))
+#define PROFILE_ZONE_END(var) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)(name))
+#define PROFILE_WRITE_TRACE(path) ((void)(path), false)
+
+#endif
+
+#endif
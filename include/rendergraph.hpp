@@ -0,0 +1,195 @@
+#ifndef KRISVERS_VKHELLOWORLD_RENDERGRAPH_HPP
+#define KRISVERS_VKHELLOWORLD_RENDERGRAPH_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <functional>
+#include <vector>
+
+// A frame described as passes that declare how they touch images and buffers, from which compile() works out
+// everything that used to be written by hand:
+//  - passes that contribute nothing to an output or a side effect are culled, per version of a resource, so a pass
+//    whose result is completely overwritten before anyone reads it goes too;
+//  - transient images are created with the union of the usages their accesses need and placed in memory blocks
+//    shared by images whose lifetimes don't overlap, the first access after a swap starts from UNDEFINED and waits
+//    for the previous tenant's last access;
+//  - before each pass one vkCmdPipelineBarrier carries every layout transition and the memory dependencies for
+//    read after write, write after write and, as execution dependencies only, write after read. Reads of a resource
+//    already in the right layout and made visible to the reading stages add nothing;
+//  - graphics passes get a render pass and framebuffer for their declared attachments, which stay in the layout the
+//    barrier put them in, so the render pass needs no subpass dependencies.
+//
+// Everything is recorded on one queue. Imported resources start in the layout and after the stages and writes given
+// on import and are left in their final layout, visible to the stages given there. A frame whose render passes the
+// graph doesn't own, the swapchain's, runs one graph per stretch between them and lets the imports' final states
+// carry the dependencies into the render pass.
+struct RenderGraph {
+    static constexpr u32 INVALID = ~0u;
+
+    // what a pass does with a resource, each maps to fixed stages, access flags and, for images, a layout
+    enum Access : u32 {
+        ACCESS_COLOR_ATTACHMENT = 0,
+        ACCESS_DEPTH_ATTACHMENT,
+        ACCESS_DEPTH_READ,
+        ACCESS_SAMPLED_FRAGMENT,
+        ACCESS_SAMPLED_COMPUTE,
+        ACCESS_STORAGE_READ_COMPUTE,
+        ACCESS_STORAGE_WRITE_COMPUTE,
+        ACCESS_TRANSFER_READ,
+        ACCESS_TRANSFER_WRITE,
+        ACCESS_INDIRECT_READ,
+        ACCESS_VERTEX_READ,
+        ACCESS_COUNT,
+    };
+
+    enum PassType : u32 {
+        PASS_GRAPHICS = 0,
+        PASS_COMPUTE = 1,
+        PASS_TRANSFER = 2,
+    };
+
+    struct Image {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {};
+        VkImageAspectFlags aspect = 0;
+
+        bool imported = false;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initialStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        VkAccessFlags initialAccess = 0;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags finalStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        VkAccessFlags finalAccess = 0;
+
+        // transient only: usage gathered from the accesses, the memory block and the live pass range
+        VkImageUsageFlags usage = 0;
+        u32 block = INVALID;
+        u32 firstPass = INVALID;
+        u32 lastPass = INVALID;
+    };
+
+    struct Buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkPipelineStageFlags finalStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        VkAccessFlags finalAccess = 0;
+    };
+
+    struct Use {
+        u32 resource;
+        bool image;
+        Access access;
+        bool write;
+    };
+
+    struct Attachment {
+        u32 image = INVALID;
+        VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        VkClearValue clear = {};
+    };
+
+    struct Pass {
+        const char* name;
+        PassType type;
+        std::function<void(VkCommandBuffer)> execute;
+        std::vector<Use> uses;
+        std::vector<Attachment> colors;
+        Attachment depth;
+        bool sideEffects = false;
+
+        bool live = false;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent = {};
+
+        // filled by compile()
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        VkMemoryBarrier memoryBarrier = {};
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+    };
+
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        u32 memoryTypeBits = ~0u;
+        // the images placed here, in placement order, their live pass ranges don't overlap
+        std::vector<u32> images;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+
+    std::vector<Image> images;
+    std::vector<Buffer> buffers;
+    std::vector<Pass> passes;
+    std::vector<u32> outputImages;
+    std::vector<u32> outputBuffers;
+    std::vector<Block> blocks;
+    // the barrier that leaves imported resources in their final layout, after the last pass
+    VkPipelineStageFlags finalSrcStages = 0;
+    VkPipelineStageFlags finalDstStages = 0;
+    VkMemoryBarrier finalMemoryBarrier = {};
+    std::vector<VkImageMemoryBarrier> finalImageBarriers;
+
+    // statistics of the last compile()
+    u32 culledPasses = 0;
+    u32 barrierCount = 0;
+    VkDeviceSize transientBytes = 0;
+    VkDeviceSize unaliasedTransientBytes = 0;
+
+    RenderGraph() = default;
+    RenderGraph(RenderGraph const&) = delete;
+    RenderGraph& operator=(RenderGraph const&) = delete;
+    ~RenderGraph() {
+        cleanup();
+    }
+
+    void init(VkDevice device, VkPhysicalDevice physicalDevice);
+    // destroys what compile() created and forgets every pass and resource
+    void cleanup();
+
+    // initialAccess are the writes before the graph that its first use has to see, e.g. an attachment's
+    u32 importImage(VkImage image, VkImageView view, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect, VkImageLayout initialLayout, VkPipelineStageFlags initialStages, VkAccessFlags initialAccess, VkImageLayout finalLayout, VkPipelineStageFlags finalStages, VkAccessFlags finalAccess);
+    u32 importBuffer(VkBuffer buffer, VkPipelineStageFlags finalStages, VkAccessFlags finalAccess);
+    // created by compile() if any live pass uses it, contents don't survive from one execute() to the next
+    u32 createImage(VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect);
+
+    // the graph keeps passes that lead to these, imported resources are usually outputs
+    void markOutput(u32 image);
+    void markBufferOutput(u32 buffer);
+
+    u32 addPass(const char* name, PassType type, std::function<void(VkCommandBuffer)> execute);
+    // kept even when nothing it writes is read, e.g. it writes memory the graph doesn't know about
+    void setSideEffects(u32 pass);
+
+    void readImage(u32 pass, u32 image, Access access);
+    void writeImage(u32 pass, u32 image, Access access);
+    void readBuffer(u32 pass, u32 buffer, Access access);
+    void writeBuffer(u32 pass, u32 buffer, Access access);
+
+    // graphics passes only, a LOAD op also counts as a read of the previous contents
+    void colorAttachment(u32 pass, u32 image, VkAttachmentLoadOp loadOp, VkClearColorValue clear = {});
+    void depthAttachment(u32 pass, u32 image, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clear = { 1.0f, 0 });
+
+    bool compile();
+    // outside of a render pass, graphics passes run inside theirs and must not begin another
+    void execute(VkCommandBuffer commandBuffer) const;
+
+    VkImage image(u32 image) const {
+        return images[image].image;
+    }
+
+    VkImageView view(u32 image) const {
+        return images[image].view;
+    }
+
+private:
+    void destroyCompiled();
+    bool createTransientImage(Image& image);
+    bool createRenderPass(Pass& pass);
+};
+
+#endif
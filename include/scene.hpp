@@ -0,0 +1,30 @@
+#ifndef KRISVERS_VKHELLOWORLD_SCENE_HPP
+#define KRISVERS_VKHELLOWORLD_SCENE_HPP
+
+#include <types.hpp>
+#include <linmath.h>
+#include <lod.hpp>
+
+#include <vector>
+
+// One indexed draw out of the shared mesh buffer. center is in model space and only used for sorting and picking
+// a level of detail. With lods set, indexCount and firstIndex are whichever level selectDrawLods() last picked.
+struct DrawItem {
+    u32 indexCount;
+    u32 firstIndex;
+    s32 vertexOffset;
+    f32 center[3];
+    LodChain const* lods = nullptr;
+};
+
+// Orders opaque draws nearest first so the depth test rejects hidden fragments before they are shaded.
+// Distance is taken from the eye in view space, so it does not depend on the projection or depth convention.
+// Returns true if the order changed, i.e. anything recorded from the old order is stale.
+bool sortFrontToBack(std::vector<DrawItem>& draws, mat4x4 modelView);
+
+// Points every draw that has a LodChain at the level selectLods() picks for it from `eye` (model space), draws of the
+// same chain are selected as one batch. Returns true if any draw changed level, adds the triangles of those draws to
+// `triangles` when given.
+bool selectDrawLods(std::vector<DrawItem>& draws, f32 const eye[3], f32 projectionScale, f32 thresholdPixels, u64* triangles = nullptr);
+
+#endif
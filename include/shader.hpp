@@ -0,0 +1,9 @@
+#ifndef KRISVERS_VKHELLOWORLD_SHADER_HPP
+#define KRISVERS_VKHELLOWORLD_SHADER_HPP
+
+#include <vulkan/vulkan.h>
+
+// Loads a SPIR-V binary produced by assets/compile.sh. Returns false if the file is missing or rejected.
+bool loadShaderModule(VkDevice device, const char* path, VkShaderModule* module);
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef KRISVERS_VKHELLOWORLD_SPRITES_HPP
+#define KRISVERS_VKHELLOWORLD_SPRITES_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <descriptors.hpp>
+
+#include <vector>
+
+// Skyline bottom-left rectangle packer. The skyline is the top edge of everything placed so far as a list of
+// horizontal segments; a rectangle goes where its bottom would be lowest, then leftmost, and raises the skyline
+// under it. Space below an overhang is never reused, which costs a little density for a packer that is linear in
+// the skyline's length.
+struct SkylinePacker {
+    struct Segment {
+        u32 x;
+        u32 y;
+        u32 width;
+    };
+
+    u32 width = 0;
+    u32 height = 0;
+    std::vector<Segment> skyline;
+
+    void init(u32 width, u32 height);
+    bool pack(u32 rectWidth, u32 rectHeight, u32* x, u32* y);
+};
+
+// Where a texture ended up in a SpriteBatch's atlas, uv is u0, v0, u1, v1 of the page as 16 bit unorms, the way
+// sprites store them.
+struct AtlasRegion {
+    u32 page = ~0u;
+    u16 uv[4] = {};
+    u32 width = 0;
+    u32 height = 0;
+
+    bool isValid() const {
+        return page != ~0u;
+    }
+};
+
+// Matches the per-instance attributes of assets/sprite.vert: a rectangle in framebuffer pixels, its uv rectangle
+// as 16 bit unorms and an RGBA8 tint.
+struct SpriteInstance {
+    f32 rect[4];
+    u16 uv[4];
+    u32 color;
+};
+
+// Draws textured quads in submission order, one instance of a four vertex strip per sprite. Textures are packed
+// into atlas pages by a SkylinePacker, each page is one image with one descriptor set. Sprites are appended to the
+// current frame's persistently mapped instance stream, and a new draw only starts where the blend mode or the atlas
+// page differs from the previous sprite's, so the draws issued are the fewest the submission order allows.
+//
+// One stream per frame in flight, begin() must only be called for a frame once its fence has signalled.
+// New textures live on the CPU until recordAtlasUploads(), whose staging memory is freed by finishAtlasUploads()
+// once that command buffer has completed.
+//
+// Pages are streamed against the MemoryBudget. A page that would go over it first evicts the pages drawn least
+// recently, their pixels stay on the CPU; when nothing can go, a new texture is downsampled until it fits into the
+// pages there are. Sprites on an evicted page are skipped, drawing one brings the page back with the next
+// recordAtlasUploads().
+struct SpriteBatch {
+    enum Blend : u32 {
+        BLEND_ALPHA = 0,
+        BLEND_ADDITIVE = 1,
+        BLEND_COUNT = 2,
+    };
+
+    static constexpr u32 PADDING = 1;
+
+    struct Page {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        SkylinePacker packer;
+        std::vector<u8> pixels;
+        bool dirty = false;
+        bool uploaded = false;
+        // frameNumber of the last frame that drew from it
+        u64 lastUsed = 0;
+
+        bool isResident() const {
+            return image != VK_NULL_HANDLE;
+        }
+    };
+
+    struct Frame {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        SpriteInstance* sprites = nullptr;
+    };
+
+    struct Run {
+        Blend blend;
+        u32 page;
+        u32 firstSprite;
+        u32 spriteCount;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipelines[BLEND_COUNT] = {};
+    VkSampler sampler = VK_NULL_HANDLE;
+    DescriptorAllocator descriptorAllocator;
+
+    u32 pageSize = 0;
+    std::vector<Page> pages;
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+
+    u32 maxSprites = 0;
+    std::vector<Frame> frames;
+    u32 currentFrame = 0;
+    // counts begin() calls
+    u64 frameNumber = 0;
+    u32 spriteCount = 0;
+    std::vector<Run> runs;
+
+    u32 evictions = 0;
+    u32 downsampledTextures = 0;
+
+    SpriteBatch() = default;
+    SpriteBatch(SpriteBatch const&) = delete;
+    SpriteBatch& operator=(SpriteBatch const&) = delete;
+    ~SpriteBatch() {
+        cleanup();
+    }
+
+    // modules are assets/sprite.vert and assets/sprite.frag, the pipelines are for subpass 0 of renderPass and
+    // ignore its depth attachment
+    bool create(VkDevice device, VkPhysicalDevice physicalDevice, VkRenderPass renderPass, VkShaderModule vertexModule, VkShaderModule fragmentModule, u32 maxSprites, u32 frameCount, u32 pageSize);
+    void cleanup();
+
+    // rgba holds width * height RGBA8 texels. Opens a new page when the current ones are full, downsamples when the
+    // budget has no room for one. An invalid region means the texture is larger than a page or there was no room
+    // even for a single texel.
+    AtlasRegion addTexture(u8 const* rgba, u32 width, u32 height);
+
+    // outside of a render pass, copies every page changed since the last call and leaves them ready for sampling
+    bool recordAtlasUploads(VkCommandBuffer commandBuffer);
+    void finishAtlasUploads();
+
+    void begin(u32 frame);
+
+    // x, y, width and height in framebuffer pixels. false once the frame's stream is full, for an invalid region
+    // and for one on an evicted page
+    bool draw(AtlasRegion const& region, f32 x, f32 y, f32 width, f32 height, u32 color = 0xffffffff, Blend blend = BLEND_ALPHA) {
+        if (spriteCount == maxSprites || !region.isValid()) {
+            return false;
+        }
+        if (runs.empty() || runs.back().blend != blend || runs.back().page != region.page) {
+            if (!use(pages[region.page])) {
+                return false;
+            }
+            runs.push_back({ blend, region.page, spriteCount, 0 });
+        }
+        ++runs.back().spriteCount;
+
+        SpriteInstance& sprite = frames[currentFrame].sprites[spriteCount++];
+        sprite.rect[0] = x;
+        sprite.rect[1] = y;
+        sprite.rect[2] = width;
+        sprite.rect[3] = height;
+        sprite.uv[0] = region.uv[0];
+        sprite.uv[1] = region.uv[1];
+        sprite.uv[2] = region.uv[2];
+        sprite.uv[3] = region.uv[3];
+        sprite.color = color;
+        return true;
+    }
+
+    // inside a render pass of the one the batch was created for, after the viewport is set; pixels map through the
+    // same viewport, flipped or not
+    void record(VkCommandBuffer commandBuffer, VkViewport const& viewport) const;
+
+    u32 drawCount() const {
+        return static_cast<u32>(runs.size());
+    }
+
+private:
+    bool createPage();
+    // the page's image, memory and view, making room under the budget first
+    bool makeResident(Page& page);
+    bool reserve(VkMemoryRequirements const& requirements);
+    void evict(Page& page);
+
+    // an evicted page is wanted back, its sprites wait until it is
+    bool use(Page& page) {
+        page.lastUsed = frameNumber;
+        if (!page.isResident()) {
+            page.dirty = true;
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef KRISVERS_VKHELLOWORLD_STARTUP_HPP
+#define KRISVERS_VKHELLOWORLD_STARTUP_HPP
+
+#include <types.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A handful of worker threads for the parts of startup that don't depend on each other. main() submits a step as
+// soon as everything it reads exists and waits on it right before the first thing that needs its result, so the
+// dependency graph is the order of submit() and wait() calls rather than a separate declaration.
+//
+// Tasks run the callable they were given and nothing else: they must not throw and must not touch the main thread's
+// cleanup scope, results and failures go into variables the submitter reads after wait(). Anything a task captures
+// by reference has to outlive the wait, on every way out of main().
+struct TaskPool {
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        const char* name;
+        std::function<void()> run;
+        bool done = false;
+        // on the pool's clock, for the startup report
+        Clock::time_point start;
+        Clock::time_point end;
+        u32 worker = 0;
+    };
+
+    std::vector<std::thread> workers;
+    // a deque so a running task's entry stays put while others are submitted
+    std::deque<Task> tasks;
+    std::deque<u32> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    bool stopping = false;
+
+    TaskPool() = default;
+    TaskPool(TaskPool const&) = delete;
+    TaskPool& operator=(TaskPool const&) = delete;
+    ~TaskPool() {
+        cleanup();
+    }
+
+    // 0 threads runs every task inline in submit()
+    void create(u32 threadCount);
+    // runs what is still queued, then joins the workers
+    void cleanup();
+
+    u32 submit(const char* name, std::function<void()> run);
+    void wait(u32 task);
+
+private:
+    void workerLoop(u32 worker);
+    void runTask(u32 task, u32 worker);
+};
+
+// Wall time of each step of startup on the main thread, in order, next to when the pool's tasks ran. A step that
+// waits on a task shows how much of it the main thread didn't manage to hide.
+struct StartupReport {
+    using Clock = std::chrono::steady_clock;
+
+    struct Step {
+        const char* name;
+        Clock::time_point end;
+    };
+
+    Clock::time_point origin = Clock::now();
+    std::vector<Step> steps;
+
+    // closes the step that began where the previous one ended
+    void step(const char* name) {
+        steps.push_back({ name, Clock::now() });
+    }
+
+    void print(TaskPool& pool) const;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef KRISVERS_VKHELLOWORLD_TIMELINE_HPP
+#define KRISVERS_VKHELLOWORLD_TIMELINE_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+#include <caps.hpp>
+
+#include <initializer_list>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Counts the submits to one queue: every submit() signals the next value, and anything that has to know a submit
+// finished keeps that value instead of a fence. With timeline semaphores (core 1.2 or VK_KHR_timeline_semaphore)
+// the value is signalled on a timeline semaphore the CPU waits on and other queues' submits wait on directly.
+// Without them each submit gets a fence from a small pool, recycled once its value is reached, and waits across
+// queues have to go through binary semaphores passed as waits with value 0.
+//
+// Values only ever grow, so a frame slot remembers the value of its last submit and waiting for that is the same
+// as waiting for the slot's fence, without one fence per slot to create and reset.
+struct QueueTimeline {
+    struct Wait {
+        VkSemaphore semaphore;
+        // 0 for a binary semaphore
+        u64 value;
+        VkPipelineStageFlags stages;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+
+    bool timeline = false;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    PFN_vkWaitSemaphores waitSemaphores = nullptr;
+    PFN_vkGetSemaphoreCounterValue getCounterValue = nullptr;
+
+    // fence fallback, pending in submit order
+    std::vector<std::pair<u64, VkFence>> pendingFences;
+    std::vector<VkFence> freeFences;
+
+    u64 submitted = 0;
+    u64 completed = 0;
+
+    QueueTimeline() = default;
+    QueueTimeline(QueueTimeline const&) = delete;
+    QueueTimeline& operator=(QueueTimeline const&) = delete;
+    ~QueueTimeline() {
+        cleanup();
+    }
+
+    // uses a timeline semaphore when caps.timelineSemaphore was enabled on the device, fences otherwise
+    bool create(VkDevice device, DeviceCaps const& caps, VkQueue queue);
+    // only once nothing submitted through it is pending
+    void cleanup();
+
+    // returns the value the submit signals once done, 0 if it failed. signalSemaphore is an extra binary semaphore,
+    // for presentation or for a fence fallback wait on another queue.
+    u64 submit(u32 commandBufferCount, VkCommandBuffer const* commandBuffers, std::initializer_list<Wait> waits = {}, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+
+    // what another timeline queue waits on for this value, only valid with timeline semaphores
+    Wait waitFor(u64 value, VkPipelineStageFlags stages) const {
+        return { semaphore, value, stages };
+    }
+
+    bool wait(u64 value, u64 timeout = std::numeric_limits<u64>::max());
+    bool isComplete(u64 value);
+
+    // every submit so far
+    bool waitIdle() {
+        return wait(submitted);
+    }
+
+private:
+    void retireFences();
+};
+
+#endif
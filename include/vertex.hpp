@@ -0,0 +1,65 @@
+#ifndef KRISVERS_VKHELLOWORLD_VERTEX_HPP
+#define KRISVERS_VKHELLOWORLD_VERTEX_HPP
+
+#include <vulkan/vulkan.h>
+#include <types.hpp>
+
+#include <vector>
+
+// Source vertex as meshes are authored, every VertexFormat is encoded from this.
+struct Vertex {
+    float x, y, z;
+    float r, g, b;
+    float u, v;
+};
+
+// Matches the MeshDecode push constant block of the vertex shaders: position = attribute * scale + bias.
+struct VertexDecode {
+    f32 scale[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+    f32 bias[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// How each attribute is stored in the vertex buffer. Only formats Vulkan requires for vertex input are used,
+// 16 bit positions are padded to four components since three component 16 bit formats are optional.
+//
+//   position  FLOAT32 R32G32B32_SFLOAT (12), SNORM16 R16G16B16A16_SNORM (8) in the mesh's bounds, see VertexDecode
+//   color     FLOAT32 R32G32B32_SFLOAT (12), UNORM8 R8G8B8A8_UNORM (4)
+//   uv        FLOAT32 R32G32_SFLOAT (8), FLOAT16 R16G16_SFLOAT (4)
+//   normal    NONE, FLOAT32 R32G32B32_SFLOAT (12), OCTAHEDRAL R16G16_SNORM (4), location 5
+//
+// full() is byte for byte the layout of Vertex, compact() halves it to 16 bytes.
+struct VertexFormat {
+    enum Position : u32 { POSITION_FLOAT32, POSITION_SNORM16 };
+    enum Color : u32 { COLOR_FLOAT32, COLOR_UNORM8 };
+    enum Uv : u32 { UV_FLOAT32, UV_FLOAT16 };
+    enum Normal : u32 { NORMAL_NONE, NORMAL_FLOAT32, NORMAL_OCTAHEDRAL };
+
+    static constexpr u32 MAX_ATTRIBUTES = 4;
+
+    Position position = POSITION_FLOAT32;
+    Color color = COLOR_FLOAT32;
+    Uv uv = UV_FLOAT32;
+    Normal normal = NORMAL_NONE;
+
+    static VertexFormat full() {
+        return {};
+    }
+
+    static VertexFormat compact() {
+        return { POSITION_SNORM16, COLOR_UNORM8, UV_FLOAT16, NORMAL_NONE };
+    }
+
+    u32 stride() const;
+
+    // writes up to MAX_ATTRIBUTES descriptions for `binding` at locations 0 (position), 1 (color), 2 (uv)
+    // and 5 (normal), returns how many
+    u32 attributes(u32 binding, VkVertexInputAttributeDescription* descriptions) const;
+};
+
+// Encodes `count` vertices into `out` as `format`, normals is optional with three floats per vertex and stays
+// unused when the format has none. The returned decode maps the stored positions back to model space.
+VertexDecode encodeVertices(VertexFormat const& format, Vertex const* vertices, f32 const* normals, u32 count, std::vector<u8>& out);
+
+u16 floatToHalf(f32 value);
+
+#endif
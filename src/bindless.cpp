@@ -0,0 +1,131 @@
+#include <bindless.hpp>
+#include <hostalloc.hpp>
+
+#include <algorithm>
+
+bool TextureTable::create(u32 maxTextures) {
+    capacity = std::min(maxTextures, MAX_TEXTURES);
+    count = 0;
+    freeIndices.clear();
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = capacity;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &layout) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &pool) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo = {};
+    variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    variableCountInfo.descriptorSetCount = 1;
+    variableCountInfo.pDescriptorCounts = &capacity;
+
+    VkDescriptorSetAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.pNext = &variableCountInfo;
+    allocateInfo.descriptorPool = pool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &layout;
+
+    if (vkAllocateDescriptorSets(device, &allocateInfo, &set) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+
+    return true;
+}
+
+void TextureTable::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    if (pool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, pool, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+        pool = VK_NULL_HANDLE;
+    }
+
+    if (layout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, layout, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+        layout = VK_NULL_HANDLE;
+    }
+
+    set = VK_NULL_HANDLE;
+    count = 0;
+    freeIndices.clear();
+}
+
+u32 TextureTable::add(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout) {
+    u32 index;
+    if (!freeIndices.empty()) {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    } else if (count < capacity) {
+        index = count++;
+    } else {
+        return INVALID_INDEX;
+    }
+
+    write(index, imageView, sampler, imageLayout);
+    return index;
+}
+
+void TextureTable::write(u32 index, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout) {
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = imageLayout;
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = set;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = index;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+}
+
+void TextureTable::remove(u32 index) {
+    if (index >= count) {
+        return;
+    }
+
+    // partially bound: a stale slot is fine as long as no shader indexes it
+    freeIndices.push_back(index);
+}
@@ -0,0 +1,159 @@
+#include <budget.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+const char* const CATEGORY_NAMES[MemoryBudget::CATEGORY_COUNT] = { "textures", "meshes", "uniforms", "staging", "targets", "other" };
+
+f64 mib(VkDeviceSize bytes) {
+    return static_cast<f64>(bytes) / (1024.0 * 1024.0);
+}
+
+}
+
+MemoryBudget& MemoryBudget::instance() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+void MemoryBudget::init(VkInstance instance, VkPhysicalDevice device, DeviceCaps const& caps, VkDeviceSize budgetCap) {
+    physicalDevice = device;
+    cap = budgetCap;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    // the extension needs the properties2 query, which caps.query() only sets memoryBudget with
+    extension = caps.memoryBudget;
+    if (extension) {
+        const char* name = caps.apiVersion >= VK_API_VERSION_1_1 ? "vkGetPhysicalDeviceMemoryProperties2" : "vkGetPhysicalDeviceMemoryProperties2KHR";
+        getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2>(vkGetInstanceProcAddr(instance, name));
+        extension = getMemoryProperties2 != nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (u32 i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+            heaps[i].size = memoryProperties.memoryHeaps[i].size;
+            heaps[i].flags = memoryProperties.memoryHeaps[i].flags;
+        }
+    }
+    update();
+}
+
+void MemoryBudget::update() {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (extension) {
+        VkPhysicalDeviceMemoryProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties2.pNext = &budgetProperties;
+        getMemoryProperties2(physicalDevice, &properties2);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (u32 i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+        Heap& heap = heaps[i];
+        if (extension) {
+            heap.budget = budgetProperties.heapBudget[i];
+            heap.reportedUsage = budgetProperties.heapUsage[i];
+            heap.trackedAtUpdate = heap.tracked;
+        } else {
+            heap.budget = static_cast<VkDeviceSize>(static_cast<f64>(heap.size) * FALLBACK_SHARE);
+        }
+        if (cap != 0 && (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+            heap.budget = std::min(heap.budget, cap);
+        }
+    }
+}
+
+VkDeviceSize MemoryBudget::usageLocked(Heap const& heap) const {
+    // what the driver said plus what came and went since; unsigned wrap cancels out as long as the total can't go
+    // below zero, which it can't with our own allocations part of the driver's figure
+    return heap.reportedUsage + heap.tracked - heap.trackedAtUpdate;
+}
+
+VkDeviceSize MemoryBudget::usage(u32 heap) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usageLocked(heaps[heap]);
+}
+
+bool MemoryBudget::fits(u32 heap, VkDeviceSize size) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Heap const& h = heaps[heap];
+    if (h.budget == 0) {
+        return true;
+    }
+    return static_cast<f64>(usageLocked(h) + size) <= static_cast<f64>(h.budget) * SOFT_LIMIT;
+}
+
+void MemoryBudget::record(VkDeviceMemory memory, u32 memoryType, VkDeviceSize size, Category category) {
+    u32 heapIndex = memoryProperties.memoryTypes[memoryType].heapIndex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Heap& heap = heaps[heapIndex];
+    bool wasUnder = heap.budget == 0 || usageLocked(heap) <= heap.budget;
+    heap.tracked += size;
+    heap.categories[category] += size;
+    heap.peak = std::max(heap.peak, heap.tracked);
+    allocations[memory] = { size, heapIndex, category };
+
+    if (wasUnder && heap.budget != 0 && usageLocked(heap) > heap.budget) {
+        ++overBudget;
+        std::cout << "Memory heap " << heapIndex << " went over its budget with " << mib(size) << " MiB of " << CATEGORY_NAMES[category] << ", "
+                  << mib(usageLocked(heap)) << " of " << mib(heap.budget) << " MiB in use\n";
+    }
+}
+
+void MemoryBudget::forget(VkDeviceMemory memory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = allocations.find(memory);
+    if (it == allocations.end()) {
+        return;
+    }
+
+    Heap& heap = heaps[it->second.heap];
+    heap.tracked -= it->second.size;
+    heap.categories[it->second.category] -= it->second.size;
+    allocations.erase(it);
+}
+
+void MemoryBudget::failed(u32 memoryType, VkDeviceSize size, Category category, VkResult result) {
+    u32 heapIndex = memoryProperties.memoryTypes[memoryType].heapIndex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++failures;
+    std::cout << "Allocating " << mib(size) << " MiB of " << CATEGORY_NAMES[category] << " from memory heap " << heapIndex << " failed ("
+              << (result == VK_ERROR_OUT_OF_DEVICE_MEMORY ? "out of device memory" : result == VK_ERROR_OUT_OF_HOST_MEMORY ? "out of host memory" : "error")
+              << "), " << mib(usageLocked(heaps[heapIndex])) << " of " << mib(heaps[heapIndex].budget) << " MiB in use\n";
+}
+
+const char* MemoryBudget::categoryName(Category category) {
+    return CATEGORY_NAMES[category];
+}
+
+void MemoryBudget::print() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout << std::fixed << std::setprecision(1);
+    for (u32 i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+        Heap const& heap = heaps[i];
+        if (heap.tracked == 0 && heap.peak == 0) {
+            continue;
+        }
+
+        std::cout << "    memory heap " << i << (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? " (device local): " : ": ") << mib(usageLocked(heap))
+                  << " of " << mib(heap.budget) << " MiB budget" << (extension ? "" : " (estimated)") << ", ours " << mib(heap.tracked)
+                  << " MiB, peak " << mib(heap.peak) << " MiB:";
+        for (u32 c = 0; c < CATEGORY_COUNT; ++c) {
+            if (heap.categories[c] > 0) {
+                std::cout << " " << CATEGORY_NAMES[c] << " " << mib(heap.categories[c]);
+            }
+        }
+        std::cout << "\n";
+    }
+    if (overBudget > 0 || failures > 0) {
+        std::cout << "    memory: " << overBudget << " times over budget, " << failures << " failed allocations\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+}
@@ -0,0 +1,165 @@
+#include <caps.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+bool DeviceCaps::hasExtension(const char* name) const {
+    for (VkExtensionProperties const& e : extensions) {
+        if (strcmp(e.extensionName, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DeviceCaps::query(VkInstance instance, VkPhysicalDevice physicalDevice, u32 instanceApiVersion) {
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    apiVersion = std::min(props.apiVersion, instanceApiVersion);
+    timestampPeriod = props.limits.timestampComputeAndGraphics ? props.limits.timestampPeriod : 0.0f;
+
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    pipelineStatistics = features.pipelineStatisticsQuery;
+    multiDrawIndirect = features.multiDrawIndirect;
+    drawIndirectFirstInstance = features.drawIndirectFirstInstance;
+    maxDrawIndirectCount = props.limits.maxDrawIndirectCount;
+
+    u32 count = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, nullptr);
+    extensions.resize(count);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, extensions.data());
+
+    descriptorUpdateTemplate = apiVersion >= VK_API_VERSION_1_1 || hasExtension(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    // core 1.2 gates this behind a Vulkan12Features bit that can't share a chain with the descriptor indexing struct,
+    // the extension is still exposed alongside 1.2 on the drivers that matter
+    drawIndirectCount = hasExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+    // core in 1.1, otherwise only reachable through VK_KHR_get_physical_device_properties2 on the instance
+    PFN_vkGetPhysicalDeviceFeatures2 getFeatures2;
+    PFN_vkGetPhysicalDeviceProperties2 getProperties2;
+    if (apiVersion >= VK_API_VERSION_1_1) {
+        getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2"));
+        getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2"));
+    } else {
+        getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+        getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
+    }
+
+    if (getFeatures2 == nullptr || getProperties2 == nullptr) {
+        return;
+    }
+
+    // its numbers are read through vkGetPhysicalDeviceMemoryProperties2, which comes with the two above
+    memoryBudget = hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    bool descriptorIndexingAvailable = apiVersion >= VK_API_VERSION_1_2 || (hasExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) && hasExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME));
+
+    descriptorIndexingFeatures = {};
+    descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    bool timelineSemaphoreAvailable = apiVersion >= VK_API_VERSION_1_2 || hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+
+    timelineSemaphoreFeatures = {};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    bool presentWaitAvailable = hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME) && hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+
+    presentIdFeatures = {};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    presentWaitFeatures = {};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties = {};
+    descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceFeatures2 features2 = {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+
+    VkPhysicalDeviceProperties2 properties2 = {};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+
+    if (descriptorIndexingAvailable) {
+        descriptorIndexingFeatures.pNext = features2.pNext;
+        features2.pNext = &descriptorIndexingFeatures;
+
+        descriptorIndexingProperties.pNext = properties2.pNext;
+        properties2.pNext = &descriptorIndexingProperties;
+    }
+
+    if (timelineSemaphoreAvailable) {
+        timelineSemaphoreFeatures.pNext = features2.pNext;
+        features2.pNext = &timelineSemaphoreFeatures;
+    }
+
+    if (presentWaitAvailable) {
+        presentIdFeatures.pNext = features2.pNext;
+        presentWaitFeatures.pNext = &presentIdFeatures;
+        features2.pNext = &presentWaitFeatures;
+    }
+
+    getFeatures2(physicalDevice, &features2);
+    timelineSemaphore = timelineSemaphoreAvailable && timelineSemaphoreFeatures.timelineSemaphore;
+    presentWait = presentWaitAvailable && presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    getProperties2(physicalDevice, &properties2);
+
+    if (descriptorIndexingAvailable) {
+        descriptorIndexing = descriptorIndexingFeatures.runtimeDescriptorArray
+            && descriptorIndexingFeatures.descriptorBindingPartiallyBound
+            && descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount
+            && descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+            && descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing;
+
+        maxBindlessTextures = std::min({
+            descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+            descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+            descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+            descriptorIndexingProperties.maxPerStageUpdateAfterBindResources,
+        });
+    }
+}
+
+void DeviceCaps::enable(std::vector<const char*>& deviceExtensions, const void** pNext) {
+    if (descriptorUpdateTemplate && apiVersion < VK_API_VERSION_1_1) {
+        deviceExtensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    }
+
+    if (drawIndirectCount) {
+        deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    if (descriptorIndexing) {
+        if (apiVersion < VK_API_VERSION_1_2) {
+            deviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+            deviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        }
+
+        descriptorIndexingFeatures.pNext = const_cast<void*>(*pNext);
+        *pNext = &descriptorIndexingFeatures;
+    }
+
+    if (timelineSemaphore) {
+        if (apiVersion < VK_API_VERSION_1_2) {
+            deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        }
+
+        // only timelineSemaphore itself, which query() left set
+        timelineSemaphoreFeatures.pNext = const_cast<void*>(*pNext);
+        *pNext = &timelineSemaphoreFeatures;
+    }
+
+    if (memoryBudget) {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    if (presentWait) {
+        deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+
+        presentIdFeatures.pNext = const_cast<void*>(*pNext);
+        presentWaitFeatures.pNext = &presentIdFeatures;
+        *pNext = &presentWaitFeatures;
+    }
+}
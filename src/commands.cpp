@@ -0,0 +1,38 @@
+#include <commands.hpp>
+
+bool StaticCommandBuffers::resize(u32 frames, u32 images) {
+    invalidate();
+    if (frames == frameCount && images == imageCount) {
+        return true;
+    }
+
+    cleanup();
+
+    VkCommandBufferAllocateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    info.commandPool = pool;
+    info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    info.commandBufferCount = frames * images;
+
+    buffers.resize(frames * images);
+    if (vkAllocateCommandBuffers(device, &info, buffers.data()) != VK_SUCCESS) {
+        buffers.clear();
+        return false;
+    }
+
+    recordedVersions.assign(buffers.size(), 0);
+    frameCount = frames;
+    imageCount = images;
+    return true;
+}
+
+void StaticCommandBuffers::cleanup() {
+    if (!buffers.empty()) {
+        vkFreeCommandBuffers(device, pool, static_cast<u32>(buffers.size()), buffers.data());
+        buffers.clear();
+    }
+
+    recordedVersions.clear();
+    frameCount = 0;
+    imageCount = 0;
+}
@@ -0,0 +1,430 @@
+#include <config.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+const char* const KEY_NAMES[Config::KEY_COUNT] = {
+    "validation",
+    "debug-messenger",
+    "log-severity",
+    "log-rate",
+    "log-mute",
+    "frames-in-flight",
+    "swapchain-images",
+    "present-mode",
+    "target-fps",
+    "async-queues",
+    "latency-stats",
+    "startup-report",
+    "trace",
+    "host-allocator",
+    "memory-stats",
+    "memory-budget",
+    "direct-upload",
+};
+
+bool isBoolean(Config::Key key) {
+    return key == Config::KEY_VALIDATION || key == Config::KEY_DEBUG_MESSENGER || key == Config::KEY_ASYNC_QUEUES
+        || key == Config::KEY_LATENCY_STATS || key == Config::KEY_STARTUP_REPORT || key == Config::KEY_MEMORY_STATS
+        || key == Config::KEY_DIRECT_UPLOAD;
+}
+
+bool parseBoolean(const char* value, bool* out) {
+    const char* truths[] = { "1", "true", "on", "yes" };
+    const char* falsehoods[] = { "0", "false", "off", "no" };
+    for (usize i = 0; i < 4; ++i) {
+        if (strcmp(value, truths[i]) == 0) {
+            *out = true;
+            return true;
+        }
+        if (strcmp(value, falsehoods[i]) == 0) {
+            *out = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseUnsigned(const char* value, int base, u32* out) {
+    char* end;
+    unsigned long v = std::strtoul(value, &end, base);
+    if (end == value || *end != '\0') {
+        return false;
+    }
+    *out = static_cast<u32>(v);
+    return true;
+}
+
+std::string trim(std::string const& s) {
+    usize begin = 0;
+    usize end = s.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(s[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(s[end - 1]))) {
+        --end;
+    }
+    return s.substr(begin, end - begin);
+}
+
+// key = value lines, # starts a comment. *opened tells a missing file from a malformed one.
+bool readFile(const char* path, std::vector<std::pair<std::string, std::string>>& entries, bool* opened) {
+    std::ifstream file(path);
+    *opened = file.is_open();
+    if (!*opened) {
+        return false;
+    }
+
+    std::string line;
+    u32 number = 0;
+    while (std::getline(file, line)) {
+        ++number;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        usize equals = line.find('=');
+        if (equals == std::string::npos) {
+            std::cout << path << ":" << number << ": expected key = value\n";
+            return false;
+        }
+        entries.emplace_back(trim(line.substr(0, equals)), trim(line.substr(equals + 1)));
+    }
+
+    return true;
+}
+
+std::string environmentName(const char* key) {
+    std::string name = "VKHELLOWORLD_";
+    for (const char* c = key; *c != '\0'; ++c) {
+        name += *c == '-' ? '_' : static_cast<char>(std::toupper(static_cast<unsigned char>(*c)));
+    }
+    return name;
+}
+
+// the last of flag and its alias, if any, like the command line's later values override earlier ones
+const char* argumentValue(int argc, char** argv, const char* flag, const char* alias = nullptr) {
+    const char* value = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], flag) == 0 || (alias != nullptr && strcmp(argv[i], alias) == 0)) {
+            value = argv[++i];
+        }
+    }
+    return value;
+}
+
+}
+
+bool Config::load(int argc, char** argv) {
+    const char* path = argumentValue(argc, argv, "--config");
+    bool required = path != nullptr;
+    if (path == nullptr) {
+        path = std::getenv("VKHELLOWORLD_CONFIG");
+        required = path != nullptr;
+    }
+    if (path == nullptr) {
+        path = "vkhelloworld.cfg";
+    }
+
+    std::vector<std::pair<std::string, std::string>> entries;
+    bool opened;
+    if (readFile(path, entries, &opened)) {
+        file = path;
+    } else if (opened || required) {
+        std::cout << "Failed to read config " << path << "\n";
+        return false;
+    }
+
+    const char* name = argumentValue(argc, argv, "--config-profile", "--profile");
+    if (name == nullptr) {
+        name = std::getenv("VKHELLOWORLD_PROFILE");
+    }
+    for (usize i = 0; i < entries.size() && name == nullptr; ++i) {
+        if (entries[i].first == "profile") {
+            name = entries[i].second.c_str();
+        }
+    }
+    if (name == nullptr) {
+#ifdef NDEBUG
+        name = "release";
+#else
+        name = "debug";
+#endif
+    }
+
+    if (!applyProfile(name)) {
+        std::cout << "Unknown profile " << name << ", expected release, profile, debug or serial\n";
+        return false;
+    }
+
+    for (auto const& entry : entries) {
+        if (entry.first == "profile") {
+            continue;
+        }
+
+        const char* const* key = std::find_if(KEY_NAMES, KEY_NAMES + KEY_COUNT, [&](const char* n) {
+            return entry.first == n;
+        });
+        if (key == KEY_NAMES + KEY_COUNT) {
+            std::cout << "Unknown key " << entry.first << " in " << path << "\n";
+            return false;
+        }
+        if (!set(static_cast<Key>(key - KEY_NAMES), entry.second.c_str(), "file")) {
+            return false;
+        }
+    }
+
+    for (u32 key = 0; key < KEY_COUNT; ++key) {
+        const char* env = std::getenv(environmentName(KEY_NAMES[key]).c_str());
+        if (env != nullptr && !set(static_cast<Key>(key), env, "environment")) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Config::parseArgument(int argc, char** argv, int& i, bool* error) {
+    const char* arg = argv[i];
+    if ((strcmp(arg, "--config") == 0 || strcmp(arg, "--config-profile") == 0 || strcmp(arg, "--profile") == 0) && i + 1 < argc) {
+        // already read by load()
+        ++i;
+        return true;
+    }
+
+    if (strncmp(arg, "--", 2) != 0) {
+        return false;
+    }
+
+    bool negated = strncmp(arg, "--no-", 5) == 0;
+    const char* name = negated ? arg + 5 : arg + 2;
+    for (u32 k = 0; k < KEY_COUNT; ++k) {
+        Key key = static_cast<Key>(k);
+        if (strcmp(name, KEY_NAMES[k]) != 0) {
+            continue;
+        }
+
+        if (isBoolean(key)) {
+            *error = !set(key, negated ? "false" : "true", "command line");
+            return true;
+        }
+        if (negated || i + 1 >= argc) {
+            return false;
+        }
+
+        *error = !set(key, argv[++i], "command line");
+        return true;
+    }
+
+    return false;
+}
+
+bool Config::applyProfile(const char* name) {
+    // serial is debug with the frames and queues run one at a time
+    bool serial = strcmp(name, "serial") == 0;
+    bool debug = serial || strcmp(name, "debug") == 0;
+    bool measure = strcmp(name, "profile") == 0;
+    if (!debug && !measure && strcmp(name, "release") != 0) {
+        return false;
+    }
+
+    profile = name;
+    validation = debug;
+    debugMessenger = debug;
+    // with the messenger on in a release build only errors are worth the output
+    logSeverity = debug ? VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT : measure ? VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT : VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    logRate = 10;
+    logMute.clear();
+    // every profile but serial overlaps frames and queues like release, so debug builds exercise those paths too.
+    // serial runs one frame at a time on one queue, a validation message then belongs to the frame that caused it
+    // and nothing overlaps in a capture
+    framesInFlight = serial ? 1 : 2;
+    swapchainImages = 3;
+    // uncapped, so frame times are the renderer's rather than the display's
+    presentMode = measure ? VK_PRESENT_MODE_IMMEDIATE_KHR : VK_PRESENT_MODE_MAX_ENUM_KHR;
+    targetFps = 0.0;
+    asyncQueues = !serial;
+    latencyStats = measure;
+    startupReport = measure;
+    trace.clear();
+    hostAllocation = measure ? HostAllocator::MODE_TRACK : HostAllocator::MODE_OFF;
+    memoryStats = measure;
+    memoryBudget = 0;
+    directUpload = true;
+
+    std::fill(sources, sources + KEY_COUNT, "profile");
+    return true;
+}
+
+bool Config::set(Key key, const char* value, const char* source) {
+    bool valid = true;
+    u32 number = 0;
+    switch (key) {
+        case KEY_VALIDATION:
+            valid = parseBoolean(value, &validation);
+            break;
+        case KEY_DEBUG_MESSENGER:
+            valid = parseBoolean(value, &debugMessenger);
+            break;
+        case KEY_ASYNC_QUEUES:
+            valid = parseBoolean(value, &asyncQueues);
+            break;
+        case KEY_LATENCY_STATS:
+            valid = parseBoolean(value, &latencyStats);
+            break;
+        case KEY_STARTUP_REPORT:
+            valid = parseBoolean(value, &startupReport);
+            break;
+        case KEY_MEMORY_STATS:
+            valid = parseBoolean(value, &memoryStats);
+            break;
+        case KEY_DIRECT_UPLOAD:
+            valid = parseBoolean(value, &directUpload);
+            break;
+        case KEY_LOG_SEVERITY:
+            if (strcmp(value, "verbose") == 0) {
+                logSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+            } else if (strcmp(value, "info") == 0) {
+                logSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+            } else if (strcmp(value, "warning") == 0) {
+                logSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+            } else if (strcmp(value, "error") == 0) {
+                logSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+            } else {
+                valid = false;
+            }
+            break;
+        case KEY_LOG_RATE:
+            valid = parseUnsigned(value, 10, &logRate);
+            break;
+        case KEY_LOG_MUTE: {
+            // comma separated messageIdNumbers as validation prints them, hex with 0x, adds to what is muted already
+            std::stringstream list(value);
+            std::string id;
+            while (valid && std::getline(list, id, ',')) {
+                valid = parseUnsigned(trim(id).c_str(), 0, &number);
+                logMute.push_back(static_cast<s32>(number));
+            }
+            break;
+        }
+        case KEY_FRAMES_IN_FLIGHT:
+            valid = parseUnsigned(value, 10, &number);
+            framesInFlight = std::clamp(number, 1u, 8u);
+            break;
+        case KEY_SWAPCHAIN_IMAGES:
+            valid = parseUnsigned(value, 10, &number);
+            swapchainImages = std::max(number, 1u);
+            break;
+        case KEY_PRESENT_MODE:
+            if (strcmp(value, "auto") == 0) {
+                presentMode = VK_PRESENT_MODE_MAX_ENUM_KHR;
+            } else if (strcmp(value, "fifo") == 0) {
+                presentMode = VK_PRESENT_MODE_FIFO_KHR;
+            } else if (strcmp(value, "fifo-relaxed") == 0) {
+                presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+            } else if (strcmp(value, "mailbox") == 0) {
+                presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+            } else if (strcmp(value, "immediate") == 0) {
+                presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            } else {
+                valid = false;
+            }
+            break;
+        case KEY_TARGET_FPS: {
+            char* end;
+            targetFps = std::strtod(value, &end);
+            valid = end != value && *end == '\0' && targetFps >= 0.0;
+            break;
+        }
+        case KEY_TRACE:
+            trace = value;
+            break;
+        case KEY_HOST_ALLOCATOR:
+            if (strcmp(value, "off") == 0) {
+                hostAllocation = HostAllocator::MODE_OFF;
+            } else if (strcmp(value, "track") == 0) {
+                hostAllocation = HostAllocator::MODE_TRACK;
+            } else if (strcmp(value, "pool") == 0) {
+                hostAllocation = HostAllocator::MODE_POOL;
+            } else {
+                valid = false;
+            }
+            break;
+        case KEY_MEMORY_BUDGET:
+            valid = parseUnsigned(value, 10, &memoryBudget);
+            break;
+        default:
+            valid = false;
+            break;
+    }
+
+    if (!valid) {
+        std::cout << "Invalid " << KEY_NAMES[key] << " \"" << value << "\" from the " << source << "\n";
+        return false;
+    }
+
+    sources[key] = source;
+    return true;
+}
+
+std::string Config::value(Key key) const {
+    switch (key) {
+        case KEY_VALIDATION: return validation ? "true" : "false";
+        case KEY_DEBUG_MESSENGER: return debugMessenger ? "true" : "false";
+        case KEY_ASYNC_QUEUES: return asyncQueues ? "true" : "false";
+        case KEY_LATENCY_STATS: return latencyStats ? "true" : "false";
+        case KEY_STARTUP_REPORT: return startupReport ? "true" : "false";
+        case KEY_MEMORY_STATS: return memoryStats ? "true" : "false";
+        case KEY_DIRECT_UPLOAD: return directUpload ? "true" : "false";
+        case KEY_LOG_SEVERITY: {
+            const char* names[] = { "verbose", "info", "warning", "error" };
+            u32 index = 0;
+            while ((1u << (index * 4)) < static_cast<u32>(logSeverity)) {
+                ++index;
+            }
+            return names[std::min(index, 3u)];
+        }
+        case KEY_LOG_RATE: return std::to_string(logRate);
+        case KEY_LOG_MUTE: {
+            std::stringstream out;
+            for (usize i = 0; i < logMute.size(); ++i) {
+                out << (i > 0 ? "," : "") << "0x" << std::hex << static_cast<u32>(logMute[i]);
+            }
+            return out.str();
+        }
+        case KEY_FRAMES_IN_FLIGHT: return std::to_string(framesInFlight);
+        case KEY_SWAPCHAIN_IMAGES: return std::to_string(swapchainImages);
+        case KEY_PRESENT_MODE: {
+            const char* names[] = { "immediate", "mailbox", "fifo", "fifo-relaxed" };
+            return presentMode == VK_PRESENT_MODE_MAX_ENUM_KHR ? "auto" : names[presentMode];
+        }
+        case KEY_TARGET_FPS: {
+            std::stringstream out;
+            out << targetFps;
+            return out.str();
+        }
+        case KEY_TRACE: return trace;
+        case KEY_HOST_ALLOCATOR: {
+            const char* names[] = { "off", "track", "pool" };
+            return names[hostAllocation];
+        }
+        case KEY_MEMORY_BUDGET: return std::to_string(memoryBudget);
+        default: return "";
+    }
+}
+
+void Config::print() const {
+    std::cout << "Configuration: profile " << profile << ", " << (file.empty() ? std::string("no config file") : "config file " + file) << "\n";
+    for (u32 key = 0; key < KEY_COUNT; ++key) {
+        std::cout << "    " << KEY_NAMES[key] << " = " << value(static_cast<Key>(key)) << " (" << sources[key] << ")\n";
+    }
+}
@@ -0,0 +1,388 @@
+#include <culling.hpp>
+#include <caps.hpp>
+#include <memory.hpp>
+#include <hostalloc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void extractFrustumPlanes(f32 planes[6][4], mat4x4 viewProj) {
+    // linmath is column major, row i of the matrix is viewProj[0..3][i]
+    for (u32 i = 0; i < 4; ++i) {
+        planes[0][i] = viewProj[i][3] + viewProj[i][0];
+        planes[1][i] = viewProj[i][3] - viewProj[i][0];
+        planes[2][i] = viewProj[i][3] + viewProj[i][1];
+        planes[3][i] = viewProj[i][3] - viewProj[i][1];
+        planes[4][i] = viewProj[i][2];
+        planes[5][i] = viewProj[i][3] - viewProj[i][2];
+    }
+
+    for (u32 p = 0; p < 6; ++p) {
+        f32 length = std::sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if (length > 0.0f) {
+            for (u32 i = 0; i < 4; ++i) {
+                planes[p][i] /= length;
+            }
+        }
+    }
+}
+
+bool sphereInFrustum(f32 const planes[6][4], f32 const sphere[4]) {
+    for (u32 p = 0; p < 6; ++p) {
+        if (planes[p][0] * sphere[0] + planes[p][1] * sphere[1] + planes[p][2] * sphere[2] + planes[p][3] < -sphere[3]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+u32 cullObjects(CullUniform const& uniform, CullObject const* objects, VkDrawIndexedIndirectCommand* commands) {
+    u32 drawCount = 0;
+    for (u32 i = 0; i < uniform.objectCount; ++i) {
+        if (!sphereInFrustum(uniform.planes, objects[i].sphere)) {
+            continue;
+        }
+
+        VkDrawIndexedIndirectCommand& command = commands[drawCount++];
+        command.indexCount = objects[i].indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = objects[i].firstIndex;
+        command.vertexOffset = objects[i].vertexOffset;
+        command.firstInstance = i;
+    }
+
+    return drawCount;
+}
+
+bool GpuCuller::create(VkDevice dev, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkShaderModule cullModule, u32 frameCount, u32 maxObjects, std::vector<u32> const& queueFamilies, bool withOcclusion) {
+    device = dev;
+    occlusion = withOcclusion;
+    if (!caps.drawIndirectFirstInstance) {
+        return false;
+    }
+
+    if (caps.drawIndirectCount) {
+        drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+    compact = drawIndexedIndirectCount != nullptr;
+    multiDraw = caps.multiDrawIndirect && caps.maxDrawIndirectCount >= maxObjects;
+
+    // 0 uniform, 1 objects, 2 commands, 3 count, and for occlusion 4 visibility, 5 pyramid
+    const u32 bindingCount = occlusion ? 6 : 4;
+    VkDescriptorSetLayoutBinding bindings[6] = {};
+    for (u32 i = 0; i < bindingCount; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : i == 5 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = bindingCount;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &setLayout) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+
+    // the phase is a push constant so both phases share one pipeline
+    VkPushConstantRange phaseRange = {};
+    phaseRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    phaseRange.offset = 0;
+    phaseRange.size = sizeof(u32);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = occlusion ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = &phaseRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+
+    VkBool32 compactConstant = compact;
+    VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(VkBool32) };
+
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries = &specializationEntry;
+    specializationInfo.dataSize = sizeof(VkBool32);
+    specializationInfo.pData = &compactConstant;
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = cullModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.stage.pSpecializationInfo = &specializationInfo;
+    pipelineInfo.layout = pipelineLayout;
+
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE), &pipeline) != VK_SUCCESS) {
+        pipeline = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    objectCapacity = maxObjects;
+    if (!createBuffer(device, memoryProperties, sizeof(CullObject) * objectCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &objectBuffer, &objectMemory)
+        || vkMapMemory(device, objectMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&objects)) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+
+    // a few bytes per object, written once per frame by the late phase, host visible so setObjects() can clear it
+    if (occlusion
+        && (!createBuffer(device, memoryProperties, sizeof(u32) * objectCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &visibilityBuffer, &visibilityMemory)
+            || vkMapMemory(device, visibilityMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&visibility)) != VK_SUCCESS)) {
+        cleanup();
+        return false;
+    }
+
+    const u32 setsPerFrame = occlusion ? 2 : 1;
+    descriptorAllocator.init(device, frameCount * setsPerFrame, {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, occlusion ? 4.0f : 3.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, occlusion ? 1.0f : 0.0f },
+    });
+
+    // the count is read back for statistics, hence TRANSFER_SRC
+    const VkBufferUsageFlags commandUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    const VkBufferUsageFlags countUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    DescriptorWriter writer(device);
+    frames.resize(frameCount);
+    for (Frame& frame : frames) {
+        if (!createBuffer(device, memoryProperties, sizeof(CullUniform), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_UNIFORMS, queueFamilies, &frame.uniformBuffer, &frame.uniformMemory)
+            || vkMapMemory(device, frame.uniformMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&frame.uniform)) != VK_SUCCESS
+            || !createBuffer(device, memoryProperties, sizeof(VkDrawIndexedIndirectCommand) * objectCapacity, commandUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &frame.commandBuffer, &frame.commandMemory)
+            || !createBuffer(device, memoryProperties, sizeof(u32), countUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &frame.countBuffer, &frame.countMemory)
+            || !descriptorAllocator.allocate(setLayout, &frame.set)) {
+            cleanup();
+            return false;
+        }
+
+        *frame.uniform = {};
+
+        writer.writeBuffer(frame.set, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frame.uniformBuffer, 0, sizeof(CullUniform));
+        writer.writeBuffer(frame.set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, objectBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.set, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frame.commandBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.set, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frame.countBuffer, 0, VK_WHOLE_SIZE);
+
+        if (!occlusion) {
+            continue;
+        }
+
+        if (!createBuffer(device, memoryProperties, sizeof(VkDrawIndexedIndirectCommand) * objectCapacity, commandUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &frame.lateCommandBuffer, &frame.lateCommandMemory)
+            || !createBuffer(device, memoryProperties, sizeof(u32), countUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &frame.lateCountBuffer, &frame.lateCountMemory)
+            || !descriptorAllocator.allocate(setLayout, &frame.lateSet)) {
+            cleanup();
+            return false;
+        }
+
+        writer.writeBuffer(frame.set, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, visibilityBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.lateSet, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frame.uniformBuffer, 0, sizeof(CullUniform));
+        writer.writeBuffer(frame.lateSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, objectBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.lateSet, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frame.lateCommandBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.lateSet, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frame.lateCountBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.lateSet, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, visibilityBuffer, 0, VK_WHOLE_SIZE);
+    }
+    writer.flush();
+
+    return true;
+}
+
+void GpuCuller::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    for (Frame& frame : frames) {
+        vkDestroyBuffer(device, frame.uniformBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.uniformMemory);
+        vkDestroyBuffer(device, frame.commandBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.commandMemory);
+        vkDestroyBuffer(device, frame.countBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.countMemory);
+        vkDestroyBuffer(device, frame.lateCommandBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.lateCommandMemory);
+        vkDestroyBuffer(device, frame.lateCountBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.lateCountMemory);
+    }
+    frames.clear();
+    descriptorAllocator.cleanup();
+
+    vkDestroyBuffer(device, visibilityBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, visibilityMemory);
+    visibilityBuffer = VK_NULL_HANDLE;
+    visibilityMemory = VK_NULL_HANDLE;
+    visibility = nullptr;
+    pyramidLevels = 0;
+
+    vkDestroyBuffer(device, objectBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, objectMemory);
+    objectBuffer = VK_NULL_HANDLE;
+    objectMemory = VK_NULL_HANDLE;
+    objects = nullptr;
+    objectCapacity = 0;
+    objectCount = 0;
+
+    vkDestroyPipeline(device, pipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(device, pipelineLayout, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    vkDestroyDescriptorSetLayout(device, setLayout, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    pipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    setLayout = VK_NULL_HANDLE;
+}
+
+void GpuCuller::setObjects(CullObject const* source, u32 count) {
+    objectCount = std::min(count, objectCapacity);
+    memcpy(objects, source, sizeof(CullObject) * objectCount);
+    if (visibility != nullptr) {
+        memset(visibility, 0, sizeof(u32) * objectCount);
+    }
+
+    for (Frame& frame : frames) {
+        frame.uniform->objectCount = objectCount;
+    }
+}
+
+void GpuCuller::setFrustum(u32 frame, mat4x4 viewProj) {
+    CullUniform* uniform = frames[frame].uniform;
+    extractFrustumPlanes(uniform->planes, viewProj);
+    mat4x4_dup(uniform->viewProj, viewProj);
+}
+
+void GpuCuller::setPyramid(VkImageView pyramidView, VkSampler sampler, u32 levels, VkExtent2D depthExtent, VkViewport const& viewport) {
+    pyramidLevels = levels;
+
+    DescriptorWriter writer(device);
+    for (Frame& frame : frames) {
+        frame.uniform->viewport[0] = viewport.width * 0.5f;
+        frame.uniform->viewport[1] = viewport.height * 0.5f;
+        frame.uniform->viewport[2] = viewport.x + viewport.width * 0.5f;
+        frame.uniform->viewport[3] = viewport.y + viewport.height * 0.5f;
+        frame.uniform->depthWidth = depthExtent.width;
+        frame.uniform->depthHeight = depthExtent.height;
+        frame.uniform->pyramidLevels = levels;
+
+        writer.writeImage(frame.set, 5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, pyramidView, sampler, VK_IMAGE_LAYOUT_GENERAL);
+        writer.writeImage(frame.lateSet, 5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, pyramidView, sampler, VK_IMAGE_LAYOUT_GENERAL);
+    }
+    writer.flush();
+}
+
+void GpuCuller::setOcclusionEnabled(bool enabled) {
+    for (Frame& frame : frames) {
+        frame.uniform->pyramidLevels = enabled ? pyramidLevels : 0;
+    }
+}
+
+void GpuCuller::recordCull(VkCommandBuffer commandBuffer, u32 frame, Phase phase) const {
+    recordDispatch(commandBuffer, frame, phase, true);
+
+    // covers a draw recorded later on the same queue, a semaphore takes care of it across queues
+    VkMemoryBarrier cullBarrier = {};
+    cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+u32 GpuCuller::addCullPass(RenderGraph& graph, u32 frame, Phase phase, u32 pyramid) const {
+    Frame const& f = frames[frame];
+    bool late = phase == LATE;
+
+    u32 commands = graph.importBuffer(late ? f.lateCommandBuffer : f.commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    u32 count = graph.importBuffer(late ? f.lateCountBuffer : f.countBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    graph.markBufferOutput(commands);
+    graph.markBufferOutput(count);
+
+    // the count's clear and its barrier stay inside the pass, the graph only sees the cull's writes
+    u32 pass = graph.addPass(late ? "late cull" : "cull", RenderGraph::PASS_COMPUTE, [this, frame, phase](VkCommandBuffer commandBuffer) {
+        recordDispatch(commandBuffer, frame, phase, false);
+    });
+    graph.writeBuffer(pass, commands, RenderGraph::ACCESS_STORAGE_WRITE_COMPUTE);
+    graph.writeBuffer(pass, count, RenderGraph::ACCESS_STORAGE_WRITE_COMPUTE);
+
+    if (occlusion) {
+        // the early phase's reads are done before anything after the graph writes them, the late phase rewrites
+        // them and leaves them visible to the next frame's early phase
+        u32 flags = graph.importBuffer(visibilityBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+        if (late) {
+            graph.writeBuffer(pass, flags, RenderGraph::ACCESS_STORAGE_WRITE_COMPUTE);
+        } else {
+            graph.readBuffer(pass, flags, RenderGraph::ACCESS_STORAGE_READ_COMPUTE);
+        }
+    }
+    // sampled in GENERAL, which to the barriers is the same as a storage read
+    if (late && pyramid != RenderGraph::INVALID) {
+        graph.readImage(pass, pyramid, RenderGraph::ACCESS_STORAGE_READ_COMPUTE);
+    }
+    return pass;
+}
+
+void GpuCuller::recordDispatch(VkCommandBuffer commandBuffer, u32 frame, Phase phase, bool waitForVisibility) const {
+    Frame const& f = frames[frame];
+    VkBuffer countBuffer = phase == LATE ? f.lateCountBuffer : f.countBuffer;
+    VkDescriptorSet set = phase == LATE ? f.lateSet : f.set;
+
+    vkCmdFillBuffer(commandBuffer, countBuffer, 0, sizeof(u32), 0);
+
+    VkBufferMemoryBarrier clearBarrier = {};
+    clearBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    clearBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    clearBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    clearBarrier.buffer = countBuffer;
+    clearBarrier.offset = 0;
+    clearBarrier.size = VK_WHOLE_SIZE;
+
+    // the visibility flags were last written by the previous late phase
+    VkMemoryBarrier visibilityBarrier = {};
+    visibilityBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    visibilityBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    visibilityBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    if (occlusion && waitForVisibility) {
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &visibilityBarrier, 1, &clearBarrier, 0, nullptr);
+    } else {
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &clearBarrier, 0, nullptr);
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+    if (occlusion) {
+        u32 phaseConstant = phase;
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(u32), &phaseConstant);
+    }
+    vkCmdDispatch(commandBuffer, (objectCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+}
+
+void GpuCuller::recordDraw(VkCommandBuffer commandBuffer, u32 frame, Phase phase) const {
+    Frame const& f = frames[frame];
+    VkBuffer commands = phase == LATE ? f.lateCommandBuffer : f.commandBuffer;
+    VkBuffer countBuffer = phase == LATE ? f.lateCountBuffer : f.countBuffer;
+
+    if (compact) {
+        drawIndexedIndirectCount(commandBuffer, commands, 0, countBuffer, 0, objectCount, sizeof(VkDrawIndexedIndirectCommand));
+    } else if (multiDraw) {
+        vkCmdDrawIndexedIndirect(commandBuffer, commands, 0, objectCount, sizeof(VkDrawIndexedIndirectCommand));
+    } else {
+        for (u32 i = 0; i < objectCount; ++i) {
+            vkCmdDrawIndexedIndirect(commandBuffer, commands, sizeof(VkDrawIndexedIndirectCommand) * i, 1, sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+}
@@ -0,0 +1,196 @@
+#include <debuglog.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+u64 nowMs() {
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+    switch (severity) {
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT: return "verbose";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT: return "info";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: return "warning";
+        default: return "error";
+    }
+}
+
+const char* typeName(VkDebugUtilsMessageTypeFlagsEXT type) {
+    if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) {
+        return "validation";
+    }
+    if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) {
+        return "performance";
+    }
+    return "general";
+}
+
+// copies at most size - 1 characters and terminates, returns whether text had to be cut
+bool copyTruncated(char* destination, usize size, const char* text) {
+    if (text == nullptr) {
+        destination[0] = '\0';
+        return false;
+    }
+
+    usize length = strnlen(text, size);
+    bool truncated = length == size;
+    length = std::min(length, size - 1);
+    memcpy(destination, text, length);
+    destination[length] = '\0';
+    return truncated;
+}
+
+}
+
+DebugLog::DebugLog() : slots(new Slot[CAPACITY]) {
+    for (u32 i = 0; i < CAPACITY; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+void DebugLog::start() {
+    stopping.store(false, std::memory_order_relaxed);
+    writer = std::thread(&DebugLog::writerLoop, this);
+}
+
+void DebugLog::cleanup() {
+    if (writer.joinable()) {
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+    }
+}
+
+VkDebugUtilsMessageSeverityFlagsEXT DebugLog::messengerSeverities() const {
+    // the severity bits are ordered, everything from the minimum up
+    VkDebugUtilsMessageSeverityFlagsEXT all = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT
+        | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    return all & ~(static_cast<VkDebugUtilsMessageSeverityFlagsEXT>(minimumSeverity) - 1);
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL DebugLog::callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* callbackData, void* userData) {
+    DebugLog* log = static_cast<DebugLog*>(userData);
+    log->push(severity, type, callbackData->messageIdNumber, callbackData->pMessageIdName, callbackData->pMessage);
+    // VK_TRUE would make the call that triggered a validation message fail, which is for layer tests only
+    return VK_FALSE;
+}
+
+bool DebugLog::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type, s32 idNumber, const char* idName, const char* text) {
+    if (severity < minimumSeverity || std::find(mutedIds.begin(), mutedIds.end(), idNumber) != mutedIds.end()) {
+        return false;
+    }
+
+    if (!allow(idNumber)) {
+        rateLimited.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    u64 position = tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots[position % CAPACITY];
+        u64 sequence = slot->sequence.load(std::memory_order_acquire);
+        s64 difference = static_cast<s64>(sequence) - static_cast<s64>(position);
+        if (difference == 0) {
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // the writer hasn't read this slot's previous message yet
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    Message& message = slot->message;
+    message.severity = severity;
+    message.type = type;
+    message.idNumber = idNumber;
+    copyTruncated(message.idName, ID_NAME_SIZE, idName);
+    message.truncated = copyTruncated(message.text, MESSAGE_SIZE, text);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool DebugLog::allow(s32 idNumber) {
+    if (perIdPerSecond == 0) {
+        return true;
+    }
+
+    // racing producers may let a message or two more through when a window starts over, close enough for a log
+    RateBucket& bucket = rateBuckets[static_cast<u32>(idNumber) * 2654435761u % RATE_BUCKETS];
+    u64 now = nowMs();
+    u64 windowStart = bucket.windowStartMs.load(std::memory_order_relaxed);
+    if (now - windowStart >= 1000 && bucket.windowStartMs.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+        bucket.count.store(0, std::memory_order_relaxed);
+    }
+
+    return bucket.count.fetch_add(1, std::memory_order_relaxed) < perIdPerSecond;
+}
+
+u32 DebugLog::drain() {
+    std::string out;
+    u32 count = 0;
+    while (true) {
+        Slot& slot = slots[head % CAPACITY];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+            break;
+        }
+
+        Message const& message = slot.message;
+        out += "[";
+        out += typeName(message.type);
+        out += " ";
+        out += severityName(message.severity);
+        out += "] ";
+        if (message.idName[0] != '\0') {
+            out += message.idName;
+            out += ": ";
+        }
+        out += message.text;
+        if (message.truncated) {
+            out += " [truncated]";
+        }
+        out += "\n";
+
+        slot.sequence.store(head + CAPACITY, std::memory_order_release);
+        ++head;
+        ++count;
+    }
+
+    u64 droppedNow = dropped.load(std::memory_order_relaxed);
+    u64 rateLimitedNow = rateLimited.load(std::memory_order_relaxed);
+    // at most once a second, or the report would be the new spam
+    u64 now = nowMs();
+    bool reportDue = now - lastReportMs >= 1000 || stopping.load(std::memory_order_relaxed);
+    if (reportDue && (droppedNow != reportedDropped || rateLimitedNow != reportedRateLimited)) {
+        out += "[debug log] " + std::to_string(droppedNow - reportedDropped) + " messages dropped with the queue full, "
+            + std::to_string(rateLimitedNow - reportedRateLimited) + " rate limited\n";
+        reportedDropped = droppedNow;
+        reportedRateLimited = rateLimitedNow;
+        lastReportMs = now;
+    }
+
+    if (!out.empty()) {
+        std::cout << out << std::flush;
+    }
+    return count;
+}
+
+void DebugLog::writerLoop() {
+    while (!stopping.load(std::memory_order_acquire)) {
+        // no wakeups from the producers, they'd have to take a lock to not lose one
+        if (drain() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    drain();
+}
@@ -0,0 +1,251 @@
+#include <descriptors.hpp>
+#include <caps.hpp>
+#include <hostalloc.hpp>
+
+#include <algorithm>
+
+static bool isBufferDescriptor(VkDescriptorType type) {
+    switch (type) {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void DescriptorWriter::writeBuffer(VkDescriptorSet set, u32 binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    VkDescriptorBufferInfo info = {};
+    info.buffer = buffer;
+    info.offset = offset;
+    info.range = range;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = type;
+    write.pBufferInfo = reinterpret_cast<const VkDescriptorBufferInfo*>(bufferInfos.size());
+
+    bufferInfos.push_back(info);
+    writes.push_back(write);
+}
+
+void DescriptorWriter::writeImage(VkDescriptorSet set, u32 binding, VkDescriptorType type, VkImageView imageView, VkSampler sampler, VkImageLayout layout) {
+    VkDescriptorImageInfo info = {};
+    info.sampler = sampler;
+    info.imageView = imageView;
+    info.imageLayout = layout;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = type;
+    write.pImageInfo = reinterpret_cast<const VkDescriptorImageInfo*>(imageInfos.size());
+
+    imageInfos.push_back(info);
+    writes.push_back(write);
+}
+
+void DescriptorWriter::reserve(usize count) {
+    writes.reserve(count);
+    bufferInfos.reserve(count);
+    imageInfos.reserve(count);
+}
+
+void DescriptorWriter::flush() {
+    if (writes.empty()) {
+        return;
+    }
+
+    // turn the stored indices into real pointers now that the info vectors no longer move
+    for (VkWriteDescriptorSet& write : writes) {
+        if (isBufferDescriptor(write.descriptorType)) {
+            write.pBufferInfo = &bufferInfos[reinterpret_cast<usize>(write.pBufferInfo)];
+        } else {
+            write.pImageInfo = &imageInfos[reinterpret_cast<usize>(write.pImageInfo)];
+        }
+    }
+
+    vkUpdateDescriptorSets(device, static_cast<u32>(writes.size()), writes.data(), 0, nullptr);
+    clear();
+}
+
+void DescriptorWriter::clear() {
+    writes.clear();
+    bufferInfos.clear();
+    imageInfos.clear();
+}
+
+bool DescriptorTemplate::create(VkDevice dev, DeviceCaps const& caps, VkDescriptorSetLayout layout, VkDescriptorUpdateTemplateEntry const* entries, u32 entryCount) {
+    if (!caps.descriptorUpdateTemplate) {
+        return false;
+    }
+
+    device = dev;
+    if (caps.apiVersion >= VK_API_VERSION_1_1) {
+        createTemplate = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplate>(vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplate"));
+        destroyTemplate = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplate>(vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplate"));
+        updateWithTemplate = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplate>(vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplate"));
+    } else {
+        createTemplate = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplate>(vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplateKHR"));
+        destroyTemplate = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplate>(vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplateKHR"));
+        updateWithTemplate = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplate>(vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplateKHR"));
+    }
+
+    if (createTemplate == nullptr || destroyTemplate == nullptr || updateWithTemplate == nullptr) {
+        return false;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    info.descriptorUpdateEntryCount = entryCount;
+    info.pDescriptorUpdateEntries = entries;
+    info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    info.descriptorSetLayout = layout;
+
+    if (createTemplate(device, &info, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE), &handle) != VK_SUCCESS) {
+        handle = VK_NULL_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+void DescriptorTemplate::cleanup() {
+    if (handle != VK_NULL_HANDLE) {
+        destroyTemplate(device, handle, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE));
+        handle = VK_NULL_HANDLE;
+    }
+}
+
+DescriptorAllocator::DescriptorAllocator(DescriptorAllocator&& other) noexcept
+    : device(other.device), ratios(std::move(other.ratios)), flags(other.flags), setsPerPool(other.setsPerPool), maxSetsPerPool(other.maxSetsPerPool),
+      current(other.current), fullPools(std::move(other.fullPools)), readyPools(std::move(other.readyPools)), allocatedSets(other.allocatedSets) {
+    other.device = VK_NULL_HANDLE;
+    other.current = VK_NULL_HANDLE;
+}
+
+void DescriptorAllocator::init(VkDevice dev, u32 initialSets, std::vector<PoolRatio> const& poolRatios, VkDescriptorPoolCreateFlags poolFlags) {
+    device = dev;
+    setsPerPool = std::max(initialSets, 1u);
+    ratios = poolRatios;
+    flags = poolFlags;
+}
+
+void DescriptorAllocator::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    if (current != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, current, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+        current = VK_NULL_HANDLE;
+    }
+
+    for (VkDescriptorPool p : fullPools) {
+        vkDestroyDescriptorPool(device, p, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    }
+    fullPools.clear();
+
+    for (VkDescriptorPool p : readyPools) {
+        vkDestroyDescriptorPool(device, p, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    }
+    readyPools.clear();
+
+    allocatedSets = 0;
+}
+
+VkDescriptorPool DescriptorAllocator::grabPool() {
+    if (!readyPools.empty()) {
+        VkDescriptorPool p = readyPools.back();
+        readyPools.pop_back();
+        return p;
+    }
+
+    std::vector<VkDescriptorPoolSize> sizes;
+    sizes.reserve(ratios.size());
+    for (PoolRatio const& r : ratios) {
+        if (r.ratio <= 0.0f) {
+            continue;
+        }
+
+        VkDescriptorPoolSize size = {};
+        size.type = r.type;
+        size.descriptorCount = std::max(static_cast<u32>(r.ratio * setsPerPool), 1u);
+        sizes.push_back(size);
+    }
+
+    VkDescriptorPoolCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.flags = flags;
+    info.maxSets = setsPerPool;
+    info.poolSizeCount = static_cast<u32>(sizes.size());
+    info.pPoolSizes = sizes.data();
+
+    VkDescriptorPool p;
+    if (vkCreateDescriptorPool(device, &info, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &p) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+
+    setsPerPool = std::min(setsPerPool * 2, maxSetsPerPool);
+    return p;
+}
+
+bool DescriptorAllocator::allocate(VkDescriptorSetLayout layout, VkDescriptorSet* set, const void* pNext) {
+    if (current == VK_NULL_HANDLE) {
+        current = grabPool();
+        if (current == VK_NULL_HANDLE) {
+            return false;
+        }
+    }
+
+    VkDescriptorSetAllocateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    info.pNext = pNext;
+    info.descriptorPool = current;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &layout;
+
+    VkResult result = vkAllocateDescriptorSets(device, &info, set);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        // the pool is done, park it until the next reset and retry once with a fresh one
+        fullPools.push_back(current);
+        current = grabPool();
+        if (current == VK_NULL_HANDLE) {
+            return false;
+        }
+
+        info.descriptorPool = current;
+        result = vkAllocateDescriptorSets(device, &info, set);
+    }
+
+    if (result != VK_SUCCESS) {
+        return false;
+    }
+
+    ++allocatedSets;
+    return true;
+}
+
+void DescriptorAllocator::reset() {
+    if (current != VK_NULL_HANDLE) {
+        fullPools.push_back(current);
+        current = VK_NULL_HANDLE;
+    }
+
+    for (VkDescriptorPool p : fullPools) {
+        vkResetDescriptorPool(device, p, 0);
+        readyPools.push_back(p);
+    }
+    fullPools.clear();
+
+    allocatedSets = 0;
+}
@@ -0,0 +1,287 @@
+#include <geometry.hpp>
+#include <memory.hpp>
+#include <hostalloc.hpp>
+
+#include <cstring>
+
+void RangeAllocator::init(u32 size) {
+    capacity = size;
+    used = 0;
+    freeRanges.clear();
+    freeRanges.push_back({ 0, capacity });
+}
+
+bool RangeAllocator::allocate(u32 size, u32* offset) {
+    for (usize i = 0; i < freeRanges.size(); ++i) {
+        Range& r = freeRanges[i];
+        if (r.size < size) {
+            continue;
+        }
+
+        *offset = r.offset;
+        r.offset += size;
+        r.size -= size;
+        if (r.size == 0) {
+            freeRanges.erase(freeRanges.begin() + i);
+        }
+
+        used += size;
+        return true;
+    }
+
+    return false;
+}
+
+void RangeAllocator::free(u32 offset, u32 size) {
+    if (size == 0) {
+        return;
+    }
+
+    usize i = 0;
+    while (i < freeRanges.size() && freeRanges[i].offset < offset) {
+        ++i;
+    }
+    freeRanges.insert(freeRanges.begin() + i, { offset, size });
+    used -= size;
+
+    // merge with the following range first so i stays valid, then with the preceding one
+    if (i + 1 < freeRanges.size() && freeRanges[i].offset + freeRanges[i].size == freeRanges[i + 1].offset) {
+        freeRanges[i].size += freeRanges[i + 1].size;
+        freeRanges.erase(freeRanges.begin() + i + 1);
+    }
+    if (i > 0 && freeRanges[i - 1].offset + freeRanges[i - 1].size == freeRanges[i].offset) {
+        freeRanges[i - 1].size += freeRanges[i].size;
+        freeRanges.erase(freeRanges.begin() + i);
+    }
+}
+
+bool GeometryPool::create(VkDevice dev, VkPhysicalDevice physicalDevice, u32 stride, u32 maxVertices, u32 maxIndices, u32 frameCount, VkDeviceSize stagingSize, std::vector<u32> const& queueFamilies, bool allowDirectWrite) {
+    device = dev;
+    vertexStride = stride;
+    stagingCapacity = stagingSize;
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    const VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexStride) * maxVertices;
+    const VkDeviceSize indexBytes = sizeof(u32) * static_cast<VkDeviceSize>(maxIndices);
+    auto createBuffers = [&](VkMemoryPropertyFlags memoryFlags) -> bool {
+        return createBuffer(device, memoryProperties, vertexBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryFlags, MemoryBudget::CATEGORY_MESHES, queueFamilies, &vertexBuffer, &vertexMemory)
+            && createBuffer(device, memoryProperties, indexBytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryFlags, MemoryBudget::CATEGORY_MESHES, queueFamilies, &indexBuffer, &indexMemory);
+    };
+
+    directWrite = allowDirectWrite && hasDirectWriteMemory(memoryProperties, ~0u, vertexBytes + indexBytes);
+    if (directWrite) {
+        directWrite = createBuffers(DIRECT_WRITE_MEMORY)
+            && vkMapMemory(device, vertexMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&vertexMapped)) == VK_SUCCESS
+            && vkMapMemory(device, indexMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&indexMapped)) == VK_SUCCESS;
+        if (!directWrite) {
+            // the buffers' own memory type bits may not include the direct write types, staging still works
+            destroyBuffers();
+        }
+    }
+    if (!directWrite && !createBuffers(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+        cleanup();
+        return false;
+    }
+
+    vertexRanges.init(maxVertices);
+    indexRanges.init(maxIndices);
+
+    // the frames still recycle ranges with direct writes, they just have no staging area
+    frames.resize(frameCount);
+    for (Frame& frame : frames) {
+        if (!directWrite && (!createBuffer(device, memoryProperties, stagingCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_STAGING, queueFamilies, &frame.stagingBuffer, &frame.stagingMemory)
+            || vkMapMemory(device, frame.stagingMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&frame.staging)) != VK_SUCCESS)) {
+            cleanup();
+            return false;
+        }
+    }
+
+    currentFrame = 0;
+    return true;
+}
+
+void GeometryPool::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    for (Frame& frame : frames) {
+        vkDestroyBuffer(device, frame.stagingBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.stagingMemory);
+    }
+    frames.clear();
+
+    destroyBuffers();
+
+    meshes.clear();
+    resident.clear();
+    freeMeshIds.clear();
+}
+
+void GeometryPool::destroyBuffers() {
+    vkDestroyBuffer(device, vertexBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, vertexMemory);
+    vkDestroyBuffer(device, indexBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, indexMemory);
+    vertexBuffer = VK_NULL_HANDLE;
+    vertexMemory = VK_NULL_HANDLE;
+    indexBuffer = VK_NULL_HANDLE;
+    indexMemory = VK_NULL_HANDLE;
+    vertexMapped = nullptr;
+    indexMapped = nullptr;
+}
+
+void GeometryPool::beginFrame(u32 frame) {
+    currentFrame = frame;
+
+    Frame& f = frames[currentFrame];
+    f.stagingUsed = 0;
+    f.vertexCopies.clear();
+    f.indexCopies.clear();
+
+    for (u32 id : f.retiredMeshes) {
+        MeshRange const& m = meshes[id];
+        vertexRanges.free(static_cast<u32>(m.vertexOffset), m.vertexCount);
+        if (m.indexType == VK_INDEX_TYPE_UINT16) {
+            indexRanges.free(m.firstIndex / 2, (m.indexCount + 1) / 2);
+        } else {
+            indexRanges.free(m.firstIndex, m.indexCount);
+        }
+        freeMeshIds.push_back(id);
+    }
+    f.retiredMeshes.clear();
+}
+
+u32 GeometryPool::stage(void const* vertices, u32 vertexCount, u32 indexCount, VertexDecode const& decode, void** indexStaging) {
+    Frame& f = frames[currentFrame];
+
+    const bool shortIndices = indexTypeFor(vertexCount) == VK_INDEX_TYPE_UINT16;
+    const u32 indexWords = shortIndices ? (indexCount + 1) / 2 : indexCount;
+
+    VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexStride) * vertexCount;
+    VkDeviceSize indexBytes = (shortIndices ? sizeof(u16) : sizeof(u32)) * static_cast<VkDeviceSize>(indexCount);
+    // keep every staged block 4 byte aligned so the 16 and 32 bit index writes stay aligned
+    VkDeviceSize vertexStaging = (f.stagingUsed + 3) & ~VkDeviceSize(3);
+    VkDeviceSize indexOffset = (vertexStaging + vertexBytes + 3) & ~VkDeviceSize(3);
+    if (!directWrite && indexOffset + indexBytes > stagingCapacity) {
+        return INVALID_MESH;
+    }
+
+    u32 firstVertex;
+    u32 firstWord;
+    if (!vertexRanges.allocate(vertexCount, &firstVertex)) {
+        return INVALID_MESH;
+    }
+    if (!indexRanges.allocate(indexWords, &firstWord)) {
+        vertexRanges.free(firstVertex, vertexCount);
+        return INVALID_MESH;
+    }
+
+    if (directWrite) {
+        memcpy(vertexMapped + static_cast<VkDeviceSize>(vertexStride) * firstVertex, vertices, vertexBytes);
+        *indexStaging = indexMapped + sizeof(u32) * static_cast<VkDeviceSize>(firstWord);
+    } else {
+        memcpy(f.staging + vertexStaging, vertices, vertexBytes);
+        *indexStaging = f.staging + indexOffset;
+        f.stagingUsed = indexOffset + indexBytes;
+
+        f.vertexCopies.push_back({ vertexStaging, static_cast<VkDeviceSize>(vertexStride) * firstVertex, vertexBytes });
+        f.indexCopies.push_back({ indexOffset, sizeof(u32) * static_cast<VkDeviceSize>(firstWord), indexBytes });
+    }
+
+    u32 id;
+    if (!freeMeshIds.empty()) {
+        id = freeMeshIds.back();
+        freeMeshIds.pop_back();
+    } else {
+        id = static_cast<u32>(meshes.size());
+        meshes.emplace_back();
+        resident.push_back(false);
+    }
+
+    meshes[id].vertexOffset = static_cast<s32>(firstVertex);
+    meshes[id].vertexCount = vertexCount;
+    meshes[id].firstIndex = shortIndices ? firstWord * 2 : firstWord;
+    meshes[id].indexCount = indexCount;
+    meshes[id].indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    meshes[id].decode = decode;
+    resident[id] = true;
+    return id;
+}
+
+u32 GeometryPool::addMesh(void const* vertices, u32 vertexCount, u32 const* indices, u32 indexCount, VertexDecode const& decode) {
+    void* indexStaging;
+    u32 id = stage(vertices, vertexCount, indexCount, decode, &indexStaging);
+    if (id == INVALID_MESH) {
+        return INVALID_MESH;
+    }
+
+    if (meshes[id].indexType == VK_INDEX_TYPE_UINT16) {
+        u16* dst = static_cast<u16*>(indexStaging);
+        for (u32 i = 0; i < indexCount; ++i) {
+            dst[i] = static_cast<u16>(indices[i]);
+        }
+    } else {
+        memcpy(indexStaging, indices, sizeof(u32) * static_cast<usize>(indexCount));
+    }
+    return id;
+}
+
+u32 GeometryPool::addMesh(void const* vertices, u32 vertexCount, void const* indices, VkIndexType indexType, u32 indexCount, VertexDecode const& decode) {
+    if (indexType != indexTypeFor(vertexCount)) {
+        return INVALID_MESH;
+    }
+
+    void* indexStaging;
+    u32 id = stage(vertices, vertexCount, indexCount, decode, &indexStaging);
+    if (id == INVALID_MESH) {
+        return INVALID_MESH;
+    }
+
+    memcpy(indexStaging, indices, (indexType == VK_INDEX_TYPE_UINT16 ? sizeof(u16) : sizeof(u32)) * static_cast<usize>(indexCount));
+    return id;
+}
+
+void GeometryPool::removeMesh(u32 mesh) {
+    if (mesh >= meshes.size() || !resident[mesh]) {
+        return;
+    }
+
+    resident[mesh] = false;
+    frames[currentFrame].retiredMeshes.push_back(mesh);
+}
+
+void GeometryPool::recordUploads(VkCommandBuffer commandBuffer, VkPipelineStageFlags consumerStages) {
+    Frame& f = frames[currentFrame];
+    if (f.vertexCopies.empty() && f.indexCopies.empty()) {
+        return;
+    }
+
+    if (!f.vertexCopies.empty()) {
+        vkCmdCopyBuffer(commandBuffer, f.stagingBuffer, vertexBuffer, static_cast<u32>(f.vertexCopies.size()), f.vertexCopies.data());
+    }
+    if (!f.indexCopies.empty()) {
+        vkCmdCopyBuffer(commandBuffer, f.stagingBuffer, indexBuffer, static_cast<u32>(f.indexCopies.size()), f.indexCopies.data());
+    }
+    f.vertexCopies.clear();
+    f.indexCopies.clear();
+
+    if (consumerStages == 0) {
+        return;
+    }
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, consumerStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GeometryPool::bind(VkCommandBuffer commandBuffer, VkIndexType indexType) const {
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+}
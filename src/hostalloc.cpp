@@ -0,0 +1,339 @@
+#include <hostalloc.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+struct alignas(16) Header {
+    u64 size;
+    // from the start of the block to the pointer handed out
+    u32 offset;
+    u16 tag;
+    u8 scope;
+    // SIZE_CLASS_COUNT when the block came from malloc
+    u8 sizeClass;
+};
+static_assert(sizeof(Header) == HostAllocator::HEADER_SIZE, "the header must keep 16 byte alignment");
+
+struct TagInfo {
+    VkObjectType type;
+    const char* name;
+};
+
+const TagInfo TAG_INFOS[HostAllocator::TAG_COUNT] = {
+    { VK_OBJECT_TYPE_INSTANCE, "instance" },
+    { VK_OBJECT_TYPE_DEVICE, "device" },
+    { VK_OBJECT_TYPE_SURFACE_KHR, "surface" },
+    { VK_OBJECT_TYPE_SWAPCHAIN_KHR, "swapchain" },
+    { VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT, "debug messenger" },
+    { VK_OBJECT_TYPE_DEVICE_MEMORY, "device memory" },
+    { VK_OBJECT_TYPE_BUFFER, "buffer" },
+    { VK_OBJECT_TYPE_IMAGE, "image" },
+    { VK_OBJECT_TYPE_IMAGE_VIEW, "image view" },
+    { VK_OBJECT_TYPE_SAMPLER, "sampler" },
+    { VK_OBJECT_TYPE_SHADER_MODULE, "shader module" },
+    { VK_OBJECT_TYPE_PIPELINE, "pipeline" },
+    { VK_OBJECT_TYPE_PIPELINE_LAYOUT, "pipeline layout" },
+    { VK_OBJECT_TYPE_RENDER_PASS, "render pass" },
+    { VK_OBJECT_TYPE_FRAMEBUFFER, "framebuffer" },
+    { VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "descriptor set layout" },
+    { VK_OBJECT_TYPE_DESCRIPTOR_POOL, "descriptor pool" },
+    { VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE, "descriptor update template" },
+    { VK_OBJECT_TYPE_COMMAND_POOL, "command pool" },
+    { VK_OBJECT_TYPE_QUERY_POOL, "query pool" },
+    { VK_OBJECT_TYPE_SEMAPHORE, "semaphore" },
+    { VK_OBJECT_TYPE_FENCE, "fence" },
+    { VK_OBJECT_TYPE_UNKNOWN, "other" },
+};
+
+const char* const SCOPE_NAMES[HostAllocator::SCOPE_COUNT] = { "command", "object", "cache", "device", "instance" };
+
+void raiseTo(std::atomic<u64>& peak, u64 value) {
+    u64 current = peak.load(std::memory_order_relaxed);
+    while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+f64 kib(u64 bytes) {
+    return static_cast<f64>(bytes) / 1024.0;
+}
+
+}
+
+HostAllocator::HostAllocator() {
+    for (u32 i = 0; i < TAG_COUNT; ++i) {
+        Tag& tag = tags[i];
+        tag.type = TAG_INFOS[i].type;
+        tag.name = TAG_INFOS[i].name;
+        tag.callbacks = {};
+        tag.callbacks.pUserData = &tag;
+        tag.callbacks.pfnAllocation = allocationCallback;
+        tag.callbacks.pfnReallocation = reallocationCallback;
+        tag.callbacks.pfnFree = freeCallback;
+        tag.callbacks.pfnInternalAllocation = internalAllocationCallback;
+        tag.callbacks.pfnInternalFree = internalFreeCallback;
+    }
+}
+
+HostAllocator::~HostAllocator() {
+    for (SizeClass& sizeClass : sizeClasses) {
+        for (void* chunk : sizeClass.chunks) {
+            std::free(chunk);
+        }
+    }
+}
+
+HostAllocator& HostAllocator::instance() {
+    static HostAllocator allocator;
+    return allocator;
+}
+
+void HostAllocator::init(Mode m) {
+    mode = m;
+}
+
+const VkAllocationCallbacks* HostAllocator::callbacks(VkObjectType type) const {
+    if (mode == MODE_OFF) {
+        return nullptr;
+    }
+
+    for (u32 i = 0; i + 1 < TAG_COUNT; ++i) {
+        if (tags[i].type == type) {
+            return &tags[i].callbacks;
+        }
+    }
+    return &tags[TAG_COUNT - 1].callbacks;
+}
+
+void* HostAllocator::allocate(Tag& tag, usize size, usize alignment, VkSystemAllocationScope scope) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    alignment = std::max(alignment, HEADER_SIZE);
+    u32 sizeClass = SIZE_CLASS_COUNT;
+    if (mode == MODE_POOL && alignment == HEADER_SIZE) {
+        for (u32 c = 0; c < SIZE_CLASS_COUNT; ++c) {
+            if (size + HEADER_SIZE <= MIN_CLASS_SIZE << c) {
+                sizeClass = c;
+                break;
+            }
+        }
+    }
+
+    u8* base;
+    usize offset;
+    if (sizeClass < SIZE_CLASS_COUNT) {
+        SizeClass& pool = sizeClasses[sizeClass];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.freeList == nullptr) {
+            u8* chunk = static_cast<u8*>(std::malloc(CHUNK_SIZE));
+            if (chunk == nullptr) {
+                return nullptr;
+            }
+            pool.chunks.push_back(chunk);
+
+            usize blockSize = MIN_CLASS_SIZE << sizeClass;
+            for (usize at = 0; at + blockSize <= CHUNK_SIZE; at += blockSize) {
+                *reinterpret_cast<void**>(chunk + at) = pool.freeList;
+                pool.freeList = chunk + at;
+            }
+        }
+
+        base = static_cast<u8*>(pool.freeList);
+        pool.freeList = *reinterpret_cast<void**>(base);
+        offset = HEADER_SIZE;
+    } else {
+        base = static_cast<u8*>(std::malloc(size + alignment + HEADER_SIZE));
+        if (base == nullptr) {
+            return nullptr;
+        }
+
+        uintptr_t start = reinterpret_cast<uintptr_t>(base) + HEADER_SIZE;
+        offset = ((start + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1)) - reinterpret_cast<uintptr_t>(base);
+    }
+
+    u8* memory = base + offset;
+    Header* header = reinterpret_cast<Header*>(memory) - 1;
+    header->size = size;
+    header->offset = static_cast<u32>(offset);
+    header->tag = static_cast<u16>(&tag - tags);
+    header->scope = static_cast<u8>(scope);
+    header->sizeClass = static_cast<u8>(sizeClass);
+
+    Counters& counters = tag.scopes[scope];
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    if (sizeClass < SIZE_CLASS_COUNT) {
+        counters.pooled.fetch_add(1, std::memory_order_relaxed);
+    }
+    raiseTo(counters.peakBytes, counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+    raiseTo(counters.maxAlignment, alignment);
+    raiseTo(peakBytes, liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+    return memory;
+}
+
+void* HostAllocator::reallocate(Tag& tag, void* original, usize size, usize alignment, VkSystemAllocationScope scope) {
+    if (original == nullptr) {
+        return allocate(tag, size, alignment, scope);
+    }
+    if (size == 0) {
+        release(original);
+        return nullptr;
+    }
+
+    // counted as an allocation and a free too, drivers that reallocate a lot show up in both
+    tag.scopes[scope].reallocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = allocate(tag, size, alignment, scope);
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    Header const* header = reinterpret_cast<Header const*>(original) - 1;
+    memcpy(memory, original, std::min<usize>(header->size, size));
+    release(original);
+    return memory;
+}
+
+void HostAllocator::release(void* memory) {
+    if (memory == nullptr) {
+        return;
+    }
+
+    Header const* header = reinterpret_cast<Header const*>(memory) - 1;
+    u64 size = header->size;
+    u32 sizeClass = header->sizeClass;
+    u8* base = static_cast<u8*>(memory) - header->offset;
+
+    Counters& counters = tags[header->tag].scopes[header->scope];
+    counters.frees.fetch_add(1, std::memory_order_relaxed);
+    counters.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+    liveBytes.fetch_sub(size, std::memory_order_relaxed);
+
+    if (sizeClass < SIZE_CLASS_COUNT) {
+        SizeClass& pool = sizeClasses[sizeClass];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        *reinterpret_cast<void**>(base) = pool.freeList;
+        pool.freeList = base;
+    } else {
+        std::free(base);
+    }
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::allocationCallback(void* userData, usize size, usize alignment, VkSystemAllocationScope scope) {
+    return instance().allocate(*static_cast<Tag*>(userData), size, alignment, scope);
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::reallocationCallback(void* userData, void* original, usize size, usize alignment, VkSystemAllocationScope scope) {
+    return instance().reallocate(*static_cast<Tag*>(userData), original, size, alignment, scope);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::freeCallback(void* userData, void* memory) {
+    instance().release(memory);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocationCallback(void* userData, usize size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    static_cast<Tag*>(userData)->scopes[scope].internalBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFreeCallback(void* userData, usize size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+    static_cast<Tag*>(userData)->scopes[scope].internalBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+HostAllocator::Totals HostAllocator::totals(Tag const& tag) const {
+    Totals t;
+    for (Counters const& c : tag.scopes) {
+        t.allocations += c.allocations.load(std::memory_order_relaxed);
+        t.reallocations += c.reallocations.load(std::memory_order_relaxed);
+        t.frees += c.frees.load(std::memory_order_relaxed);
+        t.pooled += c.pooled.load(std::memory_order_relaxed);
+        t.liveBytes += c.liveBytes.load(std::memory_order_relaxed);
+        // peaks of different scopes needn't coincide, this is an upper bound
+        t.peakBytes += c.peakBytes.load(std::memory_order_relaxed);
+        t.maxAlignment = std::max(t.maxAlignment, c.maxAlignment.load(std::memory_order_relaxed));
+        t.internalBytes += c.internalBytes.load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+HostAllocator::Totals HostAllocator::scopeTotals(u32 scope) const {
+    Totals t;
+    for (Tag const& tag : tags) {
+        Counters const& c = tag.scopes[scope];
+        t.allocations += c.allocations.load(std::memory_order_relaxed);
+        t.reallocations += c.reallocations.load(std::memory_order_relaxed);
+        t.frees += c.frees.load(std::memory_order_relaxed);
+        t.pooled += c.pooled.load(std::memory_order_relaxed);
+        t.liveBytes += c.liveBytes.load(std::memory_order_relaxed);
+        t.peakBytes += c.peakBytes.load(std::memory_order_relaxed);
+        t.maxAlignment = std::max(t.maxAlignment, c.maxAlignment.load(std::memory_order_relaxed));
+        t.internalBytes += c.internalBytes.load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+void HostAllocator::printChurn(f64 seconds) {
+    if (mode == MODE_OFF) {
+        return;
+    }
+
+    u64 allocations = 0;
+    u64 pooled = 0;
+    u64 perTag[TAG_COUNT];
+    for (u32 i = 0; i < TAG_COUNT; ++i) {
+        Totals t = totals(tags[i]);
+        perTag[i] = t.allocations - lastChurn[i].allocations;
+        allocations += perTag[i];
+        pooled += t.pooled - lastChurn[i].pooled;
+        lastChurn[i] = t;
+    }
+
+    u32 order[TAG_COUNT];
+    for (u32 i = 0; i < TAG_COUNT; ++i) {
+        order[i] = i;
+    }
+    std::sort(order, order + TAG_COUNT, [&](u32 a, u32 b) {
+        return perTag[a] > perTag[b];
+    });
+
+    std::cout << "    host memory: " << kib(liveBytes.load(std::memory_order_relaxed)) << " KiB live, peak "
+              << kib(peakBytes.load(std::memory_order_relaxed)) << " KiB, " << allocations / seconds << " allocations/s";
+    for (u32 i = 0; i < 3 && perTag[order[i]] > 0; ++i) {
+        std::cout << (i == 0 ? " (" : ", ") << tags[order[i]].name << " " << perTag[order[i]] / seconds;
+    }
+    std::cout << (perTag[order[0]] > 0 ? ")" : "");
+    if (mode == MODE_POOL && allocations > 0) {
+        std::cout << ", " << 100 * pooled / allocations << "% pooled";
+    }
+    std::cout << "\n";
+}
+
+void HostAllocator::printReport() const {
+    if (mode == MODE_OFF) {
+        return;
+    }
+
+    std::cout << "Host allocations through VkAllocationCallbacks, peak " << kib(peakBytes.load(std::memory_order_relaxed)) << " KiB:\n";
+    std::cout << std::setw(28) << "" << std::setw(12) << "allocations" << std::setw(10) << "reallocs" << std::setw(10) << "frees"
+              << std::setw(12) << "live KiB" << std::setw(12) << "peak KiB" << std::setw(8) << "align" << std::setw(14) << "internal KiB" << "\n";
+
+    auto row = [](const char* name, Totals const& t) {
+        std::cout << "    " << std::setw(24) << std::left << name << std::right << std::setw(12) << t.allocations << std::setw(10) << t.reallocations
+                  << std::setw(10) << t.frees << std::setw(12) << kib(t.liveBytes) << std::setw(12) << kib(t.peakBytes) << std::setw(8) << t.maxAlignment
+                  << std::setw(14) << kib(t.internalBytes) << "\n";
+    };
+
+    for (Tag const& tag : tags) {
+        Totals t = totals(tag);
+        if (t.allocations > 0 || t.internalBytes > 0) {
+            row(tag.name, t);
+        }
+    }
+    std::cout << "  by scope:\n";
+    for (u32 scope = 0; scope < SCOPE_COUNT; ++scope) {
+        row(SCOPE_NAMES[scope], scopeTotals(scope));
+    }
+}
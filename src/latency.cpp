@@ -0,0 +1,74 @@
+#include <latency.hpp>
+
+#include <algorithm>
+
+void LatencyTracker::init(VkDevice dev, DeviceCaps const& caps) {
+    device = dev;
+    waitForPresent = nullptr;
+    if (caps.presentWait) {
+        waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+    }
+}
+
+u64 LatencyTracker::beginFrame() {
+    Frame& frame = ring[nextId % CAPACITY];
+    frame = {};
+    frame.id = nextId;
+    frame.times[MARKER_POLL] = Clock::now();
+    frame.marked = 1u << MARKER_POLL;
+    return nextId++;
+}
+
+void LatencyTracker::mark(Marker marker) {
+    Frame& frame = ring[(nextId - 1) % CAPACITY];
+    frame.times[marker] = Clock::now();
+    frame.marked |= 1u << marker;
+}
+
+void LatencyTracker::pollDisplay(VkSwapchainKHR swapchain) {
+    if (waitForPresent == nullptr) {
+        return;
+    }
+
+    // frames that fell out of the ring can't be updated any more
+    firstUndisplayed = std::max(firstUndisplayed, nextId > CAPACITY ? nextId - CAPACITY : 1);
+    for (; firstUndisplayed < nextId; ++firstUndisplayed) {
+        Frame& frame = ring[firstUndisplayed % CAPACITY];
+        // dropped on a failed acquire, never presented
+        if ((frame.marked & (1u << MARKER_PRESENT)) == 0) {
+            continue;
+        }
+        if (waitForPresent(device, swapchain, frame.id, 0) != VK_SUCCESS) {
+            break;
+        }
+        frame.times[MARKER_DISPLAY] = Clock::now();
+        frame.marked |= 1u << MARKER_DISPLAY;
+    }
+}
+
+void LatencyTracker::dropPending() {
+    firstUndisplayed = nextId;
+}
+
+LatencyTracker::Summary LatencyTracker::summarize() {
+    Summary summary;
+    u64 end = waitForPresent != nullptr ? firstUndisplayed : nextId - 1;
+    u64 begin = std::max(firstUnsummarized, nextId > CAPACITY ? nextId - CAPACITY : 1);
+    for (u64 id = begin; id < end; ++id) {
+        Frame const& frame = ring[id % CAPACITY];
+        for (u32 m = MARKER_UNIFORM; m < MARKER_COUNT; ++m) {
+            if ((frame.marked & (1u << m)) == 0) {
+                continue;
+            }
+            f64 ms = std::chrono::duration<f64, std::milli>(frame.times[m] - frame.times[MARKER_POLL]).count();
+            ++summary.frames[m];
+            summary.averageMs[m] += ms;
+            summary.maxMs[m] = std::max(summary.maxMs[m], ms);
+        }
+    }
+    for (u32 m = 0; m < MARKER_COUNT; ++m) {
+        summary.averageMs[m] /= std::max(summary.frames[m], 1u);
+    }
+    firstUnsummarized = std::max(firstUnsummarized, end);
+    return summary;
+}
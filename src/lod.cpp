@@ -0,0 +1,129 @@
+#include <lod.hpp>
+
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LOD_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LOD_NEON 1
+#endif
+
+f32 lodProjectionScale(f32 fovY, f32 viewportHeight) {
+    return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+// Level k is good enough once error[k] * projectionScale / distance <= thresholdPixels, squared that is
+// distance^2 >= limits[k]. Levels past the chain's count can never be reached.
+static void lodLimits(LodChain const& chain, f32 projectionScale, f32 thresholdPixels, f32 limits[LodChain::MAX_LODS]) {
+    for (u32 k = 0; k < LodChain::MAX_LODS; ++k) {
+        if (k == 0) {
+            limits[k] = 0.0f;
+        } else if (k >= chain.count || thresholdPixels <= 0.0f) {
+            limits[k] = std::numeric_limits<f32>::infinity();
+        } else {
+            f32 reach = chain.error[k] * projectionScale / thresholdPixels;
+            limits[k] = reach * reach;
+        }
+    }
+}
+
+u64 selectLodsScalar(LodChain const& chain, f32 const* x, f32 const* y, f32 const* z, u32 count, f32 const eye[3], f32 projectionScale, f32 thresholdPixels, u8* lods) {
+    f32 limits[LodChain::MAX_LODS];
+    lodLimits(chain, projectionScale, thresholdPixels, limits);
+
+    u64 triangles = 0;
+    for (u32 i = 0; i < count; ++i) {
+        f32 dx = x[i] - eye[0];
+        f32 dy = y[i] - eye[1];
+        f32 dz = z[i] - eye[2];
+        f32 distance2 = dx * dx + dy * dy + dz * dz;
+
+        u32 lod = 0;
+        while (lod + 1 < LodChain::MAX_LODS && distance2 >= limits[lod + 1]) {
+            ++lod;
+        }
+        lods[i] = static_cast<u8>(lod);
+        triangles += chain.indexCount[lod] / 3;
+    }
+
+    return triangles;
+}
+
+u64 selectLods(LodChain const& chain, f32 const* x, f32 const* y, f32 const* z, u32 count, f32 const eye[3], f32 projectionScale, f32 thresholdPixels, u8* lods) {
+    f32 limits[LodChain::MAX_LODS];
+    lodLimits(chain, projectionScale, thresholdPixels, limits);
+
+    u32 i = 0;
+    u64 triangles = 0;
+    u32 picked[LodChain::MAX_LODS] = {};
+
+#if defined(LOD_SSE2)
+    const __m128 eyeX = _mm_set1_ps(eye[0]);
+    const __m128 eyeY = _mm_set1_ps(eye[1]);
+    const __m128 eyeZ = _mm_set1_ps(eye[2]);
+    __m128 limit[LodChain::MAX_LODS];
+    for (u32 k = 0; k < LodChain::MAX_LODS; ++k) {
+        limit[k] = _mm_set1_ps(limits[k]);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), eyeX);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), eyeY);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(z + i), eyeZ);
+        __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+        // limits grow with the level, so counting the ones passed gives the level; a passed compare is all ones, -1
+        __m128i lod = _mm_setzero_si128();
+        for (u32 k = 1; k < LodChain::MAX_LODS; ++k) {
+            lod = _mm_sub_epi32(lod, _mm_castps_si128(_mm_cmpge_ps(distance2, limit[k])));
+        }
+
+        alignas(16) u32 lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), lod);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            lods[i + lane] = static_cast<u8>(lanes[lane]);
+            ++picked[lanes[lane]];
+        }
+    }
+#elif defined(LOD_NEON)
+    const float32x4_t eyeX = vdupq_n_f32(eye[0]);
+    const float32x4_t eyeY = vdupq_n_f32(eye[1]);
+    const float32x4_t eyeZ = vdupq_n_f32(eye[2]);
+    float32x4_t limit[LodChain::MAX_LODS];
+    for (u32 k = 0; k < LodChain::MAX_LODS; ++k) {
+        limit[k] = vdupq_n_f32(limits[k]);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t dx = vsubq_f32(vld1q_f32(x + i), eyeX);
+        float32x4_t dy = vsubq_f32(vld1q_f32(y + i), eyeY);
+        float32x4_t dz = vsubq_f32(vld1q_f32(z + i), eyeZ);
+        float32x4_t distance2 = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz);
+
+        uint32x4_t lod = vdupq_n_u32(0);
+        for (u32 k = 1; k < LodChain::MAX_LODS; ++k) {
+            lod = vsubq_u32(lod, vcgeq_f32(distance2, limit[k]));
+        }
+
+        u32 lanes[4];
+        vst1q_u32(lanes, lod);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            lods[i + lane] = static_cast<u8>(lanes[lane]);
+            ++picked[lanes[lane]];
+        }
+    }
+#endif
+
+    for (u32 k = 0; k < LodChain::MAX_LODS; ++k) {
+        triangles += static_cast<u64>(picked[k]) * (k < chain.count ? chain.indexCount[k] / 3 : 0);
+    }
+
+    if (i < count) {
+        triangles += selectLodsScalar(chain, x + i, y + i, z + i, count - i, eye, projectionScale, thresholdPixels, lods + i);
+    }
+
+    return triangles;
+}
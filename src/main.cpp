@@ -4,13 +4,43 @@
 
 #include <types.hpp>
 #include <ktga.hpp>
+#include <caps.hpp>
+#include <shader.hpp>
+#include <bindless.hpp>
+#include <descriptors.hpp>
+#include <memory.hpp>
+#include <commands.hpp>
+#include <scene.hpp>
+#include <culling.hpp>
+#include <occlusion.hpp>
+#include <vertex.hpp>
+#include <geometry.hpp>
+#include <mesh.hpp>
+#include <lod.hpp>
+#include <sprites.hpp>
+#include <particles.hpp>
+#include <rendergraph.hpp>
+#include <timeline.hpp>
+#include <pacing.hpp>
+#include <latency.hpp>
+#include <profiler.hpp>
+#include <startup.hpp>
+#include <debuglog.hpp>
+#include <config.hpp>
+#include <hostalloc.hpp>
+#include <budget.hpp>
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <tuple>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <cmath>
 
 struct Scope {
 	struct IMess {
@@ -79,6 +109,27 @@ struct Scope {
 	};
 };
 
+// Most precise depth-only format first, packed stencil formats only as a fallback since nothing uses stencil.
+VkFormat findDepthFormat(VkPhysicalDevice physicalDevice) {
+    VkFormat candidates[] = {
+        VK_FORMAT_D32_SFLOAT,
+        VK_FORMAT_X8_D24_UNORM_PACK32,
+        VK_FORMAT_D24_UNORM_S8_UINT,
+        VK_FORMAT_D32_SFLOAT_S8_UINT,
+        VK_FORMAT_D16_UNORM,
+    };
+    
+    for (VkFormat format : candidates) {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+        if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            return format;
+        }
+    }
+    
+    return VK_FORMAT_UNDEFINED;
+}
+
 struct Swapchain {
     VkPhysicalDevice physicalDevice;
     VkDevice device;
@@ -98,10 +149,26 @@ struct Swapchain {
     std::vector<VkImageView> swapchainImageViews;
     std::vector<VkFramebuffer> swapchainFramebuffers;
     
+    // one depth buffer shared by every swapchain image, the render pass dependency orders its reuse
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    // occlusion culling adds VK_IMAGE_USAGE_SAMPLED_BIT to build its Hi-Z pyramid from the depth buffer
+    VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    VkImage depthImage = VK_NULL_HANDLE;
+    VkDeviceMemory depthMemory = VK_NULL_HANDLE;
+    VkImageView depthImageView = VK_NULL_HANDLE;
+    
     bool isFormatCalculated = false;
     bool isColorSpaceCalculated = false;
     bool isPresentModeCalculated = false;
     
+    // set before the first create(). MAX_ENUM, or a mode the surface doesn't support, picks MAILBOX when there is
+    // one and FIFO otherwise; the image count is clamped to what the surface allows
+    VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_MAX_ENUM_KHR;
+    u32 requestedImageCount = 3;
+    
+    // bumped on every successful create() so anything recorded against the old images can tell it is stale
+    u32 generation = 0;
+    
     Swapchain(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, GLFWwindow* window, std::vector<u32> const& queueFamilyIndices) : physicalDevice(physicalDevice), device(device), surface(surface), window(window), queueFamilyIndices(queueFamilyIndices) {}
     ~Swapchain() {
         cleanup();
@@ -146,6 +213,14 @@ struct Swapchain {
         std::vector<VkPresentModeKHR> swapchainPresentModes(swapchainPresentModeCount);
         vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &swapchainPresentModeCount, swapchainPresentModes.data());
         
+        for (VkPresentModeKHR p : swapchainPresentModes) {
+            if (p == requestedPresentMode) {
+                calculatedPresentMode = p;
+                isPresentModeCalculated = true;
+                return true;
+            }
+        }
+        
         for (VkPresentModeKHR p : swapchainPresentModes) {
             if (p == VK_PRESENT_MODE_MAILBOX_KHR) {
                 calculatedPresentMode = p;
@@ -188,9 +263,11 @@ struct Swapchain {
         swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         swapchainCreateInfo.clipped = true;
 
-        swapchainCreateInfo.minImageCount = std::max(surfaceCapabilities.minImageCount, std::min(static_cast<u32>(3), surfaceCapabilities.maxImageCount));
+        // a maxImageCount of 0 means no limit
+        u32 maxImageCount = surfaceCapabilities.maxImageCount != 0 ? surfaceCapabilities.maxImageCount : std::numeric_limits<u32>::max();
+        swapchainCreateInfo.minImageCount = std::max(surfaceCapabilities.minImageCount, std::min(requestedImageCount, maxImageCount));
 
-        if (vkCreateSwapchainKHR(device, &swapchainCreateInfo, nullptr, &swapchain) != VK_SUCCESS) {
+        if (vkCreateSwapchainKHR(device, &swapchainCreateInfo, hostAllocator(VK_OBJECT_TYPE_SWAPCHAIN_KHR), &swapchain) != VK_SUCCESS) {
             return false;
         }
 
@@ -218,157 +295,2419 @@ struct Swapchain {
             info.subresourceRange.baseArrayLayer = 0;
             info.subresourceRange.layerCount = 1;
 
-            if (vkCreateImageView(device, &info, nullptr, &swapchainImageViews[i]) != VK_SUCCESS) {
+            if (vkCreateImageView(device, &info, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), &swapchainImageViews[i]) != VK_SUCCESS) {
+                scope.cleanup();
+                return false;
+            }
+            scope.addMess(vkDestroyImageView, device, swapchainImageViews[i], hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+        }
+        
+        scope.scrap();
+        currentExtent = swapchainCreateInfo.imageExtent;
+        ++generation;
+        return true;
+    }
+    
+    bool createDepthBuffer() {
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = depthFormat;
+        imageInfo.extent = { currentExtent.width, currentExtent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = depthUsage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        
+        if (vkCreateImage(device, &imageInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE), &depthImage) != VK_SUCCESS) {
+            return false;
+        }
+        
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(device, depthImage, &memoryRequirements);
+        
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        
+        if (!allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_TARGETS, &depthMemory)) {
+            return false;
+        }
+        vkBindImageMemory(device, depthImage, depthMemory, 0);
+        
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = depthImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = depthFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        
+        return vkCreateImageView(device, &viewInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), &depthImageView) == VK_SUCCESS;
+    }
+    
+    bool createFramebuffers(VkRenderPass rp) {
+        renderPass = rp;
+        
+        if (!createDepthBuffer()) {
+            return false;
+        }
+        
+        Scope scope;
+        swapchainFramebuffers.resize(swapchainImages.size());
+        for (usize i = 0; i < swapchainImageViews.size(); ++i) {
+            VkImageView attachments[2] = { swapchainImageViews[i], depthImageView };
+            
+            VkFramebufferCreateInfo info = {};
+            info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            info.renderPass = renderPass;
+            info.attachmentCount = 2;
+            info.pAttachments = attachments;
+            info.width = currentExtent.width;
+            info.height = currentExtent.height;
+            info.layers = 1;
+
+            if (vkCreateFramebuffer(device, &info, hostAllocator(VK_OBJECT_TYPE_FRAMEBUFFER), &swapchainFramebuffers[i]) != VK_SUCCESS) {
                 scope.cleanup();
                 return false;
             }
-            scope.addMess(vkDestroyImageView, device, swapchainImageViews[i], nullptr);
+            scope.addMess(vkDestroyFramebuffer, device, swapchainFramebuffers[i], hostAllocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+        }
+        
+        scope.scrap();
+        return true;
+    }
+    
+    void cleanup() {
+        if (device == VK_NULL_HANDLE) {
+            return;
+        }
+        
+        vkDeviceWaitIdle(device);
+        for (VkFramebuffer f : swapchainFramebuffers) {
+            vkDestroyFramebuffer(device, f, hostAllocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+        }
+        swapchainFramebuffers.clear();
+        
+        for (VkImageView v : swapchainImageViews) {
+            vkDestroyImageView(device, v, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+        }
+        swapchainImageViews.clear();
+        
+        if (depthImageView != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, depthImageView, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+            depthImageView = VK_NULL_HANDLE;
+        }
+        if (depthImage != VK_NULL_HANDLE) {
+            vkDestroyImage(device, depthImage, hostAllocator(VK_OBJECT_TYPE_IMAGE));
+            depthImage = VK_NULL_HANDLE;
+        }
+        if (depthMemory != VK_NULL_HANDLE) {
+            freeMemory(device, depthMemory);
+            depthMemory = VK_NULL_HANDLE;
+        }
+        
+        if (swapchain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(device, swapchain, hostAllocator(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+        }
+    }
+    
+    u32 recreate() {
+        VkSurfaceCapabilitiesKHR caps;
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps);
+        
+        if (caps.currentExtent.width == 0 || caps.currentExtent.height == 0) {
+            return 2;
+        }
+        
+        cleanup();
+        if (!create()) {
+            return 0;
+        }
+        
+        return createFramebuffers(renderPass);
+    }
+};
+
+struct Globals {
+	bool VALIDATION = false;
+	bool DEBUG_MESSENGER = false;
+	u32 FRAMES_IN_FLIGHT = 1;
+
+	VkDebugUtilsMessengerEXT debugMessenger;
+
+	Scope scope;
+};
+
+struct InstanceData {
+    u32 textureIndex;
+};
+
+struct UniformBuffer {
+    mat4x4 model;
+    mat4x4 view;
+    mat4x4 proj;
+};
+
+// laid out for DescriptorTemplate, one entry per binding of descriptorSetLayout
+struct FrameDescriptorData {
+    VkDescriptorBufferInfo uniform;
+    VkDescriptorImageInfo texture;
+};
+
+struct Camera {
+    vec3 pos;
+    vec3 rot;
+    
+    float fov;
+    float near, far;
+};
+
+// Updates `count` sets shaped like descriptorSetLayout three ways: a vkUpdateDescriptorSets per set, one batched
+// vkUpdateDescriptorSets for all of them, and one template update per set. Best of several runs is reported.
+void benchmarkDescriptorUpdates(VkDevice device, VkDescriptorSetLayout layout, DescriptorTemplate const& descriptorTemplate, FrameDescriptorData const& data, bool withTexture, u32 count) {
+    VkDescriptorPoolSize poolSizes[2];
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].descriptorCount = count;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = count;
+    
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = count;
+    poolInfo.poolSizeCount = withTexture ? 2 : 1;
+    poolInfo.pPoolSizes = poolSizes;
+    
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device, &poolInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &pool) != VK_SUCCESS) {
+        return;
+    }
+    
+    std::vector<VkDescriptorSetLayout> layouts(count, layout);
+    std::vector<VkDescriptorSet> sets(count);
+    
+    VkDescriptorSetAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool = pool;
+    allocateInfo.descriptorSetCount = count;
+    allocateInfo.pSetLayouts = layouts.data();
+    
+    if (vkAllocateDescriptorSets(device, &allocateInfo, sets.data()) != VK_SUCCESS) {
+        vkDestroyDescriptorPool(device, pool, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+        return;
+    }
+    
+    const u32 runs = 10;
+    f64 perSetBest = std::numeric_limits<f64>::max();
+    f64 batchedBest = std::numeric_limits<f64>::max();
+    f64 templateBest = std::numeric_limits<f64>::max();
+    
+    DescriptorWriter writer(device);
+    writer.reserve(count * 2);
+    
+    for (u32 run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (u32 i = 0; i < count; ++i) {
+            VkWriteDescriptorSet writes[2] = {};
+            writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[0].dstSet = sets[i];
+            writes[0].dstBinding = 0;
+            writes[0].descriptorCount = 1;
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[0].pBufferInfo = &data.uniform;
+            writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[1].dstSet = sets[i];
+            writes[1].dstBinding = 1;
+            writes[1].descriptorCount = 1;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[1].pImageInfo = &data.texture;
+            
+            vkUpdateDescriptorSets(device, withTexture ? 2 : 1, writes, 0, nullptr);
+        }
+        perSetBest = std::min(perSetBest, std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count());
+        
+        start = std::chrono::steady_clock::now();
+        for (u32 i = 0; i < count; ++i) {
+            writer.writeBuffer(sets[i], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, data.uniform.buffer, data.uniform.offset, data.uniform.range);
+            if (withTexture) {
+                writer.writeImage(sets[i], 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, data.texture.imageView, data.texture.sampler, data.texture.imageLayout);
+            }
+        }
+        writer.flush();
+        batchedBest = std::min(batchedBest, std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count());
+        
+        if (descriptorTemplate.isCreated()) {
+            start = std::chrono::steady_clock::now();
+            for (u32 i = 0; i < count; ++i) {
+                descriptorTemplate.update(sets[i], &data);
+            }
+            templateBest = std::min(templateBest, std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    
+    std::cout << "Descriptor update benchmark, " << count << " sets, best of " << runs << " runs:\n";
+    std::cout << "    per-set vkUpdateDescriptorSets: " << perSetBest << " us (" << perSetBest * 1000.0 / count << " ns/set)\n";
+    std::cout << "    batched vkUpdateDescriptorSets: " << batchedBest << " us (" << batchedBest * 1000.0 / count << " ns/set)\n";
+    if (descriptorTemplate.isCreated()) {
+        std::cout << "    update template:                " << templateBest << " us (" << templateBest * 1000.0 / count << " ns/set)\n";
+    } else {
+        std::cout << "    update template:                unsupported\n";
+    }
+    
+    vkDestroyDescriptorPool(device, pool, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+}
+
+// Color and depth target compatible with the main render pass, so benchmarks can reuse the main pipelines without
+// depending on presentation. Layouts and load/store ops don't take part in render pass compatibility, formats and
+// sample counts do. Everything created here is released with the target.
+struct OffscreenTarget {
+    Scope scope;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkExtent2D extent = {};
+    VkImage depthImage = VK_NULL_HANDLE;
+    VkImageView depthView = VK_NULL_HANDLE;
+        
+    bool create(VkDevice device, VkPhysicalDevice physicalDevice, VkFormat colorFormat, VkFormat depthFormat, VkExtent2D targetExtent, VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+        extent = targetExtent;
+        
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        
+        auto createAttachment = [&](VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage* image, VkImageView* view) -> bool {
+            VkImageCreateInfo imageInfo = {};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = format;
+            imageInfo.extent = { extent.width, extent.height, 1 };
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = usage;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        
+            if (vkCreateImage(device, &imageInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE), image) != VK_SUCCESS) {
+                return false;
+            }
+            scope.addMess(vkDestroyImage, device, *image, hostAllocator(VK_OBJECT_TYPE_IMAGE));
+        
+            VkMemoryRequirements memoryRequirements;
+            vkGetImageMemoryRequirements(device, *image, &memoryRequirements);
+        
+            VkDeviceMemory memory;
+            if (!allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_TARGETS, &memory)) {
+                return false;
+            }
+            scope.addMess(freeMemory, device, memory);
+            vkBindImageMemory(device, *image, memory, 0);
+        
+            VkImageViewCreateInfo viewInfo = {};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = *image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = format;
+            viewInfo.subresourceRange.aspectMask = aspect;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.layerCount = 1;
+        
+            if (vkCreateImageView(device, &viewInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), view) != VK_SUCCESS) {
+                return false;
+            }
+            scope.addMess(vkDestroyImageView, device, *view, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+            return true;
+        };
+        
+        VkImage colorImage;
+        VkImageView attachments[2];
+        if (!createAttachment(colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT, &colorImage, &attachments[0]) || !createAttachment(depthFormat, depthUsage, VK_IMAGE_ASPECT_DEPTH_BIT, &depthImage, &attachments[1])) {
+            return false;
+        }
+        depthView = attachments[1];
+        
+        VkAttachmentDescription attachmentDescriptions[2] = {};
+        attachmentDescriptions[0].format = colorFormat;
+        attachmentDescriptions[0].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachmentDescriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachmentDescriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachmentDescriptions[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachmentDescriptions[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachmentDescriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachmentDescriptions[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachmentDescriptions[1].format = depthFormat;
+        attachmentDescriptions[1].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachmentDescriptions[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachmentDescriptions[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachmentDescriptions[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachmentDescriptions[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachmentDescriptions[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachmentDescriptions[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        
+        VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorReference;
+        subpass.pDepthStencilAttachment = &depthReference;
+        
+        VkRenderPassCreateInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 2;
+        renderPassInfo.pAttachments = attachmentDescriptions;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        
+        if (vkCreateRenderPass(device, &renderPassInfo, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS), &renderPass) != VK_SUCCESS) {
+            return false;
+        }
+        scope.addMess(vkDestroyRenderPass, device, renderPass, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS));
+        
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 2;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+        
+        if (vkCreateFramebuffer(device, &framebufferInfo, hostAllocator(VK_OBJECT_TYPE_FRAMEBUFFER), &framebuffer) != VK_SUCCESS) {
+            return false;
+        }
+        scope.addMess(vkDestroyFramebuffer, device, framebuffer, hostAllocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+        
+        return true;
+    }
+};
+
+// Draws `layers` overlapping full-screen quads into an offscreen target three ways: back to front, front to back,
+// and front to back behind a depth-only prepass with an equal-test shading pass. Fragment shader invocations come
+// from a pipeline statistics query and GPU time from timestamps, each only where the device supports it.
+void benchmarkDepthPrepass(VkDevice device, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkQueue queue, u32 queueFamilyIndex, OffscreenTarget const& target, VkPipelineLayout pipelineLayout, VkPipeline depthTestPipeline, VkPipeline prepassPipeline, VkPipeline equalPipeline, VkDescriptorSet const* sets, u32 setCount, VkBuffer instanceBuffer, VertexFormat const& vertexFormat, u32 layers) {
+    Scope scope;
+    
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    
+    VkRenderPass renderPass = target.renderPass;
+    VkFramebuffer framebuffer = target.framebuffer;
+    VkExtent2D extent = target.extent;
+    
+    // every layer covers the whole target, layer i sits at depth (i + 0.5) / layers
+    std::vector<Vertex> vertices(layers * 4);
+    std::vector<DrawItem> draws(layers);
+    for (u32 i = 0; i < layers; ++i) {
+        f32 z = (static_cast<f32>(i) + 0.5f) / static_cast<f32>(layers);
+        f32 shade = static_cast<f32>(i) / static_cast<f32>(layers);
+        vertices[i * 4 + 0] = { -1.0f, -1.0f, z, shade, 1.0f - shade, 0.5f, 0.0f, 0.0f };
+        vertices[i * 4 + 1] = { 1.0f, -1.0f, z, shade, 1.0f - shade, 0.5f, 1.0f, 0.0f };
+        vertices[i * 4 + 2] = { -1.0f, 1.0f, z, shade, 1.0f - shade, 0.5f, 0.0f, 1.0f };
+        vertices[i * 4 + 3] = { 1.0f, 1.0f, z, shade, 1.0f - shade, 0.5f, 1.0f, 1.0f };
+        
+        // submitted farthest first, the worst case for a depth test
+        draws[layers - 1 - i] = { 6, 0, static_cast<s32>(i * 4), { 0.0f, 0.0f, z } };
+    }
+    u32 indices[] = { 0, 1, 2, 1, 2, 3 };
+    
+    std::vector<u8> encoded;
+    VertexDecode decode = encodeVertices(vertexFormat, vertices.data(), nullptr, static_cast<u32>(vertices.size()), encoded);
+    
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = encoded.size() + sizeof(indices);
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    
+    VkBuffer geometryBuffer;
+    if (vkCreateBuffer(device, &bufferInfo, hostAllocator(VK_OBJECT_TYPE_BUFFER), &geometryBuffer) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, geometryBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, geometryBuffer, &memoryRequirements);
+    
+    VkDeviceMemory geometryMemory;
+    // read by every vertex fetch of both passes, so from the GPU's own memory where the CPU can write it
+    if (!allocateMemory(device, memoryProperties, memoryRequirements, hostWriteMemory(memoryProperties, memoryRequirements.memoryTypeBits, memoryRequirements.size), MemoryBudget::CATEGORY_MESHES, &geometryMemory)) {
+        return;
+    }
+    scope.addMess(freeMemory, device, geometryMemory);
+    vkBindBufferMemory(device, geometryBuffer, geometryMemory, 0);
+    
+    void* mapped;
+    if (vkMapMemory(device, geometryMemory, 0, bufferInfo.size, 0, &mapped) != VK_SUCCESS) {
+        return;
+    }
+    memcpy(mapped, encoded.data(), encoded.size());
+    memcpy(reinterpret_cast<u8*>(mapped) + encoded.size(), indices, sizeof(indices));
+    vkUnmapMemory(device, geometryMemory);
+    
+    VkQueryPool statisticsPool = VK_NULL_HANDLE;
+    if (caps.pipelineStatistics) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        queryInfo.queryCount = 1;
+        queryInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+        
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &statisticsPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, statisticsPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            statisticsPool = VK_NULL_HANDLE;
+        }
+    }
+    
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    if (caps.timestampPeriod > 0.0f) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
+        
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, timestampPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            timestampPool = VK_NULL_HANDLE;
+        }
+    }
+    
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    
+    VkViewport viewport = { 0.0f, 0.0f, static_cast<f32>(extent.width), static_cast<f32>(extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, extent };
+    
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    
+    struct Result {
+        u64 fragmentInvocations = 0;
+        f64 bestMs = std::numeric_limits<f64>::max();
+    };
+    
+    const u32 runs = 10;
+    auto measure = [&](std::vector<DrawItem> const& order, bool prepass) -> Result {
+        Result r;
+        for (u32 run = 0; run < runs; ++run) {
+            vkResetCommandBuffer(commandBuffer, 0);
+            
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            
+            if (statisticsPool != VK_NULL_HANDLE) {
+                vkCmdResetQueryPool(commandBuffer, statisticsPool, 0, 1);
+            }
+            if (timestampPool != VK_NULL_HANDLE) {
+                vkCmdResetQueryPool(commandBuffer, timestampPool, 0, 2);
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
+            }
+            
+            VkRenderPassBeginInfo renderPassBeginInfo = {};
+            renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassBeginInfo.renderPass = renderPass;
+            renderPassBeginInfo.framebuffer = framebuffer;
+            renderPassBeginInfo.renderArea.extent = extent;
+            renderPassBeginInfo.clearValueCount = 2;
+            renderPassBeginInfo.pClearValues = clearValues;
+            
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometryBuffer, &offset);
+            if (instanceBuffer != VK_NULL_HANDLE) {
+                vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &offset);
+            }
+            vkCmdBindIndexBuffer(commandBuffer, geometryBuffer, encoded.size(), VK_INDEX_TYPE_UINT32);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexDecode), &decode);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, setCount, sets, 0, nullptr);
+            
+            if (statisticsPool != VK_NULL_HANDLE) {
+                vkCmdBeginQuery(commandBuffer, statisticsPool, 0, 0);
+            }
+            
+            if (prepass) {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, prepassPipeline);
+                for (DrawItem const& draw : order) {
+                    vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, draw.vertexOffset, 0);
+                }
+            }
+            
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, prepass ? equalPipeline : depthTestPipeline);
+            for (DrawItem const& draw : order) {
+                vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, draw.vertexOffset, 0);
+            }
+            
+            if (statisticsPool != VK_NULL_HANDLE) {
+                vkCmdEndQuery(commandBuffer, statisticsPool, 0);
+            }
+            vkCmdEndRenderPass(commandBuffer);
+            
+            if (timestampPool != VK_NULL_HANDLE) {
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
+            }
+            vkEndCommandBuffer(commandBuffer);
+            
+            VkSubmitInfo submitInfo = {};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+            vkQueueWaitIdle(queue);
+            
+            if (statisticsPool != VK_NULL_HANDLE) {
+                vkGetQueryPoolResults(device, statisticsPool, 0, 1, sizeof(u64), &r.fragmentInvocations, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+            }
+            if (timestampPool != VK_NULL_HANDLE) {
+                u64 timestamps[2];
+                vkGetQueryPoolResults(device, timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+                r.bestMs = std::min(r.bestMs, static_cast<f64>(timestamps[1] - timestamps[0]) * caps.timestampPeriod / 1000000.0);
+            }
+        }
+        
+        return r;
+    };
+    
+    Result backToFront = measure(draws, false);
+    
+    mat4x4 identity;
+    mat4x4_identity(identity);
+    std::vector<DrawItem> sorted = draws;
+    sortFrontToBack(sorted, identity);
+    
+    Result frontToBack = measure(sorted, false);
+    Result prepass = measure(sorted, true);
+    
+    auto print = [&](const char* name, Result const& r) {
+        std::cout << "    " << name;
+        if (statisticsPool != VK_NULL_HANDLE) {
+            std::cout << r.fragmentInvocations << " fragment invocations";
+            if (backToFront.fragmentInvocations != 0) {
+                std::cout << " (" << 100.0 * static_cast<f64>(r.fragmentInvocations) / static_cast<f64>(backToFront.fragmentInvocations) << "%)";
+            }
+        } else {
+            std::cout << "fragment invocations unavailable";
+        }
+        
+        if (timestampPool != VK_NULL_HANDLE) {
+            std::cout << ", " << r.bestMs << " ms";
+        }
+        std::cout << "\n";
+    };
+    
+    std::cout << "Overdraw benchmark, " << layers << " full-screen layers at " << extent.width << "x" << extent.height << ", best of " << runs << " runs:\n";
+    print("back to front:          ", backToFront);
+    print("front to back:          ", frontToBack);
+    print("depth prepass + equal:  ", prepass);
+}
+
+// Spreads `count` bounding spheres uniformly through the box [min, max], all drawing the same mesh range.
+std::vector<CullObject> generateCullObjects(u32 count, f32 const min[3], f32 const max[3], f32 minRadius, f32 maxRadius, MeshRange const& mesh, u32 textureIndex) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<f32> x(min[0], max[0]);
+    std::uniform_real_distribution<f32> y(min[1], max[1]);
+    std::uniform_real_distribution<f32> z(min[2], max[2]);
+    std::uniform_real_distribution<f32> radius(minRadius, maxRadius);
+    
+    std::vector<CullObject> objects(count);
+    for (CullObject& o : objects) {
+        o.sphere[0] = x(rng);
+        o.sphere[1] = y(rng);
+        o.sphere[2] = z(rng);
+        o.sphere[3] = radius(rng);
+        o.indexCount = mesh.indexCount;
+        o.firstIndex = mesh.firstIndex;
+        o.vertexOffset = mesh.vertexOffset;
+        o.textureIndex = textureIndex;
+    }
+    
+    return objects;
+}
+
+// Renders 100k and 1M objects scattered around a turning camera into an offscreen target, culled two ways: on the
+// CPU into a host visible indirect buffer with the command buffer re-recorded every frame, and by GpuCuller from a
+// command buffer recorded once. Frame time is measured from the start of the frame's CPU work until the queue is idle.
+void benchmarkFrustumCulling(VkDevice device, VkQueue queue, u32 queueFamilyIndex, VkPhysicalDeviceMemoryProperties const& memoryProperties, OffscreenTarget const& target, VkPipelineLayout pipelineLayout, VkPipeline culledPipeline, VkDescriptorSet const* sets, u32 setCount, void* uniformMapped, GpuCuller& culler, GeometryPool const& geometry, MeshRange const& mesh) {
+    Scope scope;
+    
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = sizeof(VkDrawIndexedIndirectCommand) * culler.objectCapacity;
+    bufferInfo.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    
+    VkBuffer cpuCommandBuffer;
+    if (vkCreateBuffer(device, &bufferInfo, hostAllocator(VK_OBJECT_TYPE_BUFFER), &cpuCommandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, cpuCommandBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, cpuCommandBuffer, &memoryRequirements);
+    
+    VkDeviceMemory cpuCommandMemory;
+    if (!allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_OTHER, &cpuCommandMemory)) {
+        return;
+    }
+    scope.addMess(freeMemory, device, cpuCommandMemory);
+    vkBindBufferMemory(device, cpuCommandBuffer, cpuCommandMemory, 0);
+    
+    VkDrawIndexedIndirectCommand* cpuCommands;
+    if (vkMapMemory(device, cpuCommandMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&cpuCommands)) != VK_SUCCESS) {
+        return;
+    }
+    
+    UniformBuffer uniform = {};
+    mat4x4_identity(uniform.model);
+    mat4x4_perspective(uniform.proj, 75.0f * 3.14159265f / 180.0f, static_cast<f32>(target.extent.width) / static_cast<f32>(target.extent.height), 0.1f, 1000.0f);
+    
+    // linmath builds GL style clip space, remap z from [-w, w] to [0, w]
+    mat4x4 depthRemap;
+    mat4x4_identity(depthRemap);
+    depthRemap[2][2] = 0.5f;
+    depthRemap[3][2] = 0.5f;
+    mat4x4_mul(uniform.proj, depthRemap, uniform.proj);
+    
+    VkViewport viewport = { 0.0f, 0.0f, static_cast<f32>(target.extent.width), static_cast<f32>(target.extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, target.extent };
+    
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    
+    auto beginFrame = [&](u32 frame, mat4x4 viewProj) {
+        mat4x4_identity(uniform.view);
+        mat4x4_rotate_Y(uniform.view, uniform.view, static_cast<f32>(frame) * 0.02f);
+        memcpy(uniformMapped, &uniform, sizeof(UniformBuffer));
+        
+        mat4x4_mul(viewProj, uniform.proj, uniform.view);
+    };
+    
+    auto recordScene = [&](bool gpu, u32 cpuDrawCount) {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        
+        if (gpu) {
+            culler.recordCull(commandBuffer, 0);
+        }
+        
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = target.renderPass;
+        renderPassBeginInfo.framebuffer = target.framebuffer;
+        renderPassBeginInfo.renderArea.extent = target.extent;
+        renderPassBeginInfo.clearValueCount = 2;
+        renderPassBeginInfo.pClearValues = clearValues;
+        
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, culledPipeline);
+        
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, &culler.objectBuffer, &offset);
+        geometry.bind(commandBuffer, mesh.indexType);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexDecode), &mesh.decode);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, setCount, sets, 0, nullptr);
+        
+        if (gpu) {
+            culler.recordDraw(commandBuffer, 0);
+        } else if (culler.multiDraw) {
+            vkCmdDrawIndexedIndirect(commandBuffer, cpuCommandBuffer, 0, cpuDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+        } else {
+            for (u32 i = 0; i < cpuDrawCount; ++i) {
+                vkCmdDrawIndexedIndirect(commandBuffer, cpuCommandBuffer, sizeof(VkDrawIndexedIndirectCommand) * i, 1, sizeof(VkDrawIndexedIndirectCommand));
+            }
+        }
+        
+        vkCmdEndRenderPass(commandBuffer);
+        vkEndCommandBuffer(commandBuffer);
+    };
+    
+    auto submit = [&]() {
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(queue);
+    };
+    
+    const u32 frames = 120;
+    const f32 boxMin[3] = { -500.0f, -500.0f, -500.0f };
+    const f32 boxMax[3] = { 500.0f, 500.0f, 500.0f };
+    
+    std::cout << "Frustum culling benchmark, " << frames << " frames per run" << (culler.compact ? "" : ", no draw count buffer") << ":\n";
+    for (u32 count : { 100000u, 1000000u }) {
+        if (count > culler.objectCapacity) {
+            continue;
+        }
+        
+        std::vector<CullObject> objects = generateCullObjects(count, boxMin, boxMax, 0.5f, 2.0f, mesh, 0);
+        culler.setObjects(objects.data(), count);
+        
+        CullUniform cpuUniform = {};
+        cpuUniform.objectCount = count;
+        
+        f64 cpuFrameMs = 0.0;
+        f64 cpuCullMs = 0.0;
+        u64 cpuVisible = 0;
+        for (u32 frame = 0; frame < frames; ++frame) {
+            auto start = std::chrono::steady_clock::now();
+            
+            mat4x4 viewProj;
+            beginFrame(frame, viewProj);
+            extractFrustumPlanes(cpuUniform.planes, viewProj);
+            u32 drawCount = cullObjects(cpuUniform, objects.data(), cpuCommands);
+            cpuCullMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            cpuVisible += drawCount;
+            
+            vkResetCommandBuffer(commandBuffer, 0);
+            recordScene(false, drawCount);
+            submit();
+            cpuFrameMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        
+        vkResetCommandBuffer(commandBuffer, 0);
+        recordScene(true, 0);
+        
+        f64 gpuFrameMs = 0.0;
+        for (u32 frame = 0; frame < frames; ++frame) {
+            auto start = std::chrono::steady_clock::now();
+            
+            mat4x4 viewProj;
+            beginFrame(frame, viewProj);
+            culler.setFrustum(0, viewProj);
+            submit();
+            gpuFrameMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        
+        std::cout << "    " << count << " objects, " << cpuVisible / frames << " visible on average:\n";
+        std::cout << "        CPU culled: " << cpuFrameMs / frames << " ms/frame (" << cpuCullMs / frames << " ms culling)\n";
+        std::cout << "        GPU culled: " << gpuFrameMs / frames << " ms/frame\n";
+    }
+}
+
+// Puts a wall of tiles with a small window in front of 100k objects and renders it through the two-phase cull with
+// and without Hi-Z occlusion. The draw counts of both phases are read back after every frame and GPU time comes
+// from timestamps, or from CPU wall time around the submit where timestamps are unsupported.
+void benchmarkOcclusionCulling(VkDevice device, DeviceCaps const& caps, VkQueue queue, u32 queueFamilyIndex, VkPhysicalDeviceMemoryProperties const& memoryProperties, OffscreenTarget const& target, VkFormat depthFormat, VkRenderPass earlyPass, VkRenderPass latePass, HiZPyramid& pyramid, VkPipelineLayout pipelineLayout, VkPipeline culledPipeline, VkDescriptorSet const* sets, u32 setCount, void* uniformMapped, GpuCuller& culler, GeometryPool const& geometry, MeshRange const& mesh) {
+    Scope scope;
+    
+    VkViewport viewport = { 0.0f, 0.0f, static_cast<f32>(target.extent.width), static_cast<f32>(target.extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, target.extent };
+    
+    if (!pyramid.resize(target.depthImage, target.depthView, depthFormat, target.extent)) {
+        return;
+    }
+    culler.setPyramid(pyramid.view, pyramid.sampler, pyramid.levelCount, target.extent, viewport);
+    
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    if (caps.timestampPeriod > 0.0f) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
+        
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, timestampPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            timestampPool = VK_NULL_HANDLE;
+        }
+    }
+    
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    
+    // early and late draw counts land here after every frame
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = sizeof(u32) * 2;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    
+    VkBuffer readbackBuffer;
+    if (vkCreateBuffer(device, &bufferInfo, hostAllocator(VK_OBJECT_TYPE_BUFFER), &readbackBuffer) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, readbackBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, readbackBuffer, &memoryRequirements);
+    
+    VkDeviceMemory readbackMemory;
+    if (!allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_STAGING, &readbackMemory)) {
+        return;
+    }
+    scope.addMess(freeMemory, device, readbackMemory);
+    vkBindBufferMemory(device, readbackBuffer, readbackMemory, 0);
+    
+    u32* drawCounts;
+    if (vkMapMemory(device, readbackMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&drawCounts)) != VK_SUCCESS) {
+        return;
+    }
+    
+    // the wall spans [-4, 4] x [-3, 3] at z = -2 with a window in the middle, tiles overlap slightly so no depth
+    // cracks open between them. Everything else is scattered behind it.
+    const f32 tileHalfSize = 0.1f;
+    std::vector<CullObject> objects;
+    for (f32 y = -3.0f + tileHalfSize; y < 3.0f; y += tileHalfSize * 2.0f) {
+        for (f32 x = -4.0f + tileHalfSize; x < 4.0f; x += tileHalfSize * 2.0f) {
+            if (std::abs(x) < 0.6f && std::abs(y) < 0.4f) {
+                continue;
+            }
+            
+            CullObject tile = {};
+            tile.sphere[0] = x;
+            tile.sphere[1] = y;
+            tile.sphere[2] = -2.0f;
+            tile.sphere[3] = tileHalfSize * 1.02f / 0.70710678f;
+            tile.indexCount = mesh.indexCount;
+            tile.firstIndex = mesh.firstIndex;
+            tile.vertexOffset = mesh.vertexOffset;
+            objects.push_back(tile);
+        }
+    }
+    const u32 wallCount = static_cast<u32>(objects.size());
+    
+    const f32 behindMin[3] = { -30.0f, -20.0f, -60.0f };
+    const f32 behindMax[3] = { 30.0f, 20.0f, -6.0f };
+    std::vector<CullObject> behind = generateCullObjects(100000, behindMin, behindMax, 0.3f, 1.0f, mesh, 0);
+    objects.insert(objects.end(), behind.begin(), behind.end());
+    
+    const u32 objectCount = std::min(static_cast<u32>(objects.size()), culler.objectCapacity);
+    culler.setObjects(objects.data(), objectCount);
+    
+    UniformBuffer uniform = {};
+    mat4x4_identity(uniform.model);
+    mat4x4_perspective(uniform.proj, 75.0f * 3.14159265f / 180.0f, static_cast<f32>(target.extent.width) / static_cast<f32>(target.extent.height), 0.1f, 1000.0f);
+    
+    // linmath builds GL style clip space, remap z from [-w, w] to [0, w]
+    mat4x4 depthRemap;
+    mat4x4_identity(depthRemap);
+    depthRemap[2][2] = 0.5f;
+    depthRemap[3][2] = 0.5f;
+    mat4x4_mul(uniform.proj, depthRemap, uniform.proj);
+    
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    
+    auto beginPass = [&](VkRenderPass renderPass) {
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = renderPass;
+        renderPassBeginInfo.framebuffer = target.framebuffer;
+        renderPassBeginInfo.renderArea.extent = target.extent;
+        renderPassBeginInfo.clearValueCount = 2;
+        renderPassBeginInfo.pClearValues = clearValues;
+        
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    };
+    
+    // without occlusion the pyramid isn't built and the late phase only picks up objects entering the frustum
+    auto recordFrame = [&](bool occlusion) {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, timestampPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
+        }
+        
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, &culler.objectBuffer, &offset);
+        geometry.bind(commandBuffer, mesh.indexType);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexDecode), &mesh.decode);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, setCount, sets, 0, nullptr);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, culledPipeline);
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        
+        culler.recordCull(commandBuffer, 0, GpuCuller::EARLY);
+        beginPass(earlyPass);
+        culler.recordDraw(commandBuffer, 0, GpuCuller::EARLY);
+        vkCmdEndRenderPass(commandBuffer);
+        
+        if (occlusion) {
+            pyramid.record(commandBuffer);
+        }
+        
+        culler.recordCull(commandBuffer, 0, GpuCuller::LATE);
+        beginPass(latePass);
+        culler.recordDraw(commandBuffer, 0, GpuCuller::LATE);
+        vkCmdEndRenderPass(commandBuffer);
+        
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
+        }
+        
+        VkMemoryBarrier countBarrier = {};
+        countBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        countBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        countBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &countBarrier, 0, nullptr, 0, nullptr);
+        
+        VkBufferCopy copy = { 0, 0, sizeof(u32) };
+        vkCmdCopyBuffer(commandBuffer, culler.frames[0].countBuffer, readbackBuffer, 1, &copy);
+        copy.dstOffset = sizeof(u32);
+        vkCmdCopyBuffer(commandBuffer, culler.frames[0].lateCountBuffer, readbackBuffer, 1, &copy);
+        
+        vkEndCommandBuffer(commandBuffer);
+    };
+    
+    struct Result {
+        f64 ms = 0.0;
+        u64 earlyDraws = 0;
+        u64 lateDraws = 0;
+    };
+    
+    // the camera sways a little so the late phase keeps finding objects that come into view through the window
+    const u32 frames = 120;
+    auto measure = [&](bool occlusion) -> Result {
+        culler.setOcclusionEnabled(occlusion);
+        culler.setObjects(objects.data(), objectCount);
+        
+        vkResetCommandBuffer(commandBuffer, 0);
+        recordFrame(occlusion);
+        
+        Result r;
+        for (u32 frame = 0; frame < frames; ++frame) {
+            mat4x4_identity(uniform.view);
+            mat4x4_rotate_Y(uniform.view, uniform.view, std::sin(static_cast<f32>(frame) * 0.05f) * 0.1f);
+            memcpy(uniformMapped, &uniform, sizeof(UniformBuffer));
+            
+            mat4x4 viewProj;
+            mat4x4_mul(viewProj, uniform.proj, uniform.view);
+            culler.setFrustum(0, viewProj);
+            
+            auto start = std::chrono::steady_clock::now();
+            VkSubmitInfo submitInfo = {};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+            vkQueueWaitIdle(queue);
+            
+            if (timestampPool != VK_NULL_HANDLE) {
+                u64 timestamps[2];
+                vkGetQueryPoolResults(device, timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+                r.ms += static_cast<f64>(timestamps[1] - timestamps[0]) * caps.timestampPeriod / 1000000.0;
+            } else {
+                r.ms += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            
+            r.earlyDraws += drawCounts[0];
+            r.lateDraws += drawCounts[1];
+        }
+        
+        r.ms /= frames;
+        r.earlyDraws /= frames;
+        r.lateDraws /= frames;
+        return r;
+    };
+    
+    Result frustum = measure(false);
+    Result occlusion = measure(true);
+    
+    u64 frustumDraws = frustum.earlyDraws + frustum.lateDraws;
+    u64 occlusionDraws = occlusion.earlyDraws + occlusion.lateDraws;
+    
+    std::cout << "Occlusion culling benchmark, " << objectCount << " objects (" << wallCount << " wall tiles), " << pyramid.levelCount << " Hi-Z levels, "
+              << frames << " frames at " << target.extent.width << "x" << target.extent.height << (timestampPool != VK_NULL_HANDLE ? ", GPU time" : ", CPU time") << ":\n";
+    std::cout << "    frustum only:    " << frustumDraws << " draws, " << frustum.ms << " ms/frame\n";
+    std::cout << "    Hi-Z two-phase:  " << occlusionDraws << " draws (" << occlusion.earlyDraws << " early + " << occlusion.lateDraws << " late), " << occlusion.ms << " ms/frame\n";
+    std::cout << "    culled by Hi-Z:  " << (frustumDraws > occlusionDraws ? frustumDraws - occlusionDraws : 0) << " draws, saved " << frustum.ms - occlusion.ms << " ms/frame\n";
+}
+
+// Draws a dense grid of about 590k vertices `repeats` times per frame into an offscreen target, with triangles
+// around a pixel in size and every repeat failing the depth test, so vertex fetch dominates. Three layouts: full
+// 32 byte vertices with 32 bit indices, compact vertices with 32 bit indices, and compact vertices split into
+// 256x256 vertex chunks, which the geometry pool stores with 16 bit indices. pipelines[i] reads formats[i].
+void benchmarkVertexCompression(VkDevice device, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkQueue queue, u32 queueFamilyIndex, OffscreenTarget const& target, VkPipelineLayout pipelineLayout, VkPipeline const pipelines[2], VertexFormat const formats[2], VkDescriptorSet const* sets, u32 setCount, VkBuffer instanceBuffer) {
+    Scope scope;
+    
+    const u32 chunkSize = 256;
+    const u32 chunks = 3;
+    const u32 gridSize = chunks * (chunkSize - 1) + 1;
+    const u32 repeats = 8;
+    
+    auto gridVertex = [&](u32 x, u32 y) -> Vertex {
+        f32 u = static_cast<f32>(x) / static_cast<f32>(gridSize - 1);
+        f32 v = static_cast<f32>(y) / static_cast<f32>(gridSize - 1);
+        f32 z = 0.5f + 0.25f * std::sin(u * 12.0f) * std::cos(v * 9.0f);
+        return { u * 2.0f - 1.0f, v * 2.0f - 1.0f, z, u, v, 1.0f - u, u, v };
+    };
+    
+    // vertices [x0, x0 + width) x [y0, y0 + height) of the grid as one mesh with its own indices
+    auto buildMesh = [&](u32 x0, u32 y0, u32 width, u32 height, std::vector<Vertex>& vertices, std::vector<u32>& indices) {
+        vertices.clear();
+        indices.clear();
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                vertices.push_back(gridVertex(x0 + x, y0 + y));
+            }
+        }
+        for (u32 y = 0; y + 1 < height; ++y) {
+            for (u32 x = 0; x + 1 < width; ++x) {
+                u32 i = y * width + x;
+                u32 quad[6] = { i, i + 1, i + width, i + 1, i + width, i + width + 1 };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    };
+    
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    if (caps.timestampPeriod > 0.0f) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
+        
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, timestampPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            timestampPool = VK_NULL_HANDLE;
+        }
+    }
+    
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    
+    auto submitAndWait = [&]() {
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(queue);
+    };
+    
+    VkViewport viewport = { 0.0f, 0.0f, static_cast<f32>(target.extent.width), static_cast<f32>(target.extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, target.extent };
+    
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    
+    struct Result {
+        u32 stride = 0;
+        u64 vertexBytes = 0;
+        u64 indexBytes = 0;
+        f64 ms = 0.0;
+    };
+    
+    const u32 frames = 60;
+    auto measure = [&](u32 formatIndex, bool chunked) -> Result {
+        VertexFormat const& format = formats[formatIndex];
+        Result r;
+        r.stride = format.stride();
+        
+        GeometryPool pool;
+        if (!pool.create(device, physicalDevice, format.stride(), 1 << 20, 1 << 22, 1, 48 << 20, { queueFamilyIndex })) {
+            return r;
+        }
+        
+        std::vector<Vertex> vertices;
+        std::vector<u32> indices;
+        std::vector<u8> encoded;
+        std::vector<u32> meshes;
+        auto addMesh = [&]() {
+            encoded.clear();
+            VertexDecode decode = encodeVertices(format, vertices.data(), nullptr, static_cast<u32>(vertices.size()), encoded);
+            u32 mesh = pool.addMesh(encoded.data(), static_cast<u32>(vertices.size()), indices.data(), static_cast<u32>(indices.size()), decode);
+            if (mesh != GeometryPool::INVALID_MESH) {
+                MeshRange const& range = pool.mesh(mesh);
+                meshes.push_back(mesh);
+                r.vertexBytes += static_cast<u64>(range.vertexCount) * format.stride();
+                r.indexBytes += static_cast<u64>(range.indexCount) * (range.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(u16) : sizeof(u32));
+            }
+        };
+        
+        if (chunked) {
+            for (u32 cy = 0; cy < chunks; ++cy) {
+                for (u32 cx = 0; cx < chunks; ++cx) {
+                    buildMesh(cx * (chunkSize - 1), cy * (chunkSize - 1), chunkSize, chunkSize, vertices, indices);
+                    addMesh();
+                }
+            }
+        } else {
+            buildMesh(0, 0, gridSize, gridSize, vertices, indices);
+            addMesh();
+        }
+        // every mesh failed to fit the pool, nothing to bind or draw, so the format reports no data and no time
+        if (meshes.empty()) {
+            return r;
+        }
+        
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        pool.recordUploads(commandBuffer);
+        vkEndCommandBuffer(commandBuffer);
+        submitAndWait();
+        
+        vkResetCommandBuffer(commandBuffer, 0);
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, timestampPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
+        }
+        
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = target.renderPass;
+        renderPassBeginInfo.framebuffer = target.framebuffer;
+        renderPassBeginInfo.renderArea.extent = target.extent;
+        renderPassBeginInfo.clearValueCount = 2;
+        renderPassBeginInfo.pClearValues = clearValues;
+        
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[formatIndex]);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, setCount, sets, 0, nullptr);
+        if (instanceBuffer != VK_NULL_HANDLE) {
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &offset);
+        }
+        
+        // all meshes of one run share an index type, so the pool is bound once
+        pool.bind(commandBuffer, pool.mesh(meshes[0]).indexType);
+        for (u32 repeat = 0; repeat < repeats; ++repeat) {
+            for (u32 mesh : meshes) {
+                MeshRange const& range = pool.mesh(mesh);
+                vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexDecode), &range.decode);
+                vkCmdDrawIndexed(commandBuffer, range.indexCount, 1, range.firstIndex, range.vertexOffset, 0);
+            }
+        }
+        vkCmdEndRenderPass(commandBuffer);
+        
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
+        }
+        vkEndCommandBuffer(commandBuffer);
+        
+        for (u32 frame = 0; frame < frames; ++frame) {
+            auto start = std::chrono::steady_clock::now();
+            submitAndWait();
+            
+            if (timestampPool != VK_NULL_HANDLE) {
+                u64 timestamps[2];
+                vkGetQueryPoolResults(device, timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+                r.ms += static_cast<f64>(timestamps[1] - timestamps[0]) * caps.timestampPeriod / 1000000.0;
+            } else {
+                r.ms += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+        vkResetCommandBuffer(commandBuffer, 0);
+        
+        r.ms /= frames;
+        return r;
+    };
+    
+    Result full = measure(0, false);
+    Result compact = measure(1, false);
+    Result compactShort = measure(1, true);
+    
+    std::cout << "Vertex format benchmark, " << gridSize * gridSize << " vertices drawn " << repeats << " times, " << frames << " frames at "
+              << target.extent.width << "x" << target.extent.height << (timestampPool != VK_NULL_HANDLE ? ", GPU time" : ", CPU time") << ":\n";
+    auto print = [&](const char* name, Result const& r) {
+        f64 megabytes = static_cast<f64>(r.vertexBytes + r.indexBytes) * repeats / (1024.0 * 1024.0);
+        f64 ratio = r.vertexBytes + r.indexBytes > 0 ? static_cast<f64>(full.vertexBytes + full.indexBytes) / static_cast<f64>(r.vertexBytes + r.indexBytes) : 0.0;
+        std::cout << "    " << name << r.stride << " B/vertex, " << megabytes << " MB vertex + index data/frame (" << ratio << "x reduction), " << r.ms << " ms/frame\n";
+    };
+    print("full, 32 bit indices:     ", full);
+    print("compact, 32 bit indices:  ", compact);
+    print("compact, 16 bit chunks:   ", compactShort);
+}
+
+// Picks levels for a million instances spread around the eye, four at a time and one at a time. Pure CPU work, the
+// chain is made up: every level a quarter of the error budget of the next and half the triangles of the previous.
+void benchmarkLodSelection(u32 count, f32 fovY, f32 viewportHeight) {
+    LodChain chain;
+    chain.count = LodChain::MAX_LODS;
+    for (u32 k = 0; k < chain.count; ++k) {
+        chain.firstIndex[k] = 0;
+        chain.indexCount[k] = (3 * 4096) >> k;
+        chain.error[k] = k == 0 ? 0.0f : 0.001f * static_cast<f32>(1u << (2 * k));
+    }
+    
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<f32> coordinate(-200.0f, 200.0f);
+    std::vector<f32> x(count);
+    std::vector<f32> y(count);
+    std::vector<f32> z(count);
+    for (u32 i = 0; i < count; ++i) {
+        x[i] = coordinate(random);
+        y[i] = coordinate(random);
+        z[i] = coordinate(random);
+    }
+    
+    const f32 eye[3] = { 0.0f, 0.0f, 0.0f };
+    const f32 scale = lodProjectionScale(fovY, viewportHeight);
+    std::vector<u8> simd(count);
+    std::vector<u8> scalar(count);
+    
+    const u32 runs = 20;
+    f64 simdBest = std::numeric_limits<f64>::max();
+    f64 scalarBest = std::numeric_limits<f64>::max();
+    u64 simdTriangles = 0;
+    u64 scalarTriangles = 0;
+    for (u32 run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        simdTriangles = selectLods(chain, x.data(), y.data(), z.data(), count, eye, scale, 1.0f, simd.data());
+        simdBest = std::min(simdBest, std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+        
+        start = std::chrono::steady_clock::now();
+        scalarTriangles = selectLodsScalar(chain, x.data(), y.data(), z.data(), count, eye, scale, 1.0f, scalar.data());
+        scalarBest = std::min(scalarBest, std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    
+    u32 histogram[LodChain::MAX_LODS] = {};
+    for (u8 lod : simd) {
+        ++histogram[lod];
+    }
+    
+    std::cout << "LOD selection benchmark, " << count << " instances, best of " << runs << " runs at " << viewportHeight << " px high:\n";
+    std::cout << "    batched: " << simdBest << " ms, scalar: " << scalarBest << " ms (" << scalarBest / simdBest << "x)"
+              << (simd == scalar && simdTriangles == scalarTriangles ? "" : ", RESULTS DIFFER") << "\n";
+    std::cout << "    " << simdTriangles << " triangles instead of " << static_cast<u64>(count) * (chain.indexCount[0] / 3) << " at full detail, instances per level:";
+    for (u32 k = 0; k < chain.count; ++k) {
+        std::cout << " " << histogram[k];
+    }
+    std::cout << "\n";
+}
+
+// Fills a SpriteBatch with a million small sprites per frame from a few hundred procedural textures, one in eight
+// blended additively, once sorted by blend mode and page and once picking every sprite's texture at random, and
+// draws them into an offscreen target. The first scene is the fewest draws the batch can do, one per page and blend
+// mode; the second is the worst case, nearly every sprite changes page and starts its own draw.
+void benchmarkSpriteBatch(VkDevice device, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkQueue queue, u32 queueFamilyIndex, OffscreenTarget const& target) {
+    Scope scope;
+    
+    VkShaderModule vertexModule = VK_NULL_HANDLE;
+    VkShaderModule fragmentModule = VK_NULL_HANDLE;
+    if (!loadShaderModule(device, "assets/sprite.vert.spv", &vertexModule)) {
+        return;
+    }
+    scope.addMess(vkDestroyShaderModule, device, vertexModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    if (!loadShaderModule(device, "assets/sprite.frag.spv", &fragmentModule)) {
+        return;
+    }
+    scope.addMess(vkDestroyShaderModule, device, fragmentModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    
+    const u32 spriteCount = 1000000;
+    const u32 textureCount = 256;
+    SpriteBatch batch;
+    if (!batch.create(device, physicalDevice, target.renderPass, vertexModule, fragmentModule, spriteCount, 1, 512)) {
+        return;
+    }
+    
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    if (caps.timestampPeriod > 0.0f) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
+        
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, timestampPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            timestampPool = VK_NULL_HANDLE;
+        }
+    }
+    
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    
+    auto submitAndWait = [&]() {
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(queue);
+    };
+    
+    // checkerboards of random sizes and colours, in the order they were added; a small one can still land in a gap
+    // of an earlier page, so this isn't page order
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<u32> size(8, 64);
+    std::uniform_int_distribution<u32> channel(64, 255);
+    std::vector<AtlasRegion> regions;
+    std::vector<u8> pixels;
+    for (u32 i = 0; i < textureCount; ++i) {
+        u32 width = size(random);
+        u32 height = size(random);
+        u8 color[3] = { static_cast<u8>(channel(random)), static_cast<u8>(channel(random)), static_cast<u8>(channel(random)) };
+        pixels.resize(static_cast<size_t>(width) * height * 4);
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                u8* texel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+                bool dark = ((x / 4) ^ (y / 4)) & 1;
+                texel[0] = dark ? color[0] / 2 : color[0];
+                texel[1] = dark ? color[1] / 2 : color[1];
+                texel[2] = dark ? color[2] / 2 : color[2];
+                texel[3] = 255;
+            }
+        }
+        AtlasRegion region = batch.addTexture(pixels.data(), width, height);
+        if (region.isValid()) {
+            regions.push_back(region);
+        }
+    }
+    if (regions.empty()) {
+        return;
+    }
+    
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    batch.recordAtlasUploads(commandBuffer);
+    vkEndCommandBuffer(commandBuffer);
+    submitAndWait();
+    batch.finishAtlasUploads();
+    vkResetCommandBuffer(commandBuffer, 0);
+    
+    VkViewport viewport = { 0.0f, 0.0f, static_cast<f32>(target.extent.width), static_cast<f32>(target.extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, target.extent };
+    
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    
+    struct Result {
+        f64 fillMs = 0.0;
+        f64 frameMs = 0.0;
+        u32 draws = 0;
+    };
+    
+    // sprite i uses picks[i] and blends[i]; positions and sizes are the same in both scenes
+    std::vector<f32> positions(static_cast<size_t>(spriteCount) * 2);
+    std::uniform_real_distribution<f32> px(0.0f, static_cast<f32>(target.extent.width));
+    std::uniform_real_distribution<f32> py(0.0f, static_cast<f32>(target.extent.height));
+    for (u32 i = 0; i < spriteCount; ++i) {
+        positions[i * 2 + 0] = px(random);
+        positions[i * 2 + 1] = py(random);
+    }
+    
+    const u32 frames = 30;
+    auto measure = [&](std::vector<u32> const& picks, std::vector<SpriteBatch::Blend> const& blends) -> Result {
+        Result r;
+        for (u32 frame = 0; frame < frames; ++frame) {
+            auto start = std::chrono::steady_clock::now();
+            batch.begin(0);
+            for (u32 i = 0; i < spriteCount; ++i) {
+                AtlasRegion const& region = regions[picks[i]];
+                batch.draw(region, positions[i * 2 + 0], positions[i * 2 + 1], static_cast<f32>(region.width) * 0.25f, static_cast<f32>(region.height) * 0.25f, 0xffffffff, blends[i]);
+            }
+            r.fillMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            r.draws = batch.drawCount();
+            
+            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            if (timestampPool != VK_NULL_HANDLE) {
+                vkCmdResetQueryPool(commandBuffer, timestampPool, 0, 2);
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
+            }
+            
+            VkRenderPassBeginInfo renderPassBeginInfo = {};
+            renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassBeginInfo.renderPass = target.renderPass;
+            renderPassBeginInfo.framebuffer = target.framebuffer;
+            renderPassBeginInfo.renderArea.extent = target.extent;
+            renderPassBeginInfo.clearValueCount = 2;
+            renderPassBeginInfo.pClearValues = clearValues;
+            
+            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            batch.record(commandBuffer, viewport);
+            vkCmdEndRenderPass(commandBuffer);
+            
+            if (timestampPool != VK_NULL_HANDLE) {
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
+            }
+            vkEndCommandBuffer(commandBuffer);
+            
+            start = std::chrono::steady_clock::now();
+            submitAndWait();
+            if (timestampPool != VK_NULL_HANDLE) {
+                u64 timestamps[2];
+                vkGetQueryPoolResults(device, timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+                r.frameMs += static_cast<f64>(timestamps[1] - timestamps[0]) * caps.timestampPeriod / 1000000.0;
+            } else {
+                r.frameMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            vkResetCommandBuffer(commandBuffer, 0);
+        }
+        
+        r.fillMs /= frames;
+        r.frameMs /= frames;
+        return r;
+    };
+    
+    // sorted draws the additive eighth first and then the rest, each walking the regions by page; scattered picks
+    // any region for any sprite and blends every eighth one additively
+    std::vector<u32> picks(spriteCount);
+    std::vector<SpriteBatch::Blend> blends(spriteCount);
+    u32 regionCount = static_cast<u32>(regions.size());
+    std::vector<u32> byPage(regionCount);
+    for (u32 r = 0; r < regionCount; ++r) {
+        byPage[r] = r;
+    }
+    std::stable_sort(byPage.begin(), byPage.end(), [&](u32 a, u32 b) { return regions[a].page < regions[b].page; });
+    const u32 additiveCount = spriteCount / 8;
+    for (u32 i = 0; i < spriteCount; ++i) {
+        bool additive = i < additiveCount;
+        u32 first = additive ? 0 : additiveCount;
+        u32 count = additive ? additiveCount : spriteCount - additiveCount;
+        picks[i] = byPage[static_cast<usize>(static_cast<u64>(i - first) * regionCount / count)];
+        blends[i] = additive ? SpriteBatch::BLEND_ADDITIVE : SpriteBatch::BLEND_ALPHA;
+    }
+    Result sorted = measure(picks, blends);
+    
+    std::uniform_int_distribution<u32> anyRegion(0, regionCount - 1);
+    for (u32 i = 0; i < spriteCount; ++i) {
+        picks[i] = anyRegion(random);
+        blends[i] = i % 8 == 0 ? SpriteBatch::BLEND_ADDITIVE : SpriteBatch::BLEND_ALPHA;
+    }
+    Result scattered = measure(picks, blends);
+    
+    std::cout << "Sprite batch benchmark, " << spriteCount << " sprites from " << regionCount << " textures on " << batch.pages.size() << " atlas pages, "
+              << frames << " frames at " << target.extent.width << "x" << target.extent.height << (timestampPool != VK_NULL_HANDLE ? ", GPU time" : ", CPU time") << ":\n";
+    if (batch.evictions > 0 || batch.downsampledTextures > 0) {
+        std::cout << "    over the memory budget: " << batch.evictions << " page evictions, " << batch.downsampledTextures << " textures downsampled\n";
+    }
+    auto print = [&](const char* name, Result const& r) {
+        std::cout << "    " << name << r.fillMs << " ms to fill, " << r.frameMs << " ms/frame, " << r.draws << " draws instead of " << spriteCount << "\n";
+    };
+    print("sorted by blend and page: ", sorted);
+    print("scattered:                ", scattered);
+}
+
+// Runs the particle simulation at a few capacities with emission tuned to keep roughly three quarters of the slots
+// alive. First the simulation alone on the graphics queue, timed per step, then whole frames of one step plus a
+// draw of its particles into an offscreen target, once with both on the graphics queue and once with the step on
+// the compute queue, where it overlaps the previous frame's draw. The second half needs a separate compute family.
+void benchmarkParticles(VkDevice device, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkQueue graphicsQueue, u32 graphicsFamilyIndex, VkQueue computeQueue, u32 computeFamilyIndex, OffscreenTarget const& target) {
+    Scope scope;
+    
+    VkShaderModule computeModule = VK_NULL_HANDLE;
+    VkShaderModule vertexModule = VK_NULL_HANDLE;
+    VkShaderModule fragmentModule = VK_NULL_HANDLE;
+    if (!loadShaderModule(device, "assets/particles.comp.spv", &computeModule)) {
+        return;
+    }
+    scope.addMess(vkDestroyShaderModule, device, computeModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    if (!loadShaderModule(device, "assets/particle.vert.spv", &vertexModule)) {
+        return;
+    }
+    scope.addMess(vkDestroyShaderModule, device, vertexModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    if (!loadShaderModule(device, "assets/particle.frag.spv", &fragmentModule)) {
+        return;
+    }
+    scope.addMess(vkDestroyShaderModule, device, fragmentModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    
+    const bool asyncCompute = computeFamilyIndex != graphicsFamilyIndex;
+    std::vector<u32> queueFamilies = { graphicsFamilyIndex };
+    if (asyncCompute) {
+        queueFamilies.push_back(computeFamilyIndex);
+    }
+    
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    if (caps.timestampPeriod > 0.0f) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
+        
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, timestampPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            timestampPool = VK_NULL_HANDLE;
+        }
+    }
+    
+    // two frame slots, each with a graphics command buffer and, for the async runs, a compute one
+    const u32 slots = 2;
+    auto allocateCommandBuffers = [&](u32 familyIndex, VkCommandBuffer* commandBuffers) -> bool {
+        VkCommandPoolCreateInfo commandPoolInfo = {};
+        commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        commandPoolInfo.queueFamilyIndex = familyIndex;
+        
+        VkCommandPool commandPool;
+        if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+            return false;
+        }
+        scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+        
+        VkCommandBufferAllocateInfo commandBufferInfo = {};
+        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.commandPool = commandPool;
+        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandBufferCount = slots;
+        return vkAllocateCommandBuffers(device, &commandBufferInfo, commandBuffers) == VK_SUCCESS;
+    };
+    
+    VkCommandBuffer graphicsCommandBuffers[slots];
+    VkCommandBuffer computeCommandBuffers[slots];
+    if (!allocateCommandBuffers(graphicsFamilyIndex, graphicsCommandBuffers) || (asyncCompute && !allocateCommandBuffers(computeFamilyIndex, computeCommandBuffers))) {
+        return;
+    }
+    
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    
+    VkFence fences[slots];
+    VkSemaphore simulated[slots];
+    for (u32 i = 0; i < slots; ++i) {
+        if (vkCreateFence(device, &fenceInfo, hostAllocator(VK_OBJECT_TYPE_FENCE), &fences[i]) != VK_SUCCESS) {
+            return;
+        }
+        scope.addMess(vkDestroyFence, device, fences[i], hostAllocator(VK_OBJECT_TYPE_FENCE));
+        if (vkCreateSemaphore(device, &semaphoreInfo, hostAllocator(VK_OBJECT_TYPE_SEMAPHORE), &simulated[i]) != VK_SUCCESS) {
+            return;
+        }
+        scope.addMess(vkDestroySemaphore, device, simulated[i], hostAllocator(VK_OBJECT_TYPE_SEMAPHORE));
+    }
+    
+    VkBuffer readbackBuffer;
+    VkDeviceMemory readbackMemory;
+    VkDrawIndirectCommand* readback = nullptr;
+    if (!createBuffer(device, memoryProperties, sizeof(VkDrawIndirectCommand), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_STAGING, {}, &readbackBuffer, &readbackMemory)) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, readbackBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    scope.addMess(freeMemory, device, readbackMemory);
+    if (vkMapMemory(device, readbackMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&readback)) != VK_SUCCESS) {
+        return;
+    }
+    
+    VkViewport viewport = { 0.0f, 0.0f, static_cast<f32>(target.extent.width), static_cast<f32>(target.extent.height), 0.0f, 1.0f };
+    VkRect2D scissor = { { 0, 0 }, target.extent };
+    
+    VkClearValue clearValues[2] = {};
+    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    
+    mat4x4 identity;
+    mat4x4_identity(identity);
+    const f32 emitter[3] = { 0.0f, 0.0f, 0.5f };
+    const f32 dt = 1.0f / 60.0f;
+    const u32 warmupSteps = 180;
+    const u32 frames = 120;
+    
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    
+    auto recordDraw = [&](VkCommandBuffer commandBuffer, ParticleSystem const& particles, u32 slot) {
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = target.renderPass;
+        renderPassBeginInfo.framebuffer = target.framebuffer;
+        renderPassBeginInfo.renderArea.extent = target.extent;
+        renderPassBeginInfo.clearValueCount = 2;
+        renderPassBeginInfo.pClearValues = clearValues;
+        
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        particles.recordDraw(commandBuffer, slot);
+        vkCmdEndRenderPass(commandBuffer);
+    };
+    
+    auto submit = [&](VkQueue queue, VkCommandBuffer commandBuffer, VkSemaphore wait, VkSemaphore signal, VkFence fence) -> bool {
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = wait != VK_NULL_HANDLE ? 1 : 0;
+        submitInfo.pWaitSemaphores = &wait;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        submitInfo.signalSemaphoreCount = signal != VK_NULL_HANDLE ? 1 : 0;
+        submitInfo.pSignalSemaphores = &signal;
+        return vkQueueSubmit(queue, 1, &submitInfo, fence) == VK_SUCCESS;
+    };
+    
+    std::cout << "Particle benchmark, " << frames << " frames at " << target.extent.width << "x" << target.extent.height << " after " << warmupSteps << " warm-up steps of " << dt * 1000.0f << " ms:\n";
+    
+    const u32 capacities[2] = { 1u << 20, 1u << 22 };
+    for (u32 capacity : capacities) {
+        ParticleSystem particles;
+        if (!particles.create(device, physicalDevice, target.renderPass, computeModule, vertexModule, fragmentModule, capacity, slots, queueFamilies)) {
+            std::cout << "    " << capacity << " particles: could not be created\n";
+            continue;
+        }
+        particles.lifetime = 2.0f;
+        particles.emitRate = static_cast<f32>(capacity) / particles.lifetime;
+        
+        // reset, warm up to a steady state and leave the alive count in the readback buffer, all in one go
+        VkCommandBuffer commandBuffer = graphicsCommandBuffers[0];
+        vkResetCommandBuffer(commandBuffer, 0);
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        particles.recordReset(commandBuffer);
+        particles.update(0, dt, identity, identity, emitter);
+        for (u32 step = 0; step < warmupSteps; ++step) {
+            particles.recordSimulate(commandBuffer, 0);
+        }
+        
+        VkMemoryBarrier readbackBarrier = {};
+        readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        readbackBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        readbackBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+        
+        VkBufferCopy copy = { 0, 0, sizeof(VkDrawIndirectCommand) };
+        vkCmdCopyBuffer(commandBuffer, particles.frames[0].drawBuffer, readbackBuffer, 1, &copy);
+        vkEndCommandBuffer(commandBuffer);
+        submit(graphicsQueue, commandBuffer, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE);
+        vkQueueWaitIdle(graphicsQueue);
+        u32 alive = readback->instanceCount;
+        
+        // the simulation alone, one step per submit
+        f64 simulateMs = 0.0;
+        vkResetCommandBuffer(commandBuffer, 0);
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, timestampPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
+        }
+        particles.recordSimulate(commandBuffer, 0);
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
+        }
+        vkEndCommandBuffer(commandBuffer);
+        for (u32 frame = 0; frame < frames; ++frame) {
+            particles.update(0, dt, identity, identity, emitter);
+            auto start = std::chrono::steady_clock::now();
+            submit(graphicsQueue, commandBuffer, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE);
+            vkQueueWaitIdle(graphicsQueue);
+            
+            if (timestampPool != VK_NULL_HANDLE) {
+                u64 timestamps[2];
+                vkGetQueryPoolResults(device, timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+                simulateMs += static_cast<f64>(timestamps[1] - timestamps[0]) * caps.timestampPeriod / 1000000.0;
+            } else {
+                simulateMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
         }
+        simulateMs /= frames;
+        vkResetCommandBuffer(commandBuffer, 0);
         
-        scope.scrap();
-        currentExtent = swapchainCreateInfo.imageExtent;
-        return true;
+        // whole frames, two slots in flight; serial keeps the step in front of the draw on the graphics queue
+        auto runFrames = [&](bool overlap) -> f64 {
+            for (u32 slot = 0; slot < slots; ++slot) {
+                vkResetCommandBuffer(graphicsCommandBuffers[slot], 0);
+                vkBeginCommandBuffer(graphicsCommandBuffers[slot], &beginInfo);
+                if (!overlap) {
+                    particles.recordSimulate(graphicsCommandBuffers[slot], slot);
+                }
+                recordDraw(graphicsCommandBuffers[slot], particles, slot);
+                vkEndCommandBuffer(graphicsCommandBuffers[slot]);
+                
+                if (overlap) {
+                    vkResetCommandBuffer(computeCommandBuffers[slot], 0);
+                    vkBeginCommandBuffer(computeCommandBuffers[slot], &beginInfo);
+                    particles.recordSimulate(computeCommandBuffers[slot], slot);
+                    vkEndCommandBuffer(computeCommandBuffers[slot]);
+                }
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            for (u32 frame = 0; frame < frames; ++frame) {
+                u32 slot = frame % slots;
+                vkWaitForFences(device, 1, &fences[slot], VK_TRUE, std::numeric_limits<u64>::max());
+                vkResetFences(device, 1, &fences[slot]);
+                particles.update(slot, dt, identity, identity, emitter);
+                
+                if (overlap) {
+                    submit(computeQueue, computeCommandBuffers[slot], VK_NULL_HANDLE, simulated[slot], VK_NULL_HANDLE);
+                    submit(graphicsQueue, graphicsCommandBuffers[slot], simulated[slot], VK_NULL_HANDLE, fences[slot]);
+                } else {
+                    submit(graphicsQueue, graphicsCommandBuffers[slot], VK_NULL_HANDLE, VK_NULL_HANDLE, fences[slot]);
+                }
+            }
+            vkWaitForFences(device, slots, fences, VK_TRUE, std::numeric_limits<u64>::max());
+            return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+        };
+        
+        f64 serialMs = runFrames(false);
+        std::cout << "    " << capacity << " particles, " << alive << " alive: " << simulateMs << " ms/step" << (timestampPool != VK_NULL_HANDLE ? " GPU" : " CPU")
+                  << " (" << static_cast<f64>(alive) / (simulateMs * 1000.0) << " M particles/s), step + draw " << serialMs << " ms/frame on one queue";
+        if (asyncCompute) {
+            f64 overlapMs = runFrames(true);
+            std::cout << ", " << overlapMs << " ms/frame with the step on the compute queue";
+        }
+        std::cout << "\n";
+        
+        vkDeviceWaitIdle(device);
     }
     
-    bool createFramebuffers(VkRenderPass rp) {
-        renderPass = rp;
-        
-        Scope scope;
-        swapchainFramebuffers.resize(swapchainImages.size());
-        for (usize i = 0; i < swapchainImageViews.size(); ++i) {
-            VkFramebufferCreateInfo info = {};
-            info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            info.renderPass = renderPass;
-            info.attachmentCount = 1;
-            info.pAttachments = &swapchainImageViews[i];
-            info.width = currentExtent.width;
-            info.height = currentExtent.height;
-            info.layers = 1;
+    if (!asyncCompute) {
+        std::cout << "    the compute queue shares the graphics family, no async comparison\n";
+    }
+}
 
-            if (vkCreateFramebuffer(device, &info, nullptr, &swapchainFramebuffers[i]) != VK_SUCCESS) {
-                scope.cleanup();
-                return false;
-            }
-            scope.addMess(vkDestroyFramebuffer, device, swapchainFramebuffers[i], nullptr);
-        }
+// A deferred-style frame of clear and copy passes, so it needs no shaders: a G-buffer, lighting into an HDR image,
+// a half resolution downsample, a composite and a readback, plus a debug view nothing reads. Reports what the graph
+// derived, the culled passes, the barriers it records and the transient memory with and without aliasing, and
+// times executing it.
+void benchmarkRenderGraph(VkDevice device, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkQueue queue, u32 queueFamilyIndex, VkFormat colorFormat, VkFormat depthFormat, VkExtent2D extent) {
+    Scope scope;
+    
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    
+    VkBuffer readbackBuffer;
+    VkDeviceMemory readbackMemory;
+    if (!createBuffer(device, memoryProperties, static_cast<VkDeviceSize>(extent.width) * extent.height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_STAGING, {}, &readbackBuffer, &readbackMemory)) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, readbackBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    scope.addMess(freeMemory, device, readbackMemory);
+    
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    if (caps.timestampPeriod > 0.0f) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
         
-        scope.scrap();
-        return true;
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, timestampPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            timestampPool = VK_NULL_HANDLE;
+        }
     }
     
-    void cleanup() {
-        if (device == VK_NULL_HANDLE) {
-            return;
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    
+    const VkExtent2D halfExtent = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+    const VkClearColorValue black = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+    
+    RenderGraph graph;
+    graph.init(device, physicalDevice);
+    u32 albedo = graph.createImage(colorFormat, extent, VK_IMAGE_ASPECT_COLOR_BIT);
+    u32 normals = graph.createImage(colorFormat, extent, VK_IMAGE_ASPECT_COLOR_BIT);
+    u32 depth = graph.createImage(depthFormat, extent, VK_IMAGE_ASPECT_DEPTH_BIT);
+    u32 hdr = graph.createImage(colorFormat, extent, VK_IMAGE_ASPECT_COLOR_BIT);
+    u32 bloom = graph.createImage(colorFormat, halfExtent, VK_IMAGE_ASPECT_COLOR_BIT);
+    u32 composite = graph.createImage(colorFormat, extent, VK_IMAGE_ASPECT_COLOR_BIT);
+    u32 debug = graph.createImage(colorFormat, extent, VK_IMAGE_ASPECT_COLOR_BIT);
+    u32 readback = graph.importBuffer(readbackBuffer, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+    graph.markBufferOutput(readback);
+    
+    auto nothing = [](VkCommandBuffer) {};
+    
+    u32 gbufferPass = graph.addPass("gbuffer", RenderGraph::PASS_GRAPHICS, nothing);
+    graph.colorAttachment(gbufferPass, albedo, VK_ATTACHMENT_LOAD_OP_CLEAR, black);
+    graph.colorAttachment(gbufferPass, normals, VK_ATTACHMENT_LOAD_OP_CLEAR, black);
+    graph.depthAttachment(gbufferPass, depth, VK_ATTACHMENT_LOAD_OP_CLEAR);
+    
+    u32 lightingPass = graph.addPass("lighting", RenderGraph::PASS_GRAPHICS, nothing);
+    graph.readImage(lightingPass, albedo, RenderGraph::ACCESS_SAMPLED_FRAGMENT);
+    graph.readImage(lightingPass, normals, RenderGraph::ACCESS_SAMPLED_FRAGMENT);
+    graph.colorAttachment(lightingPass, hdr, VK_ATTACHMENT_LOAD_OP_CLEAR, black);
+    
+    u32 downsamplePass = graph.addPass("downsample", RenderGraph::PASS_TRANSFER, [&](VkCommandBuffer cmd) {
+        VkImageBlit blit = {};
+        blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        blit.srcOffsets[1] = { static_cast<s32>(extent.width), static_cast<s32>(extent.height), 1 };
+        blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        blit.dstOffsets[1] = { static_cast<s32>(halfExtent.width), static_cast<s32>(halfExtent.height), 1 };
+        vkCmdBlitImage(cmd, graph.image(hdr), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, graph.image(bloom), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_NEAREST);
+    });
+    graph.readImage(downsamplePass, hdr, RenderGraph::ACCESS_TRANSFER_READ);
+    graph.writeImage(downsamplePass, bloom, RenderGraph::ACCESS_TRANSFER_WRITE);
+    
+    u32 compositePass = graph.addPass("composite", RenderGraph::PASS_GRAPHICS, nothing);
+    graph.readImage(compositePass, hdr, RenderGraph::ACCESS_SAMPLED_FRAGMENT);
+    graph.readImage(compositePass, bloom, RenderGraph::ACCESS_SAMPLED_FRAGMENT);
+    graph.colorAttachment(compositePass, composite, VK_ATTACHMENT_LOAD_OP_CLEAR, black);
+    
+    // nothing reads it, the graph drops the pass and never creates the image
+    u32 debugPass = graph.addPass("debug view", RenderGraph::PASS_GRAPHICS, nothing);
+    graph.readImage(debugPass, depth, RenderGraph::ACCESS_SAMPLED_FRAGMENT);
+    graph.colorAttachment(debugPass, debug, VK_ATTACHMENT_LOAD_OP_CLEAR, black);
+    
+    u32 readbackPass = graph.addPass("readback", RenderGraph::PASS_TRANSFER, [&](VkCommandBuffer cmd) {
+        VkBufferImageCopy region = {};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { extent.width, extent.height, 1 };
+        vkCmdCopyImageToBuffer(cmd, graph.image(composite), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+    });
+    graph.readImage(readbackPass, composite, RenderGraph::ACCESS_TRANSFER_READ);
+    graph.writeBuffer(readbackPass, readback, RenderGraph::ACCESS_TRANSFER_WRITE);
+    
+    auto start = std::chrono::steady_clock::now();
+    if (!graph.compile()) {
+        std::cout << "Render graph failed to compile\n";
+        return;
+    }
+    f64 compileMs = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    
+    const u32 frames = 30;
+    f64 frameMs = 0.0;
+    for (u32 frame = 0; frame < frames; ++frame) {
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, timestampPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
         }
-        
-        vkDeviceWaitIdle(device);
-        for (VkFramebuffer f : swapchainFramebuffers) {
-            vkDestroyFramebuffer(device, f, nullptr);
+        graph.execute(commandBuffer);
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 1);
         }
-        swapchainFramebuffers.clear();
+        vkEndCommandBuffer(commandBuffer);
         
-        for (VkImageView v : swapchainImageViews) {
-            vkDestroyImageView(device, v, nullptr);
-        }
-        swapchainImageViews.clear();
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
         
-        if (swapchain != VK_NULL_HANDLE) {
-            vkDestroySwapchainKHR(device, swapchain, nullptr);
+        start = std::chrono::steady_clock::now();
+        vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(queue);
+        if (timestampPool != VK_NULL_HANDLE) {
+            u64 timestamps[2];
+            vkGetQueryPoolResults(device, timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+            frameMs += static_cast<f64>(timestamps[1] - timestamps[0]) * caps.timestampPeriod / 1000000.0;
+        } else {
+            frameMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
         }
+        vkResetCommandBuffer(commandBuffer, 0);
     }
     
-    u32 recreate() {
-        VkSurfaceCapabilitiesKHR caps;
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps);
+    std::cout << "Render graph benchmark, " << graph.passes.size() << " passes at " << extent.width << "x" << extent.height << ":\n";
+    std::cout << "    compiled in " << compileMs << " ms, " << graph.culledPasses << " passes culled, " << graph.barrierCount << " barriers per frame\n";
+    std::cout << "    transient memory " << graph.transientBytes / 1024 << " KiB in " << graph.blocks.size() << " blocks, "
+              << graph.unaliasedTransientBytes / 1024 << " KiB without aliasing\n";
+    std::cout << "    " << frameMs / frames << " ms/frame\n";
+}
+
+// Uploads the same 64 MiB both ways. Staged: the CPU writes host memory and a copy moves it into device local
+// memory, the path every upload takes without DIRECT_WRITE_MEMORY. Direct: the CPU writes device local memory
+// through its mapping and nothing else runs, only with resizable BAR or on a UMA device. The direct buffer is also
+// copied once per iteration to see how fast the GPU reads it compared with the staged copy reading host memory.
+void benchmarkUploads(VkDevice device, VkPhysicalDevice physicalDevice, DeviceCaps const& caps, VkQueue queue, u32 queueFamilyIndex) {
+    Scope scope;
+    
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    
+    const VkDeviceSize size = 64 << 20;
+    const u32 iterations = 10;
+    
+    std::vector<u8> source(size);
+    for (VkDeviceSize i = 0; i < size; ++i) {
+        source[i] = static_cast<u8>(i * 2654435761u >> 24);
+    }
+    
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingMemory;
+    if (!createBuffer(device, memoryProperties, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_STAGING, {}, &stagingBuffer, &stagingMemory)) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, stagingBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    scope.addMess(freeMemory, device, stagingMemory);
+    
+    VkBuffer deviceBuffer;
+    VkDeviceMemory deviceMemory;
+    if (!createBuffer(device, memoryProperties, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_MESHES, {}, &deviceBuffer, &deviceMemory)) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, deviceBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    scope.addMess(freeMemory, device, deviceMemory);
+    
+    void* stagingMapped;
+    if (vkMapMemory(device, stagingMemory, 0, size, 0, &stagingMapped) != VK_SUCCESS) {
+        return;
+    }
+    
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    if (caps.timestampPeriod > 0.0f) {
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
         
-        if (caps.currentExtent.width == 0 || caps.currentExtent.height == 0) {
-            return 2;
+        if (vkCreateQueryPool(device, &queryInfo, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL), &timestampPool) == VK_SUCCESS) {
+            scope.addMess(vkDestroyQueryPool, device, timestampPool, hostAllocator(VK_OBJECT_TYPE_QUERY_POOL));
+        } else {
+            timestampPool = VK_NULL_HANDLE;
         }
+    }
+    
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &commandPoolInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &commandPool) != VK_SUCCESS) {
+        return;
+    }
+    scope.addMess(vkDestroyCommandPool, device, commandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    VkCommandBufferAllocateInfo commandBufferInfo = {};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+    
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        return;
+    }
+    
+    // copies all of src into the device local buffer and waits, the GPU's ms by timestamps or the CPU's around the
+    // submit without them
+    auto copy = [&](VkBuffer src) -> f64 {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         
-        cleanup();
-        if (!create()) {
-            return 0;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, timestampPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, 0);
         }
+        VkBufferCopy region = { 0, 0, size };
+        vkCmdCopyBuffer(commandBuffer, src, deviceBuffer, 1, &region);
+        if (timestampPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, timestampPool, 1);
+        }
+        vkEndCommandBuffer(commandBuffer);
         
-        return createFramebuffers(renderPass);
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        
+        auto start = std::chrono::steady_clock::now();
+        vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(queue);
+        f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (timestampPool != VK_NULL_HANDLE) {
+            u64 timestamps[2];
+            vkGetQueryPoolResults(device, timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+            ms = static_cast<f64>(timestamps[1] - timestamps[0]) * caps.timestampPeriod / 1000000.0;
+        }
+        vkResetCommandBuffer(commandBuffer, 0);
+        return ms;
+    };
+    
+    auto write = [&](void* dst) -> f64 {
+        auto start = std::chrono::steady_clock::now();
+        memcpy(dst, source.data(), size);
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    
+    auto gbs = [&](f64 ms) {
+        return static_cast<f64>(size) / (ms / 1000.0) / 1e9;
+    };
+    
+    // first touch maps the pages in and warms the caches, none of which is the upload's cost
+    write(stagingMapped);
+    copy(stagingBuffer);
+    
+    f64 stagedWriteMs = 0.0;
+    f64 stagedCopyMs = 0.0;
+    f64 stagedTotalMs = 0.0;
+    for (u32 i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        stagedWriteMs += write(stagingMapped);
+        stagedCopyMs += copy(stagingBuffer);
+        stagedTotalMs += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
     }
-};
-
-struct Globals {
-	bool VALIDATION = false;
-	bool DEBUG_MESSENGER = false;
-	u32 FRAMES_IN_FLIGHT = 1;
-
-	VkDebugUtilsMessengerEXT debugMessenger;
-
-	Scope scope;
-
-	static VkBool32 vkDebugMessengerCallback(
-		VkDebugUtilsMessageSeverityFlagBitsEXT severity,
-		VkDebugUtilsMessageTypeFlagsEXT type,
-		const VkDebugUtilsMessengerCallbackDataEXT* callbackData,
-		void* userData)
-	{
-		std::cout << callbackData->pMessage << std::endl;
-		return true;
-	}
-};
-
-struct Vertex {
-    float x, y, z;
-    float r, g, b;
-    float u, v;
-};
-
-struct UniformBuffer {
-    mat4x4 model;
-    mat4x4 view;
-    mat4x4 proj;
-};
-
-struct Camera {
-    vec3 pos;
-    vec3 rot;
     
-    float fov;
-    float near, far;
-};
-
-u32 findMemoryType(u32 typeBits, VkMemoryPropertyFlags flags, VkPhysicalDeviceMemoryProperties props) {
-    for (u32 i = 0; i < props.memoryTypeCount; ++i) {
-        if (typeBits & (1 << i) && (props.memoryTypes[i].propertyFlags & flags) == flags) {
-            return i;
-        }
+    std::cout << "Upload benchmark, " << (size >> 20) << " MiB x " << iterations << ":\n";
+    std::cout << "    staged: CPU writes " << gbs(stagedWriteMs / iterations) << " GB/s, GPU copies " << gbs(stagedCopyMs / iterations)
+              << " GB/s" << (timestampPool != VK_NULL_HANDLE ? "" : " (CPU timed)") << ", " << stagedTotalMs / iterations << " ms per upload\n";
+    
+    u32 directType = findMemoryType(~0u, DIRECT_WRITE_MEMORY, memoryProperties, size);
+    if (!hasDirectWriteMemory(memoryProperties, ~0u, size)) {
+        std::cout << "    direct: " << (directType == MEMORY_TYPE_NONE ? "no device local memory the CPU can map" : "no room in the mappable device local heap") << "\n";
+        return;
+    }
+    
+    VkBuffer directBuffer;
+    VkDeviceMemory directMemory;
+    void* directMapped;
+    if (!createBuffer(device, memoryProperties, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, DIRECT_WRITE_MEMORY, MemoryBudget::CATEGORY_MESHES, {}, &directBuffer, &directMemory)) {
+        return;
+    }
+    scope.addMess(vkDestroyBuffer, device, directBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    scope.addMess(freeMemory, device, directMemory);
+    if (vkMapMemory(device, directMemory, 0, size, 0, &directMapped) != VK_SUCCESS) {
+        return;
     }
     
-    return 0;
+    write(directMapped);
+    copy(directBuffer);
+    
+    f64 directWriteMs = 0.0;
+    f64 directReadMs = 0.0;
+    for (u32 i = 0; i < iterations; ++i) {
+        directWriteMs += write(directMapped);
+        directReadMs += copy(directBuffer);
+    }
+    
+    VkMemoryHeap const& heap = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[directType].heapIndex];
+    std::cout << "    direct: CPU writes " << gbs(directWriteMs / iterations) << " GB/s, " << directWriteMs / iterations << " ms per upload, GPU reads "
+              << gbs(directReadMs / iterations) << " GB/s, heap of " << (heap.size >> 20) << " MiB\n";
 }
 
 int main(int argc, char** argv) {
+    StartupReport report;
+    // outlives the messenger, which globals.scope destroys
+    DebugLog debugLog;
     Globals globals = {};
-    globals.VALIDATION = true;
-    globals.DEBUG_MESSENGER = true;
-    globals.FRAMES_IN_FLIGHT = 2;
+    
+    Config config;
+    if (!config.load(argc, argv)) {
+        return 1;
+    }
+    
+    bool benchmarkDescriptors = false;
+    bool benchmarkOverdraw = false;
+    bool rerecordCommands = false;
+    bool depthPrepass = false;
+    bool benchmarkCulling = false;
+    bool gpuCulling = false;
+    bool benchmarkOcclusion = false;
+    bool occlusionCulling = false;
+    bool fullVertices = false;
+    bool benchmarkVertexFormats = false;
+    const char* cookInput = nullptr;
+    const char* cookOutput = nullptr;
+    const char* meshPath = nullptr;
+    bool benchmarkLods = false;
+    bool triangleStats = false;
+    f32 lodThresholdPixels = 1.0f;
+    bool benchmarkSprites = false;
+    u32 particleCount = 0;
+    bool benchmarkParticleSystem = false;
+    bool benchmarkGraph = false;
+    bool benchmarkUploadPaths = false;
+    bool renderOnDemand = false;
+    for (int i = 1; i < argc; ++i) {
+        bool configError = false;
+        if (config.parseArgument(argc, argv, i, &configError)) {
+            if (configError) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench-descriptors") == 0) {
+            benchmarkDescriptors = true;
+        } else if (strcmp(argv[i], "--bench-overdraw") == 0) {
+            benchmarkOverdraw = true;
+        } else if (strcmp(argv[i], "--rerecord-commands") == 0) {
+            rerecordCommands = true;
+        } else if (strcmp(argv[i], "--depth-prepass") == 0) {
+            depthPrepass = true;
+        } else if (strcmp(argv[i], "--bench-culling") == 0) {
+            benchmarkCulling = true;
+        } else if (strcmp(argv[i], "--gpu-culling") == 0) {
+            gpuCulling = true;
+        } else if (strcmp(argv[i], "--bench-occlusion") == 0) {
+            benchmarkOcclusion = true;
+        } else if (strcmp(argv[i], "--occlusion-culling") == 0) {
+            occlusionCulling = true;
+            gpuCulling = true;
+        } else if (strcmp(argv[i], "--full-vertices") == 0) {
+            fullVertices = true;
+        } else if (strcmp(argv[i], "--bench-vertex-formats") == 0) {
+            benchmarkVertexFormats = true;
+        } else if (strcmp(argv[i], "--cook-mesh") == 0 && i + 2 < argc) {
+            cookInput = argv[++i];
+            cookOutput = argv[++i];
+        } else if (strcmp(argv[i], "--mesh") == 0 && i + 1 < argc) {
+            meshPath = argv[++i];
+        } else if (strcmp(argv[i], "--bench-lod") == 0) {
+            benchmarkLods = true;
+        } else if (strcmp(argv[i], "--triangle-stats") == 0) {
+            triangleStats = true;
+        } else if (strcmp(argv[i], "--lod-threshold") == 0 && i + 1 < argc) {
+            lodThresholdPixels = std::strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--bench-sprites") == 0) {
+            benchmarkSprites = true;
+        } else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc) {
+            particleCount = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--bench-particles") == 0) {
+            benchmarkParticleSystem = true;
+        } else if (strcmp(argv[i], "--bench-render-graph") == 0) {
+            benchmarkGraph = true;
+        } else if (strcmp(argv[i], "--bench-uploads") == 0) {
+            benchmarkUploadPaths = true;
+        } else if (strcmp(argv[i], "--on-demand") == 0) {
+            renderOnDemand = true;
+        }
+    }
+    
+    config.print();
+    globals.VALIDATION = config.validation;
+    globals.DEBUG_MESSENGER = config.debugMessenger;
+    globals.FRAMES_IN_FLIGHT = config.framesInFlight;
+    debugLog.minimumSeverity = config.logSeverity;
+    debugLog.perIdPerSecond = config.logRate;
+    debugLog.mutedIds = config.logMute;
+    VkPresentModeKHR presentMode = config.presentMode;
+    u32 swapchainImageCount = config.swapchainImages;
+    f64 targetFps = config.targetFps;
+    bool latencyStats = config.latencyStats;
+    bool startupReport = config.startupReport;
+    // before anything is created, every object has to be destroyed with the callbacks it was created with
+    HostAllocator::instance().init(config.hostAllocation);
+    bool hostStats = config.hostAllocation != HostAllocator::MODE_OFF;
+    bool memoryStats = config.memoryStats;
+    bool directUpload = config.directUpload;
+    
+#ifndef VKHELLOWORLD_PROFILER
+    if (!config.trace.empty()) {
+        std::cout << "Built without the profiler, configure with -DPROFILER=ON for a trace\n";
+        config.trace.clear();
+    }
+#endif
+    PROFILE_THREAD_NAME("main");
+    // written on every way out of main once the trace has something in it
+    globals.scope.addMess([trace = config.trace]() {
+        if (!trace.empty() && !PROFILE_WRITE_TRACE(trace.c_str())) {
+            std::cout << "Failed to write " << trace << "\n";
+        }
+    });
+    // runs once everything else has been destroyed, so what is still live was never freed
+    globals.scope.addMess([]() {
+        HostAllocator::instance().printReport();
+    });
+    PROFILE_ZONE_BEGIN(startup, "startup");
+    
+    // cooking needs no device, the file is written in the format the renderer uses by default
+    if (cookInput != nullptr) {
+        MeshData mesh;
+        if (!loadObj(cookInput, &mesh)) {
+            std::cout << "Failed to load " << cookInput << "\n";
+            return 1;
+        }
+        
+        usize sourceVertices = mesh.vertices.size();
+        f32 sourceMissRatio = averageCacheMissRatio(mesh.indices, static_cast<u32>(mesh.vertices.size()));
+        optimizeMesh(mesh);
+        f32 missRatio = averageCacheMissRatio(mesh.indices, static_cast<u32>(mesh.vertices.size()));
+        generateLods(mesh, CookedMeshHeader::MAX_LODS);
+        
+        VertexFormat format = fullVertices ? VertexFormat::full() : VertexFormat::compact();
+        if (!cookMesh(mesh, format, cookOutput)) {
+            std::cout << "Failed to write " << cookOutput << "\n";
+            return 1;
+        }
+        
+        std::cout << "Cooked " << cookInput << " into " << cookOutput << ": " << mesh.lods[0].indexCount / 3 << " triangles, "
+                  << sourceVertices << " -> " << mesh.vertices.size() << " vertices, ACMR " << sourceMissRatio << " -> "
+                  << missRatio << ", " << format.stride() << " B/vertex\n";
+        for (usize i = 1; i < mesh.lods.size(); ++i) {
+            std::cout << "    LOD " << i << ": " << mesh.lods[i].indexCount / 3 << " triangles, error " << mesh.lods[i].error << "\n";
+        }
+        return 0;
+    }
+    
+    if (benchmarkLods) {
+        benchmarkLodSelection(1000000, 75.0f * 3.14159265f / 180.0f, 1080.0f);
+        return 0;
+    }
     
     std::filesystem::path path = std::filesystem::current_path();
     
+    // decoded on a worker while the instance, device and pipelines are created. The path is resolved first since
+    // glfwInit may change the working directory on macOS.
+    ktga_t ktga {};
+    bool textureOpened = false;
+    int textureResult = 0;
+    TaskPool startupTasks;
+    startupTasks.create(std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, 3u));
+    u32 textureTask = startupTasks.submit("texture decode", [&ktga, &textureOpened, &textureResult, texturePath = (path / "assets" / "test.tga").string()]() {
+        std::ifstream file(texturePath, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            return;
+        }
+        textureOpened = true;
+
+        size_t size = file.tellg();
+        std::vector<unsigned char> bytes(size);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), size);
+        file.close();
+
+        textureResult = ktga_load(&ktga, (void*) bytes.data(), bytes.size());
+    });
+    
     glfwSetErrorCallback([](int error, const char* description) {
         std::cout << "GLFW error (" << error << "): " << description << std::endl;
     });
     
+    PROFILE_ZONE_BEGIN(glfw, "glfwInit");
     if (!glfwInit()) {
         return 1;
     }
     globals.scope.addMess(glfwTerminate);
-    
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Hello, World!", nullptr, nullptr);
-    if (window == nullptr) {
-        return 1;
-    }
-    globals.scope.addMess(glfwDestroyWindow, window);
+    PROFILE_ZONE_END(glfw);
     
     std::filesystem::current_path(path);
+    report.step("glfwInit");
+    
+    // 1.0 is all that is required, newer versions only unlock optional paths (see DeviceCaps)
+    u32 minimumApiVersion = VK_API_VERSION_1_0;
+    u32 instanceApiVersion = VK_API_VERSION_1_0;
+    PFN_vkEnumerateInstanceVersion enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+    if (enumerateInstanceVersion != nullptr) {
+        enumerateInstanceVersion(&instanceApiVersion);
+    }
     
     VkApplicationInfo appInfo = {};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -376,7 +2715,7 @@ int main(int argc, char** argv) {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = std::min(instanceApiVersion, VK_API_VERSION_1_2);
     
     VkInstanceCreateInfo instanceCreateInfo = {};
     instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -399,6 +2738,21 @@ int main(int argc, char** argv) {
 #ifdef __APPLE__
     extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
     extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+#else
+    if (appInfo.apiVersion < VK_API_VERSION_1_1) {
+        u32 instanceExtensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount, nullptr);
+        
+        std::vector<VkExtensionProperties> instanceExtensions(instanceExtensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount, instanceExtensions.data());
+        
+        for (VkExtensionProperties const& e : instanceExtensions) {
+            if (strcmp(e.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+                extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+                break;
+            }
+        }
+    }
 #endif
     
     instanceCreateInfo.enabledExtensionCount = static_cast<u32>(extensions.size());
@@ -412,36 +2766,60 @@ int main(int argc, char** argv) {
     instanceCreateInfo.enabledLayerCount = static_cast<u32>(layers.size());
     instanceCreateInfo.ppEnabledLayerNames = layers.data();
     
-    VkInstance instance;
-    VkResult result = vkCreateInstance(&instanceCreateInfo, nullptr, &instance);
+    // loading the driver and layers doesn't need the window, which is created in the meantime
+    VkInstance instance = VK_NULL_HANDLE;
+    VkResult result = VK_SUCCESS;
+    u32 instanceTask = startupTasks.submit("vkCreateInstance", [&]() {
+        result = vkCreateInstance(&instanceCreateInfo, hostAllocator(VK_OBJECT_TYPE_INSTANCE), &instance);
+    });
+    
+    PROFILE_ZONE_BEGIN(window, "window");
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Hello, World!", nullptr, nullptr);
+    PROFILE_ZONE_END(window);
+    report.step("window");
+    
+    startupTasks.wait(instanceTask);
+    report.step("instance wait");
+    if (window != nullptr) {
+        globals.scope.addMess(glfwDestroyWindow, window);
+    }
+    if (result == VK_SUCCESS) {
+        globals.scope.addMess(vkDestroyInstance, instance, hostAllocator(VK_OBJECT_TYPE_INSTANCE));
+    }
+    if (window == nullptr) {
+        return 1;
+    }
     if (result != VK_SUCCESS) {
         std::cout << static_cast<s32>(result) << std::endl;
         return 1;
     }
-    globals.scope.addMess(vkDestroyInstance, instance, nullptr);
     
     if (globals.DEBUG_MESSENGER) {
         VkDebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo = {};
         debugMessengerCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-        debugMessengerCreateInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+        debugMessengerCreateInfo.messageSeverity = debugLog.messengerSeverities();
         debugMessengerCreateInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-        debugMessengerCreateInfo.pfnUserCallback = globals.vkDebugMessengerCallback;
+        debugMessengerCreateInfo.pfnUserCallback = DebugLog::callback;
+        debugMessengerCreateInfo.pUserData = &debugLog;
+        debugLog.start();
         
         PFN_vkCreateDebugUtilsMessengerEXT func = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT"));
         if (func != nullptr) {
-            if (func(instance, &debugMessengerCreateInfo, nullptr, &globals.debugMessenger) == VK_SUCCESS) {
+            if (func(instance, &debugMessengerCreateInfo, hostAllocator(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT), &globals.debugMessenger) == VK_SUCCESS) {
                 PFN_vkDestroyDebugUtilsMessengerEXT destructor = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT"));
-                globals.scope.addMess(destructor, instance, globals.debugMessenger, nullptr);
+                globals.scope.addMess(destructor, instance, globals.debugMessenger, hostAllocator(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT));
             }
         }
     }
     
     VkSurfaceKHR surface;
-    if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS) {
+    if (glfwCreateWindowSurface(instance, window, hostAllocator(VK_OBJECT_TYPE_SURFACE_KHR), &surface) != VK_SUCCESS) {
         return 1;
     }
-    globals.scope.addMess(vkDestroySurfaceKHR, instance, surface, nullptr);
+    globals.scope.addMess(vkDestroySurfaceKHR, instance, surface, hostAllocator(VK_OBJECT_TYPE_SURFACE_KHR));
     
+    PROFILE_ZONE_BEGIN(device, "device");
     u32 physicalDeviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, nullptr);
     
@@ -461,7 +2839,7 @@ int main(int argc, char** argv) {
             VkPhysicalDeviceProperties props;
             vkGetPhysicalDeviceProperties(ph, &props);
             
-            if (props.apiVersion < appInfo.apiVersion) {
+            if (props.apiVersion < minimumApiVersion) {
                 continue;
             }
             
@@ -505,6 +2883,9 @@ int main(int argc, char** argv) {
         physicalDevice = physicalDevices[bestIndex];
     }
     
+    DeviceCaps caps;
+    caps.query(instance, physicalDevice, appInfo.apiVersion);
+    
     std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos;
     std::vector<u32> queueFamilyIndices;
     
@@ -590,6 +2971,12 @@ int main(int argc, char** argv) {
             }
         }
         
+        // everything on the graphics queue, e.g. to rule out cross-queue overlap when comparing runs
+        if (!config.asyncQueues) {
+            compute = graphics;
+            transfer = graphics;
+        }
+        
         f32 queuePriority = 1.0f;
         
         VkDeviceQueueCreateInfo info = {};
@@ -634,10 +3021,15 @@ int main(int argc, char** argv) {
         deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
         deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
         
-        if (vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device) != VK_SUCCESS) {
+        caps.enable(deviceExtensions, &deviceCreateInfo.pNext);
+        deviceCreateInfo.enabledExtensionCount = static_cast<u32>(deviceExtensions.size());
+        deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        
+        if (vkCreateDevice(physicalDevice, &deviceCreateInfo, hostAllocator(VK_OBJECT_TYPE_DEVICE), &device) != VK_SUCCESS) {
             return 1;
         }
-        globals.scope.addMess(vkDestroyDevice, device, nullptr);
+        globals.scope.addMess(vkDestroyDevice, device, hostAllocator(VK_OBJECT_TYPE_DEVICE));
+        MemoryBudget::instance().init(instance, physicalDevice, caps, static_cast<VkDeviceSize>(config.memoryBudget) << 20);
         
         vkGetDeviceQueue(device, graphics, 0, &graphicsQueue);
         if (compute == graphics) {
@@ -671,11 +3063,43 @@ int main(int argc, char** argv) {
         transferFamilyIndex = transfer;
         presentFamilyIndex = present;
     }
+    PROFILE_ZONE_END(device);
+    report.step("device");
     
+    PROFILE_ZONE_BEGIN(swapchainCreate, "swapchain");
     Swapchain swapchain = Swapchain(physicalDevice, device, surface, window, queueFamilyIndices);
+    swapchain.requestedPresentMode = presentMode;
+    swapchain.requestedImageCount = swapchainImageCount;
     if (!swapchain.create()) {
         return 1;
     }
+    PROFILE_ZONE_END(swapchainCreate);
+    report.step("swapchain");
+    
+    TextureTable textureTable(device);
+    VkShaderModule bindlessVertexModule = VK_NULL_HANDLE;
+    VkShaderModule bindlessFragmentModule = VK_NULL_HANDLE;
+    if (caps.descriptorIndexing) {
+        if (loadShaderModule(device, "assets/shader_bindless.vert.spv", &bindlessVertexModule) && loadShaderModule(device, "assets/shader_bindless.frag.spv", &bindlessFragmentModule)) {
+            textureTable.create(caps.maxBindlessTextures);
+        }
+        
+        if (!textureTable.isCreated()) {
+            std::cout << "Bindless texture table unavailable, falling back to per-set samplers\n";
+            vkDestroyShaderModule(device, bindlessVertexModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+            vkDestroyShaderModule(device, bindlessFragmentModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+            bindlessVertexModule = VK_NULL_HANDLE;
+            bindlessFragmentModule = VK_NULL_HANDLE;
+        }
+    }
+    bool bindless = textureTable.isCreated();
+    
+    // the built-in vertex shader below predates MeshDecode, only the shaders built from assets/ dequantize positions
+    VertexFormat compactFormat = VertexFormat::compact();
+    if (!bindless) {
+        compactFormat.position = VertexFormat::POSITION_FLOAT32;
+    }
+    VertexFormat vertexFormat = fullVertices ? VertexFormat::full() : compactFormat;
     
     const uint32_t vertexShaderCode[] = {
         0x07230203,0x00010000,0x0008000b,0x00000048,0x00000000,0x00020011,0x00000001,0x0006000b,
@@ -753,7 +3177,7 @@ int main(int argc, char** argv) {
     shaderModuleCreateInfo.pCode = vertexShaderCode;
     
     VkShaderModule vertexModule;
-    if (vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &vertexModule) != VK_SUCCESS) {
+    if (vkCreateShaderModule(device, &shaderModuleCreateInfo, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE), &vertexModule) != VK_SUCCESS) {
         return 1;
     }
     
@@ -786,7 +3210,7 @@ int main(int argc, char** argv) {
     shaderModuleCreateInfo.pCode = fragmentShaderCode;
     
     VkShaderModule fragmentModule;
-    if (vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &fragmentModule) != VK_SUCCESS) {
+    if (vkCreateShaderModule(device, &shaderModuleCreateInfo, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE), &fragmentModule) != VK_SUCCESS) {
         return 1;
     }
     
@@ -796,41 +3220,38 @@ int main(int argc, char** argv) {
         VkPipelineShaderStageCreateInfo info = {};
         info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        info.module = vertexModule;
+        info.module = bindless ? bindlessVertexModule : vertexModule;
         info.pName = stageName;
         
         shaderStages.push_back(info);
         
         info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        info.module = fragmentModule;
+        info.module = bindless ? bindlessFragmentModule : fragmentModule;
         
         shaderStages.push_back(info);
     }
     
-    VkVertexInputBindingDescription vertexBindingDescription = {};
-    vertexBindingDescription.binding = 0;
-    vertexBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    vertexBindingDescription.stride = sizeof(Vertex);
-    
-    VkVertexInputAttributeDescription vertexAttributeDescriptions[3];
-    vertexAttributeDescriptions[0].binding = 0;
-    vertexAttributeDescriptions[0].location = 0;
-    vertexAttributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertexAttributeDescriptions[0].offset = offsetof(Vertex, x);
-    vertexAttributeDescriptions[1].binding = 0;
-    vertexAttributeDescriptions[1].location = 1;
-    vertexAttributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertexAttributeDescriptions[1].offset = offsetof(Vertex, r);
-    vertexAttributeDescriptions[2].binding = 0;
-    vertexAttributeDescriptions[2].location = 2;
-    vertexAttributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-    vertexAttributeDescriptions[2].offset = offsetof(Vertex, u);
-    
+    VkVertexInputBindingDescription vertexBindingDescriptions[2] = {};
+    vertexBindingDescriptions[0].binding = 0;
+    vertexBindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    vertexBindingDescriptions[0].stride = vertexFormat.stride();
+    vertexBindingDescriptions[1].binding = 1;
+    vertexBindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    vertexBindingDescriptions[1].stride = sizeof(InstanceData);
+    
+    VkVertexInputAttributeDescription vertexAttributeDescriptions[VertexFormat::MAX_ATTRIBUTES + 1];
+    const u32 vertexAttributeCount = vertexFormat.attributes(0, vertexAttributeDescriptions);
+    vertexAttributeDescriptions[vertexAttributeCount].binding = 1;
+    vertexAttributeDescriptions[vertexAttributeCount].location = 3;
+    vertexAttributeDescriptions[vertexAttributeCount].format = VK_FORMAT_R32_UINT;
+    vertexAttributeDescriptions[vertexAttributeCount].offset = offsetof(InstanceData, textureIndex);
+    
+    // the per-instance texture index only exists in the bindless shaders
     VkPipelineVertexInputStateCreateInfo vertexInputState = {};
     vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputState.vertexBindingDescriptionCount = 1;
-    vertexInputState.pVertexBindingDescriptions = &vertexBindingDescription;
-    vertexInputState.vertexAttributeDescriptionCount = 3;
+    vertexInputState.vertexBindingDescriptionCount = bindless ? 2 : 1;
+    vertexInputState.pVertexBindingDescriptions = vertexBindingDescriptions;
+    vertexInputState.vertexAttributeDescriptionCount = bindless ? vertexAttributeCount + 1 : vertexAttributeCount;
     vertexInputState.pVertexAttributeDescriptions = vertexAttributeDescriptions;
     
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
@@ -899,6 +3320,20 @@ int main(int argc, char** argv) {
     colorBlendState.blendConstants[2] = 0.0f;
     colorBlendState.blendConstants[3] = 0.0f;
     
+    VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+    depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilState.depthTestEnable = true;
+    depthStencilState.depthWriteEnable = true;
+    depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS;
+    depthStencilState.depthBoundsTestEnable = false;
+    depthStencilState.stencilTestEnable = false;
+    depthStencilState.minDepthBounds = 0.0f;
+    depthStencilState.maxDepthBounds = 1.0f;
+    
+    VkPipelineDepthStencilStateCreateInfo equalDepthStencilState = depthStencilState;
+    equalDepthStencilState.depthWriteEnable = false;
+    equalDepthStencilState.depthCompareOp = VK_COMPARE_OP_EQUAL;
+    
     VkDynamicState dynamicStates[2] = {
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR
@@ -921,67 +3356,97 @@ int main(int argc, char** argv) {
     
     VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
     descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    descriptorSetLayoutCreateInfo.bindingCount = 2;
+    descriptorSetLayoutCreateInfo.bindingCount = bindless ? 1 : 2;
     descriptorSetLayoutCreateInfo.pBindings = descriptorSetLayoutBindings;
     
     VkDescriptorSetLayout descriptorSetLayout;
-    if (vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+    if (vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &descriptorSetLayout) != VK_SUCCESS) {
         return 1;
     }
-    globals.scope.addMess(vkDestroyDescriptorSetLayout, device, descriptorSetLayout, nullptr);
+    globals.scope.addMess(vkDestroyDescriptorSetLayout, device, descriptorSetLayout, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    
+    VkDescriptorSetLayout pipelineSetLayouts[2] = { descriptorSetLayout, textureTable.layout };
+    
+    // every draw pushes its mesh's VertexDecode
+    VkPushConstantRange decodeRange = {};
+    decodeRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    decodeRange.offset = 0;
+    decodeRange.size = sizeof(VertexDecode);
     
     VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
     pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutCreateInfo.setLayoutCount = 1;
-    pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutCreateInfo.setLayoutCount = bindless ? 2 : 1;
+    pipelineLayoutCreateInfo.pSetLayouts = pipelineSetLayouts;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &decodeRange;
     
     VkPipelineLayout pipelineLayout;
-    if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+    if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS) {
+        return 1;
+    }
+    globals.scope.addMess(vkDestroyPipelineLayout, device, pipelineLayout, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    
+    swapchain.depthFormat = findDepthFormat(physicalDevice);
+    if (swapchain.depthFormat == VK_FORMAT_UNDEFINED) {
         return 1;
     }
-    globals.scope.addMess(vkDestroyPipelineLayout, device, pipelineLayout, nullptr);
     
-    VkAttachmentDescription attachmentDescription = {};
-    attachmentDescription.format = swapchain.calculatedFormat;
-    attachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
-    attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    attachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    VkAttachmentDescription attachmentDescriptions[2] = {};
+    attachmentDescriptions[0].format = swapchain.calculatedFormat;
+    attachmentDescriptions[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachmentDescriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachmentDescriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachmentDescriptions[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachmentDescriptions[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachmentDescriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachmentDescriptions[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // depth is never read after the pass, so it is neither loaded nor stored
+    attachmentDescriptions[1].format = swapchain.depthFormat;
+    attachmentDescriptions[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachmentDescriptions[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachmentDescriptions[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachmentDescriptions[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachmentDescriptions[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachmentDescriptions[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachmentDescriptions[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     
     VkAttachmentReference attachmentReference = {};
     attachmentReference.attachment = 0;
     attachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     
+    VkAttachmentReference depthAttachmentReference = {};
+    depthAttachmentReference.attachment = 1;
+    depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    
     VkSubpassDescription subpassDescription = {};
     subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpassDescription.colorAttachmentCount = 1;
     subpassDescription.pColorAttachments = &attachmentReference;
+    subpassDescription.pDepthStencilAttachment = &depthAttachmentReference;
     
+    // the depth buffer is shared between frames in flight, so the clear has to wait for the previous frame's depth writes
     VkSubpassDependency subpassDependency = {};
     subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     subpassDependency.dstSubpass = 0;
-    subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependency.srcAccessMask = 0;
-    subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    subpassDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
     
     VkRenderPassCreateInfo renderPassCreateInfo = {};
     renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassCreateInfo.attachmentCount = 1;
-    renderPassCreateInfo.pAttachments = &attachmentDescription;
+    renderPassCreateInfo.attachmentCount = 2;
+    renderPassCreateInfo.pAttachments = attachmentDescriptions;
     renderPassCreateInfo.subpassCount = 1;
     renderPassCreateInfo.pSubpasses = &subpassDescription;
     renderPassCreateInfo.dependencyCount = 1;
     renderPassCreateInfo.pDependencies = &subpassDependency;
     
     VkRenderPass renderPass;
-    if (vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, &renderPass) != VK_SUCCESS) {
+    if (vkCreateRenderPass(device, &renderPassCreateInfo, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS), &renderPass) != VK_SUCCESS) {
         return 1;
     }
-    globals.scope.addMess(vkDestroyRenderPass, device, renderPass, nullptr);
+    globals.scope.addMess(vkDestroyRenderPass, device, renderPass, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS));
     
     VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
     pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -993,21 +3458,188 @@ int main(int argc, char** argv) {
     pipelineCreateInfo.pViewportState = &viewportState;
     pipelineCreateInfo.pRasterizationState = &rasterizationState;
     pipelineCreateInfo.pMultisampleState = &multisampleState;
-    pipelineCreateInfo.pDepthStencilState = nullptr;
+    pipelineCreateInfo.pDepthStencilState = &depthStencilState;
     pipelineCreateInfo.pColorBlendState = &colorBlendState;
     pipelineCreateInfo.pDynamicState = &dynamicState;
     pipelineCreateInfo.layout = pipelineLayout;
     pipelineCreateInfo.renderPass = renderPass;
     
-    VkPipeline pipeline;
-    result = vkCreateGraphicsPipelines(device, nullptr, 1, &pipelineCreateInfo, nullptr, &pipeline);
-    vkDestroyShaderModule(device, fragmentModule, nullptr);
-    vkDestroyShaderModule(device, vertexModule, nullptr);
+    // depth-only prepass: vertex stage alone, no color writes. The shading pass then runs the fragment shader
+    // once per pixel, only where depth matches exactly. Both use the same vertex module so positions are identical.
+    VkPipelineColorBlendAttachmentState prepassBlendAttachment = {};
+    prepassBlendAttachment.colorWriteMask = 0;
+    prepassBlendAttachment.blendEnable = false;
+    
+    VkPipelineColorBlendStateCreateInfo prepassBlendState = colorBlendState;
+    prepassBlendState.pAttachments = &prepassBlendAttachment;
+    
+    VkGraphicsPipelineCreateInfo pipelineCreateInfos[3] = { pipelineCreateInfo, pipelineCreateInfo, pipelineCreateInfo };
+    pipelineCreateInfos[1].stageCount = 1;
+    pipelineCreateInfos[1].pColorBlendState = &prepassBlendState;
+    pipelineCreateInfos[2].pDepthStencilState = &equalDepthStencilState;
+    
+    report.step("descriptors and render pass");
+    
+    // the main pipelines compile on a worker while the ones below are created, everything they point to lives until
+    // the wait before the shader modules are destroyed
+    VkPipeline pipelines[3];
+    VkResult pipelinesResult = VK_SUCCESS;
+    u32 pipelinesTask = startupTasks.submit("vkCreateGraphicsPipelines", [&]() {
+        pipelinesResult = vkCreateGraphicsPipelines(device, nullptr, 3, pipelineCreateInfos, hostAllocator(VK_OBJECT_TYPE_PIPELINE), pipelines);
+    });
+    
+    // the same pipeline once per layout the vertex format benchmark compares
+    VertexFormat benchmarkFormats[2] = { VertexFormat::full(), compactFormat };
+    VkPipeline formatPipelines[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+    for (u32 i = 0; i < 2 && result == VK_SUCCESS && benchmarkVertexFormats; ++i) {
+        VkVertexInputBindingDescription formatBindings[2] = { vertexBindingDescriptions[0], vertexBindingDescriptions[1] };
+        formatBindings[0].stride = benchmarkFormats[i].stride();
+        
+        VkVertexInputAttributeDescription formatAttributes[VertexFormat::MAX_ATTRIBUTES + 1];
+        u32 formatAttributeCount = benchmarkFormats[i].attributes(0, formatAttributes);
+        formatAttributes[formatAttributeCount] = vertexAttributeDescriptions[vertexAttributeCount];
+        
+        VkPipelineVertexInputStateCreateInfo formatVertexInputState = vertexInputState;
+        formatVertexInputState.pVertexBindingDescriptions = formatBindings;
+        formatVertexInputState.vertexAttributeDescriptionCount = bindless ? formatAttributeCount + 1 : formatAttributeCount;
+        formatVertexInputState.pVertexAttributeDescriptions = formatAttributes;
+        
+        VkGraphicsPipelineCreateInfo formatPipelineCreateInfo = pipelineCreateInfo;
+        formatPipelineCreateInfo.pVertexInputState = &formatVertexInputState;
+        
+        result = vkCreateGraphicsPipelines(device, nullptr, 1, &formatPipelineCreateInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE), &formatPipelines[i]);
+        if (result == VK_SUCCESS) {
+            globals.scope.addMess(vkDestroyPipeline, device, formatPipelines[i], hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+        }
+    }
+    
+    // GPU culled objects come out of indirect commands, each instance reads its bounding sphere from the object buffer
+    const u32 culledObjectCount = 16384;
+    GpuCuller gpuCuller;
+    ParticleSystem particleSystem;
+    VkPipeline culledPipeline = VK_NULL_HANDLE;
+    
+    // the occlusion cull runs between the two halves of the frame on the graphics queue and reads the depth buffer
+    bool withOcclusion = occlusionCulling || benchmarkOcclusion;
+    HiZPyramid hiZPyramid;
+    VkRenderPass earlyRenderPass = VK_NULL_HANDLE;
+    VkRenderPass lateRenderPass = VK_NULL_HANDLE;
+    if (result == VK_SUCCESS && withOcclusion) {
+        VkShaderModule hiZModule = VK_NULL_HANDLE;
+        if (supportsDepthSampling(physicalDevice, swapchain.depthFormat) && loadShaderModule(device, "assets/hiz.comp.spv", &hiZModule)
+            && hiZPyramid.create(device, physicalDevice, hiZModule)
+            && createTwoPhaseRenderPasses(device, swapchain.calculatedFormat, swapchain.depthFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, &earlyRenderPass, &lateRenderPass)) {
+            globals.scope.addMess(vkDestroyRenderPass, device, earlyRenderPass, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS));
+            globals.scope.addMess(vkDestroyRenderPass, device, lateRenderPass, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS));
+            swapchain.depthUsage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+        } else {
+            hiZPyramid.cleanup();
+            withOcclusion = false;
+        }
+        vkDestroyShaderModule(device, hiZModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+        
+        if (!withOcclusion) {
+            std::cout << "Occlusion culling unavailable, culling against the frustum only\n";
+            occlusionCulling = false;
+        }
+    }
+    
+    if (result == VK_SUCCESS && (gpuCulling || benchmarkCulling || withOcclusion)) {
+        std::vector<u32> cullQueueFamilies = { graphicsFamilyIndex };
+        if (computeFamilyIndex != graphicsFamilyIndex && !withOcclusion) {
+            cullQueueFamilies.push_back(computeFamilyIndex);
+        }
+        
+        VkShaderModule culledVertexModule = VK_NULL_HANDLE;
+        VkShaderModule cullModule = VK_NULL_HANDLE;
+        if (loadShaderModule(device, "assets/shader_culled.vert.spv", &culledVertexModule) && loadShaderModule(device, withOcclusion ? "assets/cull_occlusion.comp.spv" : "assets/cull.comp.spv", &cullModule)
+            && gpuCuller.create(device, physicalDevice, caps, cullModule, globals.FRAMES_IN_FLIGHT, benchmarkCulling || benchmarkOcclusion ? 1000000 : culledObjectCount, cullQueueFamilies, withOcclusion)) {
+            VkVertexInputBindingDescription culledBindings[2] = { vertexBindingDescriptions[0], vertexBindingDescriptions[1] };
+            culledBindings[1].stride = sizeof(CullObject);
+            
+            VkVertexInputAttributeDescription culledAttributes[VertexFormat::MAX_ATTRIBUTES + 2];
+            std::copy(vertexAttributeDescriptions, vertexAttributeDescriptions + vertexAttributeCount + 1, culledAttributes);
+            culledAttributes[vertexAttributeCount].offset = offsetof(CullObject, textureIndex);
+            culledAttributes[vertexAttributeCount + 1].binding = 1;
+            culledAttributes[vertexAttributeCount + 1].location = 4;
+            culledAttributes[vertexAttributeCount + 1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            culledAttributes[vertexAttributeCount + 1].offset = offsetof(CullObject, sphere);
+            
+            VkPipelineVertexInputStateCreateInfo culledVertexInputState = vertexInputState;
+            culledVertexInputState.vertexBindingDescriptionCount = 2;
+            culledVertexInputState.pVertexBindingDescriptions = culledBindings;
+            culledVertexInputState.vertexAttributeDescriptionCount = vertexAttributeCount + 2;
+            culledVertexInputState.pVertexAttributeDescriptions = culledAttributes;
+            
+            VkPipelineShaderStageCreateInfo culledStages[2] = { shaderStages[0], shaderStages[1] };
+            culledStages[0].module = culledVertexModule;
+            
+            VkGraphicsPipelineCreateInfo culledPipelineCreateInfo = pipelineCreateInfo;
+            culledPipelineCreateInfo.stageCount = 2;
+            culledPipelineCreateInfo.pStages = culledStages;
+            culledPipelineCreateInfo.pVertexInputState = &culledVertexInputState;
+            
+            if (vkCreateGraphicsPipelines(device, nullptr, 1, &culledPipelineCreateInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE), &culledPipeline) != VK_SUCCESS) {
+                culledPipeline = VK_NULL_HANDLE;
+                gpuCuller.cleanup();
+            }
+        }
+        vkDestroyShaderModule(device, culledVertexModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+        vkDestroyShaderModule(device, cullModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+        
+        if (culledPipeline != VK_NULL_HANDLE) {
+            globals.scope.addMess(vkDestroyPipeline, device, culledPipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+        } else {
+            std::cout << "GPU culling unavailable, drawing the scene directly\n";
+            gpuCulling = false;
+            occlusionCulling = false;
+            withOcclusion = false;
+        }
+    }
+    
+    // simulated on the compute queue when it has its own family, so both families share the buffers
+    if (result == VK_SUCCESS && particleCount > 0) {
+        std::vector<u32> particleQueueFamilies = { graphicsFamilyIndex };
+        if (computeFamilyIndex != graphicsFamilyIndex) {
+            particleQueueFamilies.push_back(computeFamilyIndex);
+        }
+        
+        VkShaderModule particleComputeModule = VK_NULL_HANDLE;
+        VkShaderModule particleVertexModule = VK_NULL_HANDLE;
+        VkShaderModule particleFragmentModule = VK_NULL_HANDLE;
+        if (loadShaderModule(device, "assets/particles.comp.spv", &particleComputeModule) && loadShaderModule(device, "assets/particle.vert.spv", &particleVertexModule) && loadShaderModule(device, "assets/particle.frag.spv", &particleFragmentModule)
+            && particleSystem.create(device, physicalDevice, renderPass, particleComputeModule, particleVertexModule, particleFragmentModule, particleCount, globals.FRAMES_IN_FLIGHT, particleQueueFamilies)) {
+            particleSystem.emitRate = static_cast<f32>(particleCount) / particleSystem.lifetime;
+        } else {
+            std::cout << "Particles unavailable\n";
+            particleCount = 0;
+        }
+        vkDestroyShaderModule(device, particleComputeModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+        vkDestroyShaderModule(device, particleVertexModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+        vkDestroyShaderModule(device, particleFragmentModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    }
+    report.step("optional pipelines");
+    
+    startupTasks.wait(pipelinesTask);
+    report.step("pipelines wait");
+    if (pipelinesResult != VK_SUCCESS) {
+        result = pipelinesResult;
+    }
+    
+    vkDestroyShaderModule(device, fragmentModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    vkDestroyShaderModule(device, vertexModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    vkDestroyShaderModule(device, bindlessFragmentModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
+    vkDestroyShaderModule(device, bindlessVertexModule, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE));
     
     if (result != VK_SUCCESS) {
         return 1;
     }
-    globals.scope.addMess(vkDestroyPipeline, device, pipeline, nullptr);
+    VkPipeline pipeline = pipelines[0];
+    VkPipeline depthPrepassPipeline = pipelines[1];
+    VkPipeline depthEqualPipeline = pipelines[2];
+    globals.scope.addMess(vkDestroyPipeline, device, pipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+    globals.scope.addMess(vkDestroyPipeline, device, depthPrepassPipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+    globals.scope.addMess(vkDestroyPipeline, device, depthEqualPipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
     
     if (!swapchain.createFramebuffers(renderPass)) {
         return 1;
@@ -1019,21 +3651,47 @@ int main(int argc, char** argv) {
     graphicsCommandPoolCreateInfo.queueFamilyIndex = graphicsFamilyIndex;
     
     VkCommandPool graphicsCommandPool;
-    if (vkCreateCommandPool(device, &graphicsCommandPoolCreateInfo, nullptr, &graphicsCommandPool) != VK_SUCCESS) {
-        return 1;
-    }
-    globals.scope.addMess(vkDestroyCommandPool, device, graphicsCommandPool, nullptr);
-    
-    VkCommandBufferAllocateInfo graphicsCommandBufferAllocateInfo = {};
-    graphicsCommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    graphicsCommandBufferAllocateInfo.commandPool = graphicsCommandPool;
-    graphicsCommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    graphicsCommandBufferAllocateInfo.commandBufferCount = globals.FRAMES_IN_FLIGHT;
-    
-    std::vector<VkCommandBuffer> graphicsCommandBuffers(globals.FRAMES_IN_FLIGHT);
-    if (vkAllocateCommandBuffers(device, &graphicsCommandBufferAllocateInfo, graphicsCommandBuffers.data()) != VK_SUCCESS) {
+    if (vkCreateCommandPool(device, &graphicsCommandPoolCreateInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &graphicsCommandPool) != VK_SUCCESS) {
         return 1;
     }
+    globals.scope.addMess(vkDestroyCommandPool, device, graphicsCommandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    
+    StaticCommandBuffers staticCommands(device, graphicsCommandPool);
+    u32 recordedSwapchainGeneration = 0;
+    u32 lodSwapchainGeneration = 0;
+    
+    // the occlusion cull's compute around the swapchain's render passes, one pair per frame in flight for its cull
+    // buffers: the early cull before the early pass, then the pyramid and the late cull between the two passes. The
+    // imports' final states hand the indirect commands to the draws and the depth buffer back to the late pass.
+    std::vector<RenderGraph> earlyCullGraphs(occlusionCulling ? globals.FRAMES_IN_FLIGHT : 0);
+    std::vector<RenderGraph> lateCullGraphs(occlusionCulling ? globals.FRAMES_IN_FLIGHT : 0);
+    auto buildCullGraphs = [&]() -> bool {
+        for (u32 i = 0; i < earlyCullGraphs.size(); ++i) {
+            RenderGraph& early = earlyCullGraphs[i];
+            early.init(device, physicalDevice);
+            gpuCuller.addCullPass(early, i, GpuCuller::EARLY);
+            
+            RenderGraph& late = lateCullGraphs[i];
+            late.init(device, physicalDevice);
+            u32 depth = late.importImage(swapchain.depthImage, swapchain.depthImageView, swapchain.depthFormat, swapchain.currentExtent, hiZPyramid.depthAspect,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+            // rebuilt from scratch each frame, once the previous frame's late cull is done sampling it
+            u32 pyramid = late.importImage(hiZPyramid.image, hiZPyramid.view, VK_FORMAT_R32_SFLOAT, hiZPyramid.extent, VK_IMAGE_ASPECT_COLOR_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+            u32 hiZPass = late.addPass("hi-z", RenderGraph::PASS_COMPUTE, [&](VkCommandBuffer commandBuffer) {
+                hiZPyramid.recordReduce(commandBuffer);
+            });
+            late.readImage(hiZPass, depth, RenderGraph::ACCESS_SAMPLED_COMPUTE);
+            late.writeImage(hiZPass, pyramid, RenderGraph::ACCESS_STORAGE_WRITE_COMPUTE);
+            gpuCuller.addCullPass(late, i, GpuCuller::LATE, pyramid);
+            
+            if (!early.compile() || !late.compile()) {
+                return false;
+            }
+        }
+        return true;
+    };
     
     VkSemaphoreCreateInfo semaphoreCreateInfo = {};
     semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1041,27 +3699,85 @@ int main(int argc, char** argv) {
     std::vector<VkSemaphore> imageAvailableSemaphores(globals.FRAMES_IN_FLIGHT);
     std::vector<VkSemaphore> renderFinishedSemaphores(globals.FRAMES_IN_FLIGHT);
     for (usize i = 0; i < globals.FRAMES_IN_FLIGHT; ++i) {
-        if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS) {
+        if (vkCreateSemaphore(device, &semaphoreCreateInfo, hostAllocator(VK_OBJECT_TYPE_SEMAPHORE), &imageAvailableSemaphores[i]) != VK_SUCCESS) {
             return 1;
         }
-        globals.scope.addMess(vkDestroySemaphore, device, imageAvailableSemaphores[i], nullptr);
+        globals.scope.addMess(vkDestroySemaphore, device, imageAvailableSemaphores[i], hostAllocator(VK_OBJECT_TYPE_SEMAPHORE));
         
-        if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS) {
+        if (vkCreateSemaphore(device, &semaphoreCreateInfo, hostAllocator(VK_OBJECT_TYPE_SEMAPHORE), &renderFinishedSemaphores[i]) != VK_SUCCESS) {
             return 1;
         }
-        globals.scope.addMess(vkDestroySemaphore, device, renderFinishedSemaphores[i], nullptr);
+        globals.scope.addMess(vkDestroySemaphore, device, renderFinishedSemaphores[i], hostAllocator(VK_OBJECT_TYPE_SEMAPHORE));
     }
     
-    VkFenceCreateInfo fenceCreateInfo = {};
-    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    
-    std::vector<VkFence> inFlightFences(globals.FRAMES_IN_FLIGHT);
-    for (usize i = 0; i < globals.FRAMES_IN_FLIGHT; ++i) {
-        if (vkCreateFence(device, &fenceCreateInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+    // a frame slot is free again once the graphics queue reaches the value of the slot's last submit
+    QueueTimeline graphicsTimeline;
+    QueueTimeline computeTimeline;
+    QueueTimeline transferTimeline;
+    if (!graphicsTimeline.create(device, caps, graphicsQueue) || !computeTimeline.create(device, caps, computeQueue) || !transferTimeline.create(device, caps, transferQueue)) {
+        return 1;
+    }
+    std::vector<u64> frameTimelineValues(globals.FRAMES_IN_FLIGHT, 0);
+    
+    // the cull and the particle step for a frame slot run on the compute queue and hand their draws to the graphics
+    // submit, through the compute timeline or, without timeline semaphores, a binary semaphore per slot
+    std::vector<VkCommandBuffer> computeCommandBuffers;
+    std::vector<VkSemaphore> computeFinishedSemaphores;
+    if ((gpuCulling && !occlusionCulling) || particleCount > 0) {
+        VkCommandPoolCreateInfo computeCommandPoolCreateInfo = {};
+        computeCommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        computeCommandPoolCreateInfo.queueFamilyIndex = computeFamilyIndex;
+        
+        VkCommandPool computeCommandPool;
+        if (vkCreateCommandPool(device, &computeCommandPoolCreateInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &computeCommandPool) != VK_SUCCESS) {
+            return 1;
+        }
+        globals.scope.addMess(vkDestroyCommandPool, device, computeCommandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
+        
+        VkCommandBufferAllocateInfo computeCommandBufferAllocateInfo = {};
+        computeCommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        computeCommandBufferAllocateInfo.commandPool = computeCommandPool;
+        computeCommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        computeCommandBufferAllocateInfo.commandBufferCount = globals.FRAMES_IN_FLIGHT;
+        
+        computeCommandBuffers.resize(globals.FRAMES_IN_FLIGHT);
+        if (vkAllocateCommandBuffers(device, &computeCommandBufferAllocateInfo, computeCommandBuffers.data()) != VK_SUCCESS) {
             return 1;
         }
-        globals.scope.addMess(vkDestroyFence, device, inFlightFences[i], nullptr);
+        
+        computeFinishedSemaphores.resize(computeTimeline.timeline ? 0 : globals.FRAMES_IN_FLIGHT);
+        for (usize i = 0; i < computeFinishedSemaphores.size(); ++i) {
+            if (vkCreateSemaphore(device, &semaphoreCreateInfo, hostAllocator(VK_OBJECT_TYPE_SEMAPHORE), &computeFinishedSemaphores[i]) != VK_SUCCESS) {
+                return 1;
+            }
+            globals.scope.addMess(vkDestroySemaphore, device, computeFinishedSemaphores[i], hostAllocator(VK_OBJECT_TYPE_SEMAPHORE));
+        }
+        
+        // every particle starts out dead, before any step is submitted
+        if (particleCount > 0) {
+            computeCommandBufferAllocateInfo.commandBufferCount = 1;
+            
+            VkCommandBuffer resetCommandBuffer;
+            if (vkAllocateCommandBuffers(device, &computeCommandBufferAllocateInfo, &resetCommandBuffer) != VK_SUCCESS) {
+                return 1;
+            }
+            
+            VkCommandBufferBeginInfo resetBeginInfo = {};
+            resetBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            resetBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            if (vkBeginCommandBuffer(resetCommandBuffer, &resetBeginInfo) != VK_SUCCESS) {
+                return 1;
+            }
+            particleSystem.recordReset(resetCommandBuffer);
+            if (vkEndCommandBuffer(resetCommandBuffer) != VK_SUCCESS) {
+                return 1;
+            }
+            
+            if (!computeTimeline.wait(computeTimeline.submit(1, &resetCommandBuffer))) {
+                return 1;
+            }
+            vkFreeCommandBuffers(device, computeCommandPool, 1, &resetCommandBuffer);
+        }
     }
     
     Vertex vertices[] = {
@@ -1092,60 +3808,80 @@ int main(int argc, char** argv) {
         1, 2, 3,
     };
     
-    VkBufferCreateInfo bufferCreateInfo = {};
-    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferCreateInfo.size = sizeof(vertices) + sizeof(indices);
-    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    
-    VkBuffer uploadBuffer;
-    if (vkCreateBuffer(device, &bufferCreateInfo, nullptr, &uploadBuffer) != VK_SUCCESS) {
-        return 1;
-    }
-    
-    VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements(device, uploadBuffer, &memoryRequirements);
-    
     VkPhysicalDeviceMemoryProperties memoryProperties;
     vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
     
-    VkMemoryAllocateInfo memoryAllocateInfo = {};
-    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.allocationSize = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memoryProperties);
-    
-    VkDeviceMemory uploadMemory;
-    if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &uploadMemory) != VK_SUCCESS) {
-        return 1;
+    // every mesh is suballocated from the pool, one bind serves all of them and draws pick theirs by firstIndex/vertexOffset
+    std::vector<u32> geometryQueueFamilies = { graphicsFamilyIndex };
+    if (transferFamilyIndex != graphicsFamilyIndex) {
+        geometryQueueFamilies.push_back(transferFamilyIndex);
     }
     
-    vkBindBufferMemory(device, uploadBuffer, uploadMemory, 0);
-    
-    void* uploadData;
-    if (vkMapMemory(device, uploadMemory, 0, memoryRequirements.size, 0, &uploadData) != VK_SUCCESS) {
+    GeometryPool geometry;
+    if (!geometry.create(device, physicalDevice, vertexFormat.stride(), 1 << 20, 1 << 22, static_cast<u32>(globals.FRAMES_IN_FLIGHT), 16 << 20, geometryQueueFamilies, directUpload)) {
+        std::cout << "Failed to create geometry pool\n";
         return 1;
     }
-    memcpy(uploadData, vertices, sizeof(vertices));
-    memcpy(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(uploadData) + sizeof(vertices)), indices, sizeof(indices));
-    vkUnmapMemory(device, uploadMemory);
-    
-    bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     
-    VkBuffer meshBuffer;
-    if (vkCreateBuffer(device, &bufferCreateInfo, nullptr, &meshBuffer) != VK_SUCCESS) {
+    std::vector<u8> encodedVertices;
+    VertexDecode quadDecode = encodeVertices(vertexFormat, vertices, nullptr, sizeof(vertices) / sizeof(vertices[0]), encodedVertices);
+    u32 quadMesh = geometry.addMesh(encodedVertices.data(), sizeof(vertices) / sizeof(vertices[0]), indices, sizeof(indices) / sizeof(indices[0]), quadDecode);
+    if (quadMesh == GeometryPool::INVALID_MESH) {
         return 1;
     }
-    
-    vkGetBufferMemoryRequirements(device, meshBuffer, &memoryRequirements);
-    
-    VkDeviceMemory meshMemory;
-    if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &meshMemory) != VK_SUCCESS) {
-        return 1;
+    MeshRange quad = geometry.mesh(quadMesh);
+    
+    // a cooked mesh replaces the quad in the directly drawn scene, GPU culled objects stay quads
+    MeshRange sceneMesh = quad;
+    LodChain sceneLods;
+    if (meshPath != nullptr) {
+        CookedMesh cooked;
+        u32 mesh = GeometryPool::INVALID_MESH;
+        if (!cooked.open(meshPath)) {
+            std::cout << "Failed to open cooked mesh " << meshPath << "\n";
+        } else if (cooked.header->position != vertexFormat.position || cooked.header->color != vertexFormat.color
+                   || cooked.header->uv != vertexFormat.uv || cooked.header->normal != vertexFormat.normal) {
+            std::cout << "Cooked mesh " << meshPath << " has a different vertex format than this device draws with, cook it again" << (fullVertices ? " with --full-vertices" : "") << "\n";
+        } else {
+            mesh = geometry.addMesh(cooked.vertices, cooked.header->vertexCount, cooked.indices, static_cast<VkIndexType>(cooked.header->indexType), cooked.header->indexCount, cooked.header->decode);
+            if (mesh == GeometryPool::INVALID_MESH) {
+                std::cout << "Cooked mesh " << meshPath << " does not fit the geometry pool\n";
+            }
+        }
+        
+        if (mesh != GeometryPool::INVALID_MESH) {
+            sceneMesh = geometry.mesh(mesh);
+            
+            // fold a fit into the decode: the largest extent spans [-0.5, 0.5] around (0, 0, 0.5), inside the view
+            f32 extent = 0.0f;
+            f32 center[3];
+            for (u32 axis = 0; axis < 3; ++axis) {
+                extent = std::max(extent, cooked.header->boundsMax[axis] - cooked.header->boundsMin[axis]);
+                center[axis] = (cooked.header->boundsMin[axis] + cooked.header->boundsMax[axis]) * 0.5f;
+            }
+            f32 fit = extent > 0.0f ? 1.0f / extent : 1.0f;
+            for (u32 axis = 0; axis < 3; ++axis) {
+                sceneMesh.decode.scale[axis] *= fit;
+                sceneMesh.decode.bias[axis] = (sceneMesh.decode.bias[axis] - center[axis]) * fit + (axis == 2 ? 0.5f : 0.0f);
+            }
+            
+            // level ranges are relative to the mesh's indices and their errors in its model units, which the fit scales
+            sceneLods.count = cooked.header->lodCount;
+            for (u32 k = 0; k < sceneLods.count; ++k) {
+                sceneLods.firstIndex[k] = sceneMesh.firstIndex + cooked.header->lods[k].firstIndex;
+                sceneLods.indexCount[k] = cooked.header->lods[k].indexCount;
+                sceneLods.error[k] = cooked.header->lods[k].error * fit;
+            }
+        }
     }
-    globals.scope.addMess(vkDestroyBuffer, device, meshBuffer, nullptr);
-    globals.scope.addMess(vkFreeMemory, device, meshMemory, nullptr);
     
-    vkBindBufferMemory(device, meshBuffer, meshMemory, 0);
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    
+    VkBuffer uploadBuffer;
+    VkMemoryRequirements memoryRequirements;
+    VkDeviceMemory uploadMemory;
+    void* uploadData;
     
     VkCommandPoolCreateInfo transferCommandPoolCreateInfo = {};
     transferCommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -1153,10 +3889,10 @@ int main(int argc, char** argv) {
     transferCommandPoolCreateInfo.queueFamilyIndex = transferFamilyIndex;
     
     VkCommandPool transferCommandPool;
-    if (vkCreateCommandPool(device, &transferCommandPoolCreateInfo, nullptr, &transferCommandPool) != VK_SUCCESS) {
+    if (vkCreateCommandPool(device, &transferCommandPoolCreateInfo, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL), &transferCommandPool) != VK_SUCCESS) {
         return 1;
     }
-    globals.scope.addMess(vkDestroyCommandPool, device, transferCommandPool, nullptr);
+    globals.scope.addMess(vkDestroyCommandPool, device, transferCommandPool, hostAllocator(VK_OBJECT_TYPE_COMMAND_POOL));
     
     VkCommandBufferAllocateInfo transferCommandBufferAllocateInfo = {};
     transferCommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -1176,93 +3912,67 @@ int main(int argc, char** argv) {
         return 1;
     }
     
-    VkBufferCopy bufferCopyRegion = {};
-    bufferCopyRegion.size = sizeof(vertices) + sizeof(indices);
-    
-    vkCmdCopyBuffer(transferCommandBuffer, uploadBuffer, meshBuffer, 1, &bufferCopyRegion);
+    // the queue is waited on below, so no barrier is needed before the first draw
+    geometry.recordUploads(transferCommandBuffer, 0);
     
     vkEndCommandBuffer(transferCommandBuffer);
     
-    VkSubmitInfo transferSubmitInfo = {};
-    transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    transferSubmitInfo.commandBufferCount = 1;
-    transferSubmitInfo.pCommandBuffers = &transferCommandBuffer;
-    
-    vkQueueSubmit(transferQueue, 1, &transferSubmitInfo, nullptr);
-    vkQueueWaitIdle(transferQueue);
-    
-    vkDestroyBuffer(device, uploadBuffer, nullptr);
-    vkFreeMemory(device, uploadMemory, nullptr);
-    
-    VkDescriptorPoolSize descriptorPoolSizes[2];
-    descriptorPoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    descriptorPoolSizes[0].descriptorCount = static_cast<u32>(globals.FRAMES_IN_FLIGHT);
-    descriptorPoolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorPoolSizes[1].descriptorCount = static_cast<u32>(globals.FRAMES_IN_FLIGHT);
-    
-    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
-    descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptorPoolCreateInfo.maxSets = globals.FRAMES_IN_FLIGHT;
-    descriptorPoolCreateInfo.poolSizeCount = 2;
-    descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes;
-    descriptorPoolCreateInfo.maxSets = globals.FRAMES_IN_FLIGHT;
-    
-    VkDescriptorPool descriptorPool;
-    if (vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+    if (!transferTimeline.wait(transferTimeline.submit(1, &transferCommandBuffer))) {
         return 1;
     }
-    globals.scope.addMess(vkDestroyDescriptorPool, device, descriptorPool, nullptr);
     
-    std::vector<VkDescriptorSetLayout> descriptorSetLayouts(globals.FRAMES_IN_FLIGHT, descriptorSetLayout);
-    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
-    descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptorSetAllocateInfo.descriptorPool = descriptorPool;
-    descriptorSetAllocateInfo.descriptorSetCount = static_cast<u32>(globals.FRAMES_IN_FLIGHT);
-    descriptorSetAllocateInfo.pSetLayouts = descriptorSetLayouts.data();
-    
-    std::vector<VkDescriptorSet> descriptorSets(globals.FRAMES_IN_FLIGHT);
-    if (vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, descriptorSets.data()) != VK_SUCCESS) {
+    // meshes streamed in while running are copied by a small command buffer submitted ahead of the frame's own
+    std::vector<VkCommandBuffer> geometryUploadCommandBuffers(globals.FRAMES_IN_FLIGHT);
+    VkCommandBufferAllocateInfo geometryUploadAllocateInfo = {};
+    geometryUploadAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    geometryUploadAllocateInfo.commandPool = graphicsCommandPool;
+    geometryUploadAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    geometryUploadAllocateInfo.commandBufferCount = static_cast<u32>(geometryUploadCommandBuffers.size());
+    if (vkAllocateCommandBuffers(device, &geometryUploadAllocateInfo, geometryUploadCommandBuffers.data()) != VK_SUCCESS) {
         return 1;
     }
     
-    std::cout << std::filesystem::current_path();
-    
-    ktga_t ktga {};
-    {
-        std::ifstream file("assets/test.tga", std::ios::ate | std::ios::binary);
-        if (!file.is_open()) {
-            std::cout << "Failed to open assets/test.tga\n";
-            throw std::runtime_error("Failed to open test.tga");
-        }
+    // the per-frame sets are written once and bound by the static command buffers, so they live for the whole run
+    std::vector<DescriptorAllocator::PoolRatio> descriptorPoolRatios = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, bindless ? 0.0f : 1.0f },
+    };
 
-        size_t size = file.tellg();
-        std::vector<unsigned char> bytes(size);
-        file.seekg(0);
-        file.read(reinterpret_cast<char*>(bytes.data()), size);
-        file.close();
+    DescriptorAllocator descriptorAllocator;
+    descriptorAllocator.init(device, static_cast<u32>(globals.FRAMES_IN_FLIGHT), descriptorPoolRatios);
 
-        int ret = ktga_load(&ktga, (void*) bytes.data(), bytes.size());
-        if (ret != 0) {
-            std::cout << "Failed to load assets/test.tga\n" << ret;
-            throw std::runtime_error("Failed to load test.tga");
+    std::vector<VkDescriptorSet> descriptorSets(globals.FRAMES_IN_FLIGHT);
+    for (VkDescriptorSet& descriptorSet : descriptorSets) {
+        if (!descriptorAllocator.allocate(descriptorSetLayout, &descriptorSet)) {
+            return 1;
         }
     }
     
+    std::cout << std::filesystem::current_path();
+    
+    report.step("geometry and buffers");
+    startupTasks.wait(textureTask);
+    report.step("texture decode wait");
+    if (!textureOpened) {
+        std::cout << "Failed to open assets/test.tga\n";
+        throw std::runtime_error("Failed to open test.tga");
+    }
+    if (textureResult != 0) {
+        std::cout << "Failed to load assets/test.tga\n" << textureResult;
+        throw std::runtime_error("Failed to load test.tga");
+    }
+    
     bufferCreateInfo.size = ktga.header.img_w * ktga.header.img_h * (ktga.header.bpp / 8);
     bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     
-    if (vkCreateBuffer(device, &bufferCreateInfo, nullptr, &uploadBuffer) != VK_SUCCESS) {
+    if (vkCreateBuffer(device, &bufferCreateInfo, hostAllocator(VK_OBJECT_TYPE_BUFFER), &uploadBuffer) != VK_SUCCESS) {
         return 1;
     }
     
     vkGetBufferMemoryRequirements(device, uploadBuffer, &memoryRequirements);
     
-    memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.allocationSize = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memoryProperties);
-    
-    if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &uploadMemory) != VK_SUCCESS) {
+    if (!allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_STAGING, &uploadMemory)) {
         return 1;
     }
     
@@ -1293,23 +4003,20 @@ int main(int argc, char** argv) {
     imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     
-    if (vkCreateImage(device, &imageCreateInfo, nullptr, &image) != VK_SUCCESS) {
+    if (vkCreateImage(device, &imageCreateInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE), &image) != VK_SUCCESS) {
         return 1;
     }
     
     vkGetImageMemoryRequirements(device, image, &memoryRequirements);
     
-    memoryAllocateInfo.allocationSize = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryProperties);
-    
-    if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+    if (!allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_TEXTURES, &imageMemory)) {
         return 1;
     }
     
     vkBindImageMemory(device, image, imageMemory, 0);
     
-    globals.scope.addMess(vkFreeMemory, device, imageMemory, nullptr);
-    globals.scope.addMess(vkDestroyImage, device, image, nullptr);
+    globals.scope.addMess(freeMemory, device, imageMemory);
+    globals.scope.addMess(vkDestroyImage, device, image, hostAllocator(VK_OBJECT_TYPE_IMAGE));
     
     transferCommandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     
@@ -1317,21 +4024,6 @@ int main(int argc, char** argv) {
         return 1;
     }
     
-    VkImageMemoryBarrier imageMemoryBarrier = {};
-    imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    imageMemoryBarrier.srcAccessMask = 0;
-    imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imageMemoryBarrier.image = image;
-    imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    imageMemoryBarrier.subresourceRange.levelCount = 1;
-    imageMemoryBarrier.subresourceRange.layerCount = 1;
-    
-    vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-    
     VkBufferImageCopy bufferImageCopyRegion = {};
     bufferImageCopyRegion.bufferOffset = 0;
     bufferImageCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -1340,26 +4032,30 @@ int main(int argc, char** argv) {
     bufferImageCopyRegion.imageExtent.height = ktga.header.img_h;
     bufferImageCopyRegion.imageExtent.depth = 1;
     
-    vkCmdCopyBufferToImage(transferCommandBuffer, uploadBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopyRegion);
-    
-    imageMemoryBarrier.srcAccessMask = imageMemoryBarrier.dstAccessMask;
-    imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    imageMemoryBarrier.oldLayout = imageMemoryBarrier.newLayout;
-    imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    // the graph derives both transitions around the copy from what the pass declares
+    RenderGraph uploadGraph;
+    uploadGraph.init(device, physicalDevice);
+    u32 textureResource = uploadGraph.importImage(image, VK_NULL_HANDLE, VK_FORMAT_B8G8R8A8_SRGB, { ktga.header.img_w, ktga.header.img_h }, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    uploadGraph.markOutput(textureResource);
+    u32 uploadPass = uploadGraph.addPass("texture upload", RenderGraph::PASS_TRANSFER, [&](VkCommandBuffer commandBuffer) {
+        vkCmdCopyBufferToImage(commandBuffer, uploadBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopyRegion);
+    });
+    uploadGraph.writeImage(uploadPass, textureResource, RenderGraph::ACCESS_TRANSFER_WRITE);
     
-    vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+    if (!uploadGraph.compile()) {
+        return 1;
+    }
+    uploadGraph.execute(transferCommandBuffer);
     
     vkEndCommandBuffer(transferCommandBuffer);
     
-    transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    transferSubmitInfo.commandBufferCount = 1;
-    transferSubmitInfo.pCommandBuffers = &transferCommandBuffer;
-    
-    vkQueueSubmit(transferQueue, 1, &transferSubmitInfo, nullptr);
-    vkQueueWaitIdle(transferQueue);
+    if (!transferTimeline.wait(transferTimeline.submit(1, &transferCommandBuffer))) {
+        return 1;
+    }
     
-    vkDestroyBuffer(device, uploadBuffer, nullptr);
-    vkFreeMemory(device, uploadMemory, nullptr);
+    vkDestroyBuffer(device, uploadBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, uploadMemory);
+    report.step("texture upload");
     
     VkImageViewCreateInfo imageViewCreateInfo = {};
     imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -1371,10 +4067,10 @@ int main(int argc, char** argv) {
     imageViewCreateInfo.subresourceRange.levelCount = 1;
     
     VkImageView imageView;
-    if (vkCreateImageView(device, &imageViewCreateInfo, nullptr, &imageView) != VK_SUCCESS) {
+    if (vkCreateImageView(device, &imageViewCreateInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), &imageView) != VK_SUCCESS) {
         return 1;
     }
-    globals.scope.addMess(vkDestroyImageView, device, imageView, nullptr);
+    globals.scope.addMess(vkDestroyImageView, device, imageView, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
     
     VkSamplerCreateInfo samplerCreateInfo = {};
     samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -1392,14 +4088,20 @@ int main(int argc, char** argv) {
     samplerCreateInfo.minLod = 0.0f;
     samplerCreateInfo.maxLod = 0.0f;
     
-    if (vkCreateSampler(device, &samplerCreateInfo, nullptr, &imageSampler) != VK_SUCCESS) {
+    if (vkCreateSampler(device, &samplerCreateInfo, hostAllocator(VK_OBJECT_TYPE_SAMPLER), &imageSampler) != VK_SUCCESS) {
         return 1;
     }
-    globals.scope.addMess(vkDestroySampler, device, imageSampler, nullptr);
+    globals.scope.addMess(vkDestroySampler, device, imageSampler, hostAllocator(VK_OBJECT_TYPE_SAMPLER));
+    
+    InstanceData instanceData = {};
+    if (bindless) {
+        instanceData.textureIndex = textureTable.add(imageView, imageSampler);
+    }
     
     std::vector<VkBuffer> uniformBuffers(globals.FRAMES_IN_FLIGHT);
     std::vector<VkDeviceMemory> uniformMemories(globals.FRAMES_IN_FLIGHT);
     std::vector<void*> uniformMapped(globals.FRAMES_IN_FLIGHT);
+    std::vector<FrameDescriptorData> frameDescriptorData(globals.FRAMES_IN_FLIGHT);
     
     for (u32 i = 0; i < globals.FRAMES_IN_FLIGHT; ++i) {
         VkBufferCreateInfo info = {};
@@ -1408,54 +4110,227 @@ int main(int argc, char** argv) {
         info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
         info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         
-        if (vkCreateBuffer(device, &info, nullptr, &uniformBuffers[i]) != VK_SUCCESS) {
+        if (vkCreateBuffer(device, &info, hostAllocator(VK_OBJECT_TYPE_BUFFER), &uniformBuffers[i]) != VK_SUCCESS) {
             return 1;
         }
         
         vkGetBufferMemoryRequirements(device, uniformBuffers[i], &memoryRequirements);
         
-        VkMemoryAllocateInfo memoryInfo = {};
-        memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        memoryInfo.allocationSize = memoryRequirements.size;
-        memoryInfo.memoryTypeIndex = findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, memoryProperties);
-        
-        if (vkAllocateMemory(device, &memoryInfo, nullptr, &uniformMemories[i]) != VK_SUCCESS) {
+        if (!allocateMemory(device, memoryProperties, memoryRequirements, hostWriteMemory(memoryProperties, memoryRequirements.memoryTypeBits, memoryRequirements.size, directUpload), MemoryBudget::CATEGORY_UNIFORMS, &uniformMemories[i])) {
             return 1;
         }
-        globals.scope.addMess(vkFreeMemory, device, uniformMemories[i], nullptr);
-        globals.scope.addMess(vkDestroyBuffer, device, uniformBuffers[i], nullptr);
+        globals.scope.addMess(freeMemory, device, uniformMemories[i]);
+        globals.scope.addMess(vkDestroyBuffer, device, uniformBuffers[i], hostAllocator(VK_OBJECT_TYPE_BUFFER));
         
         vkBindBufferMemory(device, uniformBuffers[i], uniformMemories[i], 0);
         vkMapMemory(device, uniformMemories[i], 0, sizeof(UniformBuffer), 0, &uniformMapped[i]);
         
-        VkDescriptorBufferInfo bufferInfo = {};
-        bufferInfo.buffer = uniformBuffers[i];
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(UniformBuffer);
+        frameDescriptorData[i].uniform.buffer = uniformBuffers[i];
+        frameDescriptorData[i].uniform.offset = 0;
+        frameDescriptorData[i].uniform.range = sizeof(UniformBuffer);
+        frameDescriptorData[i].texture.imageView = imageView;
+        frameDescriptorData[i].texture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        frameDescriptorData[i].texture.sampler = imageSampler;
+    }
+    
+    VkDescriptorUpdateTemplateEntry descriptorTemplateEntries[2] = {};
+    descriptorTemplateEntries[0].dstBinding = 0;
+    descriptorTemplateEntries[0].descriptorCount = 1;
+    descriptorTemplateEntries[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    descriptorTemplateEntries[0].offset = offsetof(FrameDescriptorData, uniform);
+    descriptorTemplateEntries[0].stride = sizeof(FrameDescriptorData);
+    descriptorTemplateEntries[1].dstBinding = 1;
+    descriptorTemplateEntries[1].descriptorCount = 1;
+    descriptorTemplateEntries[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorTemplateEntries[1].offset = offsetof(FrameDescriptorData, texture);
+    descriptorTemplateEntries[1].stride = sizeof(FrameDescriptorData);
+    
+    DescriptorTemplate descriptorTemplate;
+    descriptorTemplate.create(device, caps, descriptorSetLayout, descriptorTemplateEntries, bindless ? 1 : 2);
+    
+    if (benchmarkDescriptors) {
+        benchmarkDescriptorUpdates(device, descriptorSetLayout, descriptorTemplate, frameDescriptorData[0], !bindless, 10000);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (descriptorTemplate.isCreated()) {
+        for (u32 i = 0; i < globals.FRAMES_IN_FLIGHT; ++i) {
+            descriptorTemplate.update(descriptorSets[i], &frameDescriptorData[i]);
+        }
+    } else {
+        DescriptorWriter writer(device);
+        for (u32 i = 0; i < globals.FRAMES_IN_FLIGHT; ++i) {
+            writer.writeBuffer(descriptorSets[i], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uniformBuffers[i], 0, sizeof(UniformBuffer));
+            if (!bindless) {
+                writer.writeImage(descriptorSets[i], 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageView, imageSampler);
+            }
+        }
+        writer.flush();
+    }
+    
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    if (bindless) {
+        VkBufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size = sizeof(InstanceData);
+        info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        
+        if (vkCreateBuffer(device, &info, hostAllocator(VK_OBJECT_TYPE_BUFFER), &instanceBuffer) != VK_SUCCESS) {
+            return 1;
+        }
+        
+        vkGetBufferMemoryRequirements(device, instanceBuffer, &memoryRequirements);
+        
+        VkDeviceMemory instanceMemory;
+        if (!allocateMemory(device, memoryProperties, memoryRequirements, hostWriteMemory(memoryProperties, memoryRequirements.memoryTypeBits, memoryRequirements.size, directUpload), MemoryBudget::CATEGORY_OTHER, &instanceMemory)) {
+            return 1;
+        }
+        globals.scope.addMess(freeMemory, device, instanceMemory);
+        globals.scope.addMess(vkDestroyBuffer, device, instanceBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        
+        vkBindBufferMemory(device, instanceBuffer, instanceMemory, 0);
+        
+        void* instanceMapped;
+        if (vkMapMemory(device, instanceMemory, 0, sizeof(InstanceData), 0, &instanceMapped) != VK_SUCCESS) {
+            return 1;
+        }
+        memcpy(instanceMapped, &instanceData, sizeof(InstanceData));
+        vkUnmapMemory(device, instanceMemory);
+    }
+    
+    if (benchmarkCulling) {
+        if (!gpuCuller.isCreated()) {
+            std::cout << "Frustum culling benchmark: unsupported on this device\n";
+            return 1;
+        }
+        
+        OffscreenTarget target;
+        if (!target.create(device, physicalDevice, swapchain.calculatedFormat, swapchain.depthFormat, swapchain.currentExtent)) {
+            return 1;
+        }
+        
+        VkDescriptorSet benchmarkSets[2] = { descriptorSets[0], textureTable.set };
+        benchmarkFrustumCulling(device, graphicsQueue, graphicsFamilyIndex, memoryProperties, target, pipelineLayout, culledPipeline, benchmarkSets, bindless ? 2 : 1, uniformMapped[0], gpuCuller, geometry, quad);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (benchmarkOcclusion) {
+        if (!withOcclusion) {
+            std::cout << "Occlusion culling benchmark: unsupported on this device\n";
+            return 1;
+        }
+        
+        OffscreenTarget target;
+        if (!target.create(device, physicalDevice, swapchain.calculatedFormat, swapchain.depthFormat, swapchain.currentExtent, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT)) {
+            return 1;
+        }
+        
+        VkDescriptorSet benchmarkSets[2] = { descriptorSets[0], textureTable.set };
+        benchmarkOcclusionCulling(device, caps, graphicsQueue, graphicsFamilyIndex, memoryProperties, target, swapchain.depthFormat, earlyRenderPass, lateRenderPass, hiZPyramid, pipelineLayout, culledPipeline, benchmarkSets, bindless ? 2 : 1, uniformMapped[0], gpuCuller, geometry, quad);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (gpuCulling) {
+        // a field of small quads around the view volume, most of which the cull throws away
+        const f32 fieldMin[3] = { -3.0f, -3.0f, 0.0f };
+        const f32 fieldMax[3] = { 3.0f, 3.0f, 1.0f };
+        std::vector<CullObject> objects = generateCullObjects(culledObjectCount, fieldMin, fieldMax, 0.02f, 0.08f, quad, instanceData.textureIndex);
+        gpuCuller.setObjects(objects.data(), culledObjectCount);
+    }
+    
+    // the frustum cull and the particle step; the occlusion cull is recorded into the frame's own command buffer instead
+    for (u32 i = 0; i < computeCommandBuffers.size(); ++i) {
+        VkCommandBufferBeginInfo computeBeginInfo = {};
+        computeBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        
+        if (vkBeginCommandBuffer(computeCommandBuffers[i], &computeBeginInfo) != VK_SUCCESS) {
+            return 1;
+        }
+        if (gpuCulling && !occlusionCulling) {
+            gpuCuller.recordCull(computeCommandBuffers[i], i);
+        }
+        if (particleCount > 0) {
+            particleSystem.recordSimulate(computeCommandBuffers[i], i);
+        }
+        if (vkEndCommandBuffer(computeCommandBuffers[i]) != VK_SUCCESS) {
+            return 1;
+        }
+    }
+    
+    if (benchmarkVertexFormats) {
+        // identity transforms so the grid's z is window depth
+        UniformBuffer identityUniform = {};
+        mat4x4_identity(identityUniform.model);
+        mat4x4_identity(identityUniform.view);
+        mat4x4_identity(identityUniform.proj);
+        memcpy(uniformMapped[0], &identityUniform, sizeof(UniformBuffer));
+        
+        OffscreenTarget target;
+        if (!target.create(device, physicalDevice, swapchain.calculatedFormat, swapchain.depthFormat, swapchain.currentExtent)) {
+            return 1;
+        }
+        
+        VkDescriptorSet benchmarkSets[2] = { descriptorSets[0], textureTable.set };
+        benchmarkVertexCompression(device, physicalDevice, caps, graphicsQueue, graphicsFamilyIndex, target, pipelineLayout, formatPipelines, benchmarkFormats, benchmarkSets, bindless ? 2 : 1, instanceBuffer);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (benchmarkGraph) {
+        benchmarkRenderGraph(device, physicalDevice, caps, graphicsQueue, graphicsFamilyIndex, swapchain.calculatedFormat, swapchain.depthFormat, swapchain.currentExtent);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (benchmarkUploadPaths) {
+        benchmarkUploads(device, physicalDevice, caps, graphicsQueue, graphicsFamilyIndex);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (benchmarkParticleSystem) {
+        OffscreenTarget target;
+        if (!target.create(device, physicalDevice, swapchain.calculatedFormat, swapchain.depthFormat, swapchain.currentExtent)) {
+            return 1;
+        }
         
-        VkWriteDescriptorSet sets[2] = {};
-        sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        sets[0].dstSet = descriptorSets[i];
-        sets[0].dstBinding = 0;
-        sets[0].dstArrayElement = 0;
-        sets[0].descriptorCount = 1;
-        sets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        sets[0].pBufferInfo = &bufferInfo;
+        benchmarkParticles(device, physicalDevice, caps, graphicsQueue, graphicsFamilyIndex, computeQueue, computeFamilyIndex, target);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (benchmarkSprites) {
+        OffscreenTarget target;
+        if (!target.create(device, physicalDevice, swapchain.calculatedFormat, swapchain.depthFormat, swapchain.currentExtent)) {
+            return 1;
+        }
         
-        VkDescriptorImageInfo imageInfo = {};
-        imageInfo.imageView = imageView;
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.sampler = imageSampler;
+        benchmarkSpriteBatch(device, physicalDevice, caps, graphicsQueue, graphicsFamilyIndex, target);
+        vkDeviceWaitIdle(device);
+        return 0;
+    }
+    
+    if (benchmarkOverdraw) {
+        // identity transforms so layer depth maps straight to window depth
+        UniformBuffer identityUniform = {};
+        mat4x4_identity(identityUniform.model);
+        mat4x4_identity(identityUniform.view);
+        mat4x4_identity(identityUniform.proj);
+        memcpy(uniformMapped[0], &identityUniform, sizeof(UniformBuffer));
         
-        sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        sets[1].dstSet = descriptorSets[i];
-        sets[1].dstBinding = 1;
-        sets[1].dstArrayElement = 0;
-        sets[1].descriptorCount = 1;
-        sets[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        sets[1].pImageInfo = &imageInfo;
+        OffscreenTarget target;
+        if (!target.create(device, physicalDevice, swapchain.calculatedFormat, swapchain.depthFormat, swapchain.currentExtent)) {
+            return 1;
+        }
         
-        vkUpdateDescriptorSets(device, 2, sets, 0, nullptr);
+        VkDescriptorSet benchmarkSets[2] = { descriptorSets[0], textureTable.set };
+        benchmarkDepthPrepass(device, physicalDevice, caps, graphicsQueue, graphicsFamilyIndex, target, pipelineLayout, pipeline, depthPrepassPipeline, depthEqualPipeline, benchmarkSets, bindless ? 2 : 1, instanceBuffer, vertexFormat, 32);
+        vkDeviceWaitIdle(device);
+        return 0;
     }
     
     UniformBuffer uniform = {};
@@ -1463,9 +4338,84 @@ int main(int argc, char** argv) {
     camera.fov = 75.0f;
     camera.near = 0.01f;
     camera.far = 1000.0f;
+    
+    std::vector<DrawItem> opaqueDraws;
+    if (sceneLods.count > 0) {
+        opaqueDraws.push_back({ sceneLods.indexCount[0], sceneLods.firstIndex[0], sceneMesh.vertexOffset, { 0.0f, 0.0f, 0.5f }, &sceneLods });
+    } else {
+        opaqueDraws.push_back({ sceneMesh.indexCount, sceneMesh.firstIndex, sceneMesh.vertexOffset, { 0.0f, 0.0f, 0.0f } });
+    }
+    
+    // triangles each static command buffer submits, the GPU culled draws are not known on the CPU and not counted
+    std::vector<u64> recordedTriangles;
+    u64 submittedTriangles = 0;
+    u32 statsFrames = 0;
+    auto statsStart = std::chrono::steady_clock::now();
+    
+    // the uniform is only copied into a frame slot's buffer when it differs from what that slot last received
+    UniformBuffer lastUniform = {};
+    u64 uniformVersion = 1;
+    std::vector<u64> uploadedUniformVersions(globals.FRAMES_IN_FLIGHT, 0);
+
+    const f32 particleEmitter[3] = { 0.0f, 0.0f, 0.5f };
+    auto lastFrameTime = std::chrono::steady_clock::now();
+    
+    FramePacer pacer;
+    pacer.targetFrameSeconds = targetFps > 0.0 ? 1.0 / targetFps : 0.0;
+    LatencyTracker latency;
+    latency.init(device, caps);
+    if (latencyStats) {
+        const char* presentModeNames[] = { "immediate", "mailbox", "fifo", "fifo-relaxed" };
+        std::cout << swapchain.swapchainImages.size() << " swapchain images, " << presentModeNames[swapchain.calculatedPresentMode] << ", "
+                  << globals.FRAMES_IN_FLIGHT << " frames in flight";
+        if (targetFps > 0.0) {
+            std::cout << ", paced to " << targetFps << " fps";
+        }
+        std::cout << "\n";
+    }
 
+	// with --on-demand the loop sleeps in glfwWaitEvents until something happens, unless the last frame changed
+	// something or the scene animates by itself. Only events that change what is on screen draw a frame: the window
+	// being exposed or resized sets redraw through the callbacks, a mouse move over it goes straight back to sleep.
+	const bool animating = particleCount > 0 || rerecordCommands;
+	bool redraw = true;
+	glfwSetWindowUserPointer(window, &redraw);
+	glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) {
+		*static_cast<bool*>(glfwGetWindowUserPointer(w)) = true;
+	});
+	glfwSetFramebufferSizeCallback(window, [](GLFWwindow* w, int, int) {
+		*static_cast<bool*>(glfwGetWindowUserPointer(w)) = true;
+	});
+	bool startupReported = !startupReport;
+	startupTasks.cleanup();
+	report.step("remaining setup");
+	PROFILE_ZONE_END(startup);
+	
 	usize currentFrameInFlight = 0;
 	while (!glfwWindowShouldClose(window)) {
+		if (renderOnDemand && !animating && !redraw) {
+			PROFILE_ZONE("idle");
+			glfwWaitEvents();
+			if (!redraw) {
+				continue;
+			}
+		}
+		redraw = false;
+		PROFILE_ZONE("frame");
+		
+		// input is sampled as late as possible: once this slot is free and the pacer has slept off any spare time
+		PROFILE_ZONE_BEGIN(slotWait, "frame slot wait");
+		if (!graphicsTimeline.wait(frameTimelineValues[currentFrameInFlight])) {
+			return 1;
+		}
+		pacer.poll(graphicsTimeline);
+		PROFILE_ZONE_END(slotWait);
+		PROFILE_ZONE_BEGIN(pacing, "pacing");
+		pacer.waitForFrame();
+		PROFILE_ZONE_END(pacing);
+		latency.pollDisplay(swapchain.swapchain);
+		latency.beginFrame();
+		PROFILE_ZONE_BEGIN(input, "input and update");
 		glfwPollEvents();
         mat4x4_identity(uniform.model);
         mat4x4_identity(uniform.view);
@@ -1474,26 +4424,61 @@ int main(int argc, char** argv) {
         mat4x4_rotate_Z(uniform.view, uniform.view, camera.rot[2]);
         mat4x4_translate_in_place(uniform.view, camera.pos[0], camera.pos[1], camera.pos[2]);
         mat4x4_identity(uniform.proj);
+        bool uniformChanged = memcmp(&uniform, &lastUniform, sizeof(UniformBuffer)) != 0;
+        mat4x4 modelView;
+        mat4x4_mul(modelView, uniform.view, uniform.model);
+        if (uniformChanged) {
+            lastUniform = uniform;
+            ++uniformVersion;
+            redraw = true;
+            
+            if (sortFrontToBack(opaqueDraws, modelView)) {
+                staticCommands.invalidate();
+            }
+        }
+        // the projected size of a mesh follows the swapchain height as well, so a resize re-selects too
+        if (uniformChanged || lodSwapchainGeneration != swapchain.generation) {
+            lodSwapchainGeneration = swapchain.generation;
+            
+            // the eye in model space is where the inverse model-view takes the origin
+            mat4x4 viewModel;
+            mat4x4_invert(viewModel, modelView);
+            f32 eye[3] = { viewModel[3][0], viewModel[3][1], viewModel[3][2] };
+            f32 projectionScale = lodProjectionScale(camera.fov * 3.14159265f / 180.0f, static_cast<f32>(swapchain.currentExtent.height));
+            if (selectDrawLods(opaqueDraws, eye, projectionScale, lodThresholdPixels)) {
+                staticCommands.invalidate();
+            }
+        }
+
+		PROFILE_ZONE_END(input);
 
 		int width, height;
 		glfwGetFramebufferSize(window, &width, &height);
+		// minimized, nothing to draw until the window comes back, the timeout covers platforms that restore silently
 		if (width == 0 || height == 0) {
+			glfwWaitEventsTimeout(0.25);
+			redraw = true;
 			continue;
 		}
 
-		vkWaitForFences(device, 1, &inFlightFences[currentFrameInFlight], VK_TRUE, std::numeric_limits<u64>::max());
+		if (!graphicsTimeline.wait(frameTimelineValues[currentFrameInFlight])) {
+			return 1;
+		}
+		geometry.beginFrame(static_cast<u32>(currentFrameInFlight));
 
 		u32 swapchainImageIndex = 0;
+		PROFILE_ZONE_BEGIN(acquire, "acquire");
 		result = vkAcquireNextImageKHR(device, swapchain.swapchain, std::numeric_limits<u64>::max(), imageAvailableSemaphores[currentFrameInFlight], VK_NULL_HANDLE, &swapchainImageIndex);
+		PROFILE_ZONE_END(acquire);
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            latency.dropPending();
+            redraw = true;
             u32 r = swapchain.recreate();
             if (r == 0) {
 				return 1;
             } else if (r == 2) {
-                vkResetFences(device, 1, &inFlightFences[currentFrameInFlight]);
                 continue;
             }
-        	vkResetFences(device, 1, &inFlightFences[currentFrameInFlight]);
             
             viewport.y = swapchain.currentExtent.height;
             viewport.width = swapchain.currentExtent.width;
@@ -1503,61 +4488,242 @@ int main(int argc, char** argv) {
         } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
             return 1;
         }
-        
-        vkResetFences(device, 1, &inFlightFences[currentFrameInFlight]);
-		vkResetCommandBuffer(graphicsCommandBuffers[currentFrameInFlight], 0);
-
-		VkCommandBufferBeginInfo commandBufferBeginInfo = {};
-		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		
-		if (vkBeginCommandBuffer(graphicsCommandBuffers[currentFrameInFlight], &commandBufferBeginInfo) != VK_SUCCESS) {
-			return 1;
+		if (recordedSwapchainGeneration != swapchain.generation) {
+			if (!staticCommands.resize(globals.FRAMES_IN_FLIGHT, static_cast<u32>(swapchain.swapchainImages.size()))) {
+				return 1;
+			}
+			recordedTriangles.assign(globals.FRAMES_IN_FLIGHT * swapchain.swapchainImages.size(), 0);
+			recordedSwapchainGeneration = swapchain.generation;
+			
+			// the pyramid follows the depth buffer, nothing is in flight right after a recreate
+			if (occlusionCulling) {
+				if (!hiZPyramid.resize(swapchain.depthImage, swapchain.depthImageView, swapchain.depthFormat, swapchain.currentExtent)) {
+					return 1;
+				}
+				gpuCuller.setPyramid(hiZPyramid.view, hiZPyramid.sampler, hiZPyramid.levelCount, swapchain.currentExtent, viewport);
+				if (!buildCullGraphs()) {
+					return 1;
+				}
+			}
 		}
-
-		VkClearValue clearColor = { { { 0.2f, 0.4f, 0.1f, 1.0f } } };
 		
-		VkRenderPassBeginInfo renderPassBeginInfo = {};
-		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassBeginInfo.renderPass = renderPass;
-		renderPassBeginInfo.framebuffer = swapchain.swapchainFramebuffers[swapchainImageIndex];
-		renderPassBeginInfo.renderArea.offset = { 0, 0 };
-		renderPassBeginInfo.renderArea.extent = swapchain.currentExtent;
-		renderPassBeginInfo.clearValueCount = 1;
-		renderPassBeginInfo.pClearValues = &clearColor;
-        
-        memcpy(uniformMapped[currentFrameInFlight], &uniform, sizeof(UniformBuffer));
-
-		vkCmdBeginRenderPass(graphicsCommandBuffers[currentFrameInFlight], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdSetViewport(graphicsCommandBuffers[currentFrameInFlight], 0, 1, &viewport);
-        vkCmdSetScissor(graphicsCommandBuffers[currentFrameInFlight], 0, 1, &scissor);
-		vkCmdBindPipeline(graphicsCommandBuffers[currentFrameInFlight], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-        
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(graphicsCommandBuffers[currentFrameInFlight], 0, 1, &meshBuffer, &offset);
-        vkCmdBindIndexBuffer(graphicsCommandBuffers[currentFrameInFlight], meshBuffer, sizeof(vertices), VK_INDEX_TYPE_UINT32);
-        vkCmdBindDescriptorSets(graphicsCommandBuffers[currentFrameInFlight], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrameInFlight], 0, nullptr);
-        vkCmdDrawIndexed(graphicsCommandBuffers[currentFrameInFlight], sizeof(indices) / sizeof(indices[0]), 1, 0, 0, 0);
+		if (rerecordCommands) {
+			staticCommands.invalidate();
+		}
 		
-		vkCmdEndRenderPass(graphicsCommandBuffers[currentFrameInFlight]);
-		if (vkEndCommandBuffer(graphicsCommandBuffers[currentFrameInFlight]) != VK_SUCCESS) {
-			return 1;
+		if (uploadedUniformVersions[currentFrameInFlight] != uniformVersion) {
+			memcpy(uniformMapped[currentFrameInFlight], &uniform, sizeof(UniformBuffer));
+			if (gpuCulling) {
+				mat4x4 viewProj;
+				mat4x4_mul(viewProj, uniform.proj, uniform.view);
+				mat4x4_mul(viewProj, viewProj, uniform.model);
+				gpuCuller.setFrustum(static_cast<u32>(currentFrameInFlight), viewProj);
+			}
+			uploadedUniformVersions[currentFrameInFlight] = uniformVersion;
+		}
+		latency.mark(LatencyTracker::MARKER_UNIFORM);
+		
+		// the step length changes every frame, so the particle uniform is always rewritten
+		auto frameTime = std::chrono::steady_clock::now();
+		f32 dt = std::min(std::chrono::duration<f32>(frameTime - lastFrameTime).count(), 0.1f);
+		lastFrameTime = frameTime;
+		if (particleCount > 0) {
+			mat4x4 viewProj;
+			mat4x4_mul(viewProj, uniform.proj, uniform.view);
+			mat4x4_mul(viewProj, viewProj, uniform.model);
+			particleSystem.update(static_cast<u32>(currentFrameInFlight), dt, viewProj, uniform.view, particleEmitter);
+		}
+		
+		VkCommandBuffer commandBuffer = staticCommands.get(static_cast<u32>(currentFrameInFlight), swapchainImageIndex);
+		if (staticCommands.isStale(static_cast<u32>(currentFrameInFlight), swapchainImageIndex)) {
+			PROFILE_ZONE("record");
+			vkResetCommandBuffer(commandBuffer, 0);
+
+			VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+			commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			
+			if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) {
+				return 1;
+			}
+
+			VkClearValue clearValues[2] = {};
+			clearValues[0].color = { { 0.2f, 0.4f, 0.1f, 1.0f } };
+			clearValues[1].depthStencil = { 1.0f, 0 };
+			
+			if (occlusionCulling) {
+				earlyCullGraphs[currentFrameInFlight].execute(commandBuffer);
+			}
+			
+			VkRenderPassBeginInfo renderPassBeginInfo = {};
+			renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassBeginInfo.renderPass = occlusionCulling ? earlyRenderPass : renderPass;
+			renderPassBeginInfo.framebuffer = swapchain.swapchainFramebuffers[swapchainImageIndex];
+			renderPassBeginInfo.renderArea.offset = { 0, 0 };
+			renderPassBeginInfo.renderArea.extent = swapchain.currentExtent;
+			renderPassBeginInfo.clearValueCount = 2;
+			renderPassBeginInfo.pClearValues = clearValues;
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+			
+			VkDeviceSize offset = 0;
+			// culled objects are all the quad and opaque draws all the scene mesh, so each batch needs one index type and decode
+			auto bindMesh = [&](MeshRange const& mesh) {
+				geometry.bind(commandBuffer, mesh.indexType);
+				vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexDecode), &mesh.decode);
+			};
+			bindMesh(gpuCulling ? quad : sceneMesh);
+			if (bindless) {
+				vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &offset);
+			}
+			
+			VkDescriptorSet boundSets[2] = { descriptorSets[currentFrameInFlight], textureTable.set };
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, bindless ? 2 : 1, boundSets, 0, nullptr);
+			
+			// every pipeline shares pipelineLayout, so the sets stay bound across pipeline switches
+			if (gpuCulling) {
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, culledPipeline);
+				vkCmdBindVertexBuffers(commandBuffer, 1, 1, &gpuCuller.objectBuffer, &offset);
+				gpuCuller.recordDraw(commandBuffer, static_cast<u32>(currentFrameInFlight), GpuCuller::EARLY);
+				
+				bindMesh(sceneMesh);
+				if (bindless) {
+					vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &offset);
+				}
+			} else if (depthPrepass) {
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depthPrepassPipeline);
+				for (DrawItem const& draw : opaqueDraws) {
+					vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, draw.vertexOffset, 0);
+				}
+			}
+			
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depthPrepass ? depthEqualPipeline : pipeline);
+			u64 triangles = 0;
+			for (DrawItem const& draw : opaqueDraws) {
+				vkCmdDrawIndexed(commandBuffer, draw.indexCount, 1, draw.firstIndex, draw.vertexOffset, 0);
+				triangles += draw.indexCount / 3;
+			}
+			recordedTriangles[currentFrameInFlight * swapchain.swapchainImages.size() + swapchainImageIndex] = depthPrepass && !gpuCulling ? triangles * 2 : triangles;
+			
+			// particles go over everything else, in the late pass when there is one
+			if (particleCount > 0 && !occlusionCulling) {
+				particleSystem.recordDraw(commandBuffer, static_cast<u32>(currentFrameInFlight));
+			}
+			vkCmdEndRenderPass(commandBuffer);
+			
+			// second phase: Hi-Z from what was just drawn, then whatever it reveals on top of the same attachments
+			if (occlusionCulling) {
+				lateCullGraphs[currentFrameInFlight].execute(commandBuffer);
+				
+				renderPassBeginInfo.renderPass = lateRenderPass;
+				vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, culledPipeline);
+				bindMesh(quad);
+				vkCmdBindVertexBuffers(commandBuffer, 1, 1, &gpuCuller.objectBuffer, &offset);
+				gpuCuller.recordDraw(commandBuffer, static_cast<u32>(currentFrameInFlight), GpuCuller::LATE);
+				if (particleCount > 0) {
+					particleSystem.recordDraw(commandBuffer, static_cast<u32>(currentFrameInFlight));
+				}
+				vkCmdEndRenderPass(commandBuffer);
+			}
+			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+				return 1;
+			}
+			
+			staticCommands.markRecorded(static_cast<u32>(currentFrameInFlight), swapchainImageIndex);
 		}
 
-		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		PROFILE_ZONE_BEGIN(submit, "submit");
+		QueueTimeline::Wait imageAvailable = { imageAvailableSemaphores[currentFrameInFlight], 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		QueueTimeline::Wait computeFinished = {};
+		
+		if (!computeCommandBuffers.empty()) {
+			VkSemaphore computeSignal = computeTimeline.timeline ? VK_NULL_HANDLE : computeFinishedSemaphores[currentFrameInFlight];
+			u64 computeValue = computeTimeline.submit(1, &computeCommandBuffers[currentFrameInFlight], {}, computeSignal);
+			if (computeValue == 0) {
+				return 1;
+			}
+			
+			const VkPipelineStageFlags drawStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+			computeFinished = computeTimeline.timeline ? computeTimeline.waitFor(computeValue, drawStages) : QueueTimeline::Wait{ computeSignal, 0, drawStages };
+		}
 
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &imageAvailableSemaphores[currentFrameInFlight];
-		submitInfo.pWaitDstStageMask = &waitStage;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &graphicsCommandBuffers[currentFrameInFlight];
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = &renderFinishedSemaphores[currentFrameInFlight];
+		// copies for meshes added this frame go first in the same submit, their barrier covers the draws after them
+		VkCommandBuffer submitCommandBuffers[2] = { VK_NULL_HANDLE, commandBuffer };
+		u32 firstSubmitCommandBuffer = 1;
+		if (geometry.hasPendingUploads()) {
+			VkCommandBuffer uploadCommandBuffer = geometryUploadCommandBuffers[currentFrameInFlight];
+			vkResetCommandBuffer(uploadCommandBuffer, 0);
+			
+			VkCommandBufferBeginInfo uploadBeginInfo = {};
+			uploadBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			uploadBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			if (vkBeginCommandBuffer(uploadCommandBuffer, &uploadBeginInfo) != VK_SUCCESS) {
+				return 1;
+			}
+			geometry.recordUploads(uploadCommandBuffer);
+			if (vkEndCommandBuffer(uploadCommandBuffer) != VK_SUCCESS) {
+				return 1;
+			}
+			
+			submitCommandBuffers[0] = uploadCommandBuffer;
+			firstSubmitCommandBuffer = 0;
+		}
 
-		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrameInFlight]) != VK_SUCCESS) {
+		u32 submitCount = 2 - firstSubmitCommandBuffer;
+		VkCommandBuffer const* submitted = submitCommandBuffers + firstSubmitCommandBuffer;
+		VkSemaphore renderFinished = renderFinishedSemaphores[currentFrameInFlight];
+		u64 frameValue = computeFinished.semaphore != VK_NULL_HANDLE
+			? graphicsTimeline.submit(submitCount, submitted, { imageAvailable, computeFinished }, renderFinished)
+			: graphicsTimeline.submit(submitCount, submitted, { imageAvailable }, renderFinished);
+		if (frameValue == 0) {
 			return 1;
 		}
+		frameTimelineValues[currentFrameInFlight] = frameValue;
+		pacer.frameSubmitted(frameValue);
+		latency.mark(LatencyTracker::MARKER_SUBMIT);
+		PROFILE_ZONE_END(submit);
+
+		if (triangleStats || latencyStats || hostStats || memoryStats) {
+			submittedTriangles += recordedTriangles[currentFrameInFlight * swapchain.swapchainImages.size() + swapchainImageIndex];
+			++statsFrames;
+			
+			f64 elapsed = std::chrono::duration<f64>(std::chrono::steady_clock::now() - statsStart).count();
+			if (elapsed >= 1.0) {
+				if (triangleStats) {
+					std::cout << submittedTriangles / statsFrames << " triangles/frame over " << statsFrames << " frames\n";
+				}
+				if (latencyStats) {
+					FramePacer::Stats pacing = pacer.takeStats();
+					std::cout << statsFrames / elapsed << " fps, input to submit " << pacing.inputToSubmitMs / std::max(pacing.frames, 1u)
+					          << " ms, input to GPU done " << pacing.inputToGpuMs / std::max(pacing.gpuFrames, 1u)
+					          << " ms, paced " << pacing.sleepMs / std::max(pacing.frames, 1u) << " ms/frame\n";
+					
+					// from the input poll, average (max)
+					LatencyTracker::Summary markers = latency.summarize();
+					const char* markerNames[LatencyTracker::MARKER_COUNT] = { "poll", "uniform", "submit", "present", "display" };
+					std::cout << "    latency from poll:";
+					for (u32 m = LatencyTracker::MARKER_UNIFORM; m < LatencyTracker::MARKER_COUNT; ++m) {
+						if (markers.frames[m] > 0) {
+							std::cout << " " << markerNames[m] << " " << markers.averageMs[m] << " (" << markers.maxMs[m] << ") ms";
+						}
+					}
+					std::cout << (latency.waitForPresent != nullptr ? "\n" : ", no present wait for display times\n");
+				}
+				if (hostStats) {
+					HostAllocator::instance().printChurn(elapsed);
+				}
+				if (memoryStats) {
+					MemoryBudget::instance().update();
+					MemoryBudget::instance().print();
+				}
+				submittedTriangles = 0;
+				statsFrames = 0;
+				statsStart = std::chrono::steady_clock::now();
+			}
+		}
 
 		VkPresentInfoKHR presentInfo = {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1567,8 +4733,29 @@ int main(int argc, char** argv) {
 		presentInfo.pSwapchains = &swapchain.swapchain;
 		presentInfo.pImageIndices = &swapchainImageIndex;
 		
+		u64 presentId = latency.presentId();
+		VkPresentIdKHR presentIdInfo = {};
+		presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+		presentIdInfo.swapchainCount = 1;
+		presentIdInfo.pPresentIds = &presentId;
+		if (presentId != 0) {
+			presentInfo.pNext = &presentIdInfo;
+		}
+		
+		PROFILE_ZONE_BEGIN(present, "present");
         result = vkQueuePresentKHR(presentQueue, &presentInfo);
+		PROFILE_ZONE_END(present);
+        if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+            latency.mark(LatencyTracker::MARKER_PRESENT);
+            if (!startupReported) {
+                report.step("first frame");
+                report.print(startupTasks);
+                startupReported = true;
+            }
+        }
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            latency.dropPending();
+            redraw = true;
             u32 r = swapchain.recreate();
             if (r == 0) {
                 return 1;
@@ -1586,6 +4773,9 @@ int main(int argc, char** argv) {
         }
 		currentFrameInFlight = (currentFrameInFlight + 1) % globals.FRAMES_IN_FLIGHT;
 	}
+	// redraw goes out of scope before the window is destroyed
+	glfwSetWindowRefreshCallback(window, nullptr);
+	glfwSetFramebufferSizeCallback(window, nullptr);
 
 	vkDeviceWaitIdle(device);
 	return 0;
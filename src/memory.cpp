@@ -0,0 +1,99 @@
+#include <memory.hpp>
+#include <hostalloc.hpp>
+
+#include <bitset>
+#include <iostream>
+
+u32 findMemoryType(u32 typeBits, VkMemoryPropertyFlags flags, VkPhysicalDeviceMemoryProperties const& props, VkDeviceSize size) {
+    MemoryBudget const& budget = MemoryBudget::instance();
+    u32 best = MEMORY_TYPE_NONE;
+    bool bestFits = false;
+    usize bestExtra = 0;
+    for (u32 i = 0; i < props.memoryTypeCount; ++i) {
+        if (!(typeBits & (1u << i)) || (props.memoryTypes[i].propertyFlags & flags) != flags) {
+            continue;
+        }
+
+        bool fits = budget.fits(props.memoryTypes[i].heapIndex, size);
+        usize extra = std::bitset<32>(props.memoryTypes[i].propertyFlags & ~flags).count();
+        if (best == MEMORY_TYPE_NONE || (fits && !bestFits) || (fits == bestFits && extra < bestExtra)) {
+            best = i;
+            bestFits = fits;
+            bestExtra = extra;
+        }
+    }
+    
+    return best;
+}
+
+bool hasDirectWriteMemory(VkPhysicalDeviceMemoryProperties const& props, u32 typeBits, VkDeviceSize size) {
+    u32 type = findMemoryType(typeBits, DIRECT_WRITE_MEMORY, props, size);
+    return type != MEMORY_TYPE_NONE && MemoryBudget::instance().fits(props.memoryTypes[type].heapIndex, size);
+}
+
+VkMemoryPropertyFlags hostWriteMemory(VkPhysicalDeviceMemoryProperties const& props, u32 typeBits, VkDeviceSize size, bool allowDirectWrite) {
+    if (allowDirectWrite && hasDirectWriteMemory(props, typeBits, size)) {
+        return DIRECT_WRITE_MEMORY;
+    }
+    return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+bool allocateMemory(VkDevice device, VkPhysicalDeviceMemoryProperties const& memoryProperties, VkMemoryRequirements const& requirements, VkMemoryPropertyFlags flags, MemoryBudget::Category category, VkDeviceMemory* memory) {
+    *memory = VK_NULL_HANDLE;
+    u32 type = findMemoryType(requirements.memoryTypeBits, flags, memoryProperties, requirements.size);
+    if (type == MEMORY_TYPE_NONE) {
+        std::cout << "No memory type for " << MemoryBudget::categoryName(category) << " has the property flags 0x" << std::hex << flags << std::dec << "\n";
+        return false;
+    }
+
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = type;
+
+    VkResult result = vkAllocateMemory(device, &allocateInfo, hostAllocator(VK_OBJECT_TYPE_DEVICE_MEMORY), memory);
+    if (result != VK_SUCCESS) {
+        *memory = VK_NULL_HANDLE;
+        MemoryBudget::instance().failed(type, requirements.size, category, result);
+        return false;
+    }
+
+    MemoryBudget::instance().record(*memory, type, requirements.size, category);
+    return true;
+}
+
+void freeMemory(VkDevice device, VkDeviceMemory memory) {
+    if (memory == VK_NULL_HANDLE) {
+        return;
+    }
+
+    MemoryBudget::instance().forget(memory);
+    vkFreeMemory(device, memory, hostAllocator(VK_OBJECT_TYPE_DEVICE_MEMORY));
+}
+
+bool createBuffer(VkDevice device, VkPhysicalDeviceMemoryProperties const& memoryProperties, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags, MemoryBudget::Category category, std::vector<u32> const& queueFamilies, VkBuffer* buffer, VkDeviceMemory* memory) {
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    if (queueFamilies.size() > 1) {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<u32>(queueFamilies.size());
+        bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+    } else {
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+
+    if (vkCreateBuffer(device, &bufferInfo, hostAllocator(VK_OBJECT_TYPE_BUFFER), buffer) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, *buffer, &memoryRequirements);
+
+    if (!allocateMemory(device, memoryProperties, memoryRequirements, memoryFlags, category, memory)) {
+        return false;
+    }
+
+    return vkBindBufferMemory(device, *buffer, *memory, 0) == VK_SUCCESS;
+}
@@ -0,0 +1,961 @@
+#include <mesh.hpp>
+#include <geometry.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// OBJ indices are 1-based, negative ones count back from the last element read so far
+static bool resolveObjIndex(long index, usize count, u32* out) {
+    long resolved = index > 0 ? index - 1 : static_cast<long>(count) + index;
+    if (index == 0 || resolved < 0 || static_cast<usize>(resolved) >= count) {
+        return false;
+    }
+    *out = static_cast<u32>(resolved);
+    return true;
+}
+
+bool loadObj(const char* path, MeshData* mesh) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    usize size = file.tellg();
+    std::vector<char> text(size + 1);
+    file.seekg(0);
+    file.read(text.data(), size);
+    file.close();
+    text[size] = '\0';
+
+    std::vector<f32> positions;
+    std::vector<f32> colors;
+    std::vector<f32> uvs;
+    std::vector<f32> normals;
+
+    mesh->vertices.clear();
+    mesh->normals.clear();
+    mesh->indices.clear();
+
+    bool anyNormals = false;
+    std::vector<u32> polygon;
+    char* line = text.data();
+    while (*line != '\0') {
+        char* end = line;
+        while (*end != '\0' && *end != '\n') {
+            ++end;
+        }
+        char* next = *end == '\0' ? end : end + 1;
+        *end = '\0';
+
+        char* cursor = line;
+        while (*cursor == ' ' || *cursor == '\t') {
+            ++cursor;
+        }
+
+        if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            f32 values[6];
+            u32 count = 0;
+            cursor += 1;
+            while (count < 6) {
+                char* parsed;
+                f32 value = std::strtof(cursor, &parsed);
+                if (parsed == cursor) {
+                    break;
+                }
+                values[count++] = value;
+                cursor = parsed;
+            }
+            if (count < 3) {
+                return false;
+            }
+            positions.insert(positions.end(), values, values + 3);
+            if (count == 6) {
+                colors.insert(colors.end(), values + 3, values + 6);
+            } else {
+                colors.insert(colors.end(), { 1.0f, 1.0f, 1.0f });
+            }
+        } else if (cursor[0] == 'v' && cursor[1] == 't') {
+            char* parsed;
+            f32 u = std::strtof(cursor + 2, &parsed);
+            f32 v = std::strtof(parsed, &parsed);
+            // OBJ puts v = 0 at the bottom of the image, Vulkan samples row 0 first
+            uvs.push_back(u);
+            uvs.push_back(1.0f - v);
+        } else if (cursor[0] == 'v' && cursor[1] == 'n') {
+            char* parsed = cursor + 2;
+            for (u32 i = 0; i < 3; ++i) {
+                normals.push_back(std::strtof(parsed, &parsed));
+            }
+        } else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            polygon.clear();
+            cursor += 1;
+            while (true) {
+                while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') {
+                    ++cursor;
+                }
+                if (*cursor == '\0') {
+                    break;
+                }
+
+                long references[3] = { 0, 0, 0 };
+                for (u32 i = 0; i < 3; ++i) {
+                    if (i > 0) {
+                        if (*cursor != '/') {
+                            break;
+                        }
+                        ++cursor;
+                    }
+                    char* parsed;
+                    references[i] = std::strtol(cursor, &parsed, 10);
+                    cursor = parsed;
+                }
+
+                u32 position;
+                if (!resolveObjIndex(references[0], positions.size() / 3, &position)) {
+                    return false;
+                }
+
+                Vertex vertex = {};
+                vertex.x = positions[position * 3 + 0];
+                vertex.y = positions[position * 3 + 1];
+                vertex.z = positions[position * 3 + 2];
+                vertex.r = colors[position * 3 + 0];
+                vertex.g = colors[position * 3 + 1];
+                vertex.b = colors[position * 3 + 2];
+
+                u32 uv;
+                if (references[1] != 0 && resolveObjIndex(references[1], uvs.size() / 2, &uv)) {
+                    vertex.u = uvs[uv * 2 + 0];
+                    vertex.v = uvs[uv * 2 + 1];
+                }
+
+                f32 normal[3] = { 0.0f, 0.0f, 0.0f };
+                u32 n;
+                if (references[2] != 0 && resolveObjIndex(references[2], normals.size() / 3, &n)) {
+                    normal[0] = normals[n * 3 + 0];
+                    normal[1] = normals[n * 3 + 1];
+                    normal[2] = normals[n * 3 + 2];
+                    anyNormals = true;
+                }
+
+                polygon.push_back(static_cast<u32>(mesh->vertices.size()));
+                mesh->vertices.push_back(vertex);
+                mesh->normals.insert(mesh->normals.end(), normal, normal + 3);
+
+                // skip whatever is left of a malformed corner
+                while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') {
+                    ++cursor;
+                }
+            }
+
+            for (usize i = 2; i < polygon.size(); ++i) {
+                mesh->indices.push_back(polygon[0]);
+                mesh->indices.push_back(polygon[i - 1]);
+                mesh->indices.push_back(polygon[i]);
+            }
+        }
+
+        line = next;
+    }
+
+    if (!anyNormals) {
+        mesh->normals.clear();
+    }
+
+    return !mesh->indices.empty();
+}
+
+// Merges vertices whose attributes are bitwise identical through an open addressing table over vertex ids.
+static void deduplicateVertices(MeshData& mesh) {
+    const usize count = mesh.vertices.size();
+    const bool withNormals = !mesh.normals.empty();
+
+    auto hash = [&](u32 v) -> u64 {
+        u64 h = 14695981039346656037ull;
+        auto mix = [&](void const* data, usize size) {
+            u8 const* bytes = static_cast<u8 const*>(data);
+            for (usize i = 0; i < size; ++i) {
+                h = (h ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+        mix(&mesh.vertices[v], sizeof(Vertex));
+        if (withNormals) {
+            mix(&mesh.normals[v * 3], sizeof(f32) * 3);
+        }
+        return h;
+    };
+    auto equal = [&](u32 a, u32 b) -> bool {
+        return memcmp(&mesh.vertices[a], &mesh.vertices[b], sizeof(Vertex)) == 0
+            && (!withNormals || memcmp(&mesh.normals[a * 3], &mesh.normals[b * 3], sizeof(f32) * 3) == 0);
+    };
+
+    usize tableSize = 1;
+    while (tableSize < count * 2) {
+        tableSize <<= 1;
+    }
+    const u32 EMPTY = ~0u;
+    std::vector<u32> table(tableSize, EMPTY);
+
+    std::vector<u32> remap(count);
+    u32 unique = 0;
+    for (u32 v = 0; v < count; ++v) {
+        usize slot = hash(v) & (tableSize - 1);
+        while (table[slot] != EMPTY && !equal(table[slot], v)) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] == EMPTY) {
+            // compacts in place, the unique vertex can only move towards the front
+            mesh.vertices[unique] = mesh.vertices[v];
+            if (withNormals) {
+                memmove(&mesh.normals[unique * 3], &mesh.normals[v * 3], sizeof(f32) * 3);
+            }
+            table[slot] = unique;
+            remap[v] = unique++;
+        } else {
+            remap[v] = table[slot];
+        }
+    }
+
+    mesh.vertices.resize(unique);
+    if (withNormals) {
+        mesh.normals.resize(static_cast<usize>(unique) * 3);
+    }
+    for (u32& index : mesh.indices) {
+        index = remap[index];
+    }
+}
+
+// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation". Greedily emits the triangle whose vertices score highest:
+// recently used vertices score high, as do vertices with few triangles left so they are finished and leave the
+// cache. Returns where the order had to jump, a new cluster starts there.
+static std::vector<u32> optimizeVertexCache(std::vector<u32>& indices, u32 vertexCount, u32 cacheSize) {
+    const u32 triangleCount = static_cast<u32>(indices.size() / 3);
+    const u32 NONE = ~0u;
+
+    // triangles around each vertex, the live ones are kept at the front of each vertex's range
+    std::vector<u32> adjacencyOffsets(vertexCount + 1, 0);
+    for (u32 index : indices) {
+        ++adjacencyOffsets[index + 1];
+    }
+    for (u32 v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<u32> adjacency(indices.size());
+    std::vector<u32> remaining(vertexCount, 0);
+    for (u32 t = 0; t < triangleCount; ++t) {
+        for (u32 k = 0; k < 3; ++k) {
+            u32 v = indices[t * 3 + k];
+            adjacency[adjacencyOffsets[v] + remaining[v]++] = t;
+        }
+    }
+
+    auto score = [&](s32 cachePosition, u32 live) -> f32 {
+        if (live == 0) {
+            return -1.0f;
+        }
+        f32 s = 0.0f;
+        if (cachePosition >= 0) {
+            // the last triangle's vertices get a fixed score so it doesn't matter which order they went in
+            if (cachePosition < 3) {
+                s = 0.75f;
+            } else {
+                s = std::pow(1.0f - static_cast<f32>(cachePosition - 3) / static_cast<f32>(cacheSize - 3), 1.5f);
+            }
+        }
+        return s + 2.0f / std::sqrt(static_cast<f32>(live));
+    };
+
+    std::vector<s32> cachePositions(vertexCount, -1);
+    std::vector<f32> vertexScores(vertexCount);
+    for (u32 v = 0; v < vertexCount; ++v) {
+        vertexScores[v] = score(-1, remaining[v]);
+    }
+
+    std::vector<f32> triangleScores(triangleCount);
+    for (u32 t = 0; t < triangleCount; ++t) {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<u32> output;
+    output.reserve(indices.size());
+    std::vector<u32> boundaries;
+
+    std::vector<u32> cache;
+    std::vector<u32> nextCache;
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
+
+    const u32 minimumCluster = 16;
+    u32 clusterStart = 0;
+    u32 cursor = 0;
+    u32 best = NONE;
+    for (u32 emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (best == NONE) {
+            // dead end, nothing in the cache has triangles left: continue with the next one in input order
+            while (emitted[cursor]) {
+                ++cursor;
+            }
+            best = cursor;
+            boundaries.push_back(emittedCount);
+            clusterStart = emittedCount;
+        } else {
+            // a triangle sharing nothing with the cache starts a new patch of the surface
+            u32 misses = 0;
+            for (u32 k = 0; k < 3; ++k) {
+                misses += cachePositions[indices[best * 3 + k]] < 0;
+            }
+            if (misses == 3 && emittedCount - clusterStart >= minimumCluster) {
+                boundaries.push_back(emittedCount);
+                clusterStart = emittedCount;
+            }
+        }
+
+        u32 const* triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best] = true;
+
+        for (u32 k = 0; k < 3; ++k) {
+            u32 v = triangle[k];
+            u32* begin = &adjacency[adjacencyOffsets[v]];
+            u32* end = begin + remaining[v];
+            u32* found = std::find(begin, end, best);
+            std::swap(*found, *(end - 1));
+            --remaining[v];
+        }
+
+        // the triangle's vertices move to the front, everything else shifts back and may fall out
+        nextCache.assign(triangle, triangle + 3);
+        for (u32 v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                nextCache.push_back(v);
+            }
+        }
+        for (usize i = cacheSize; i < nextCache.size(); ++i) {
+            cachePositions[nextCache[i]] = -1;
+            vertexScores[nextCache[i]] = score(-1, remaining[nextCache[i]]);
+        }
+        if (nextCache.size() > cacheSize) {
+            nextCache.resize(cacheSize);
+        }
+        cache.swap(nextCache);
+
+        for (usize i = 0; i < cache.size(); ++i) {
+            cachePositions[cache[i]] = static_cast<s32>(i);
+            vertexScores[cache[i]] = score(static_cast<s32>(i), remaining[cache[i]]);
+        }
+
+        // only triangles touching the cache changed score, the best of them goes next
+        best = NONE;
+        f32 bestScore = -std::numeric_limits<f32>::max();
+        for (u32 v : cache) {
+            for (u32 i = 0; i < remaining[v]; ++i) {
+                u32 t = adjacency[adjacencyOffsets[v] + i];
+                u32 const* tri = &indices[t * 3];
+                triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+                if (triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+    return boundaries;
+}
+
+// Pedro Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw". Clusters facing away
+// from the mesh's center are on its outside and likely in front of the rest, so they are drawn first. Reordering
+// whole clusters only costs cache misses at their edges.
+static void optimizeOverdraw(MeshData& mesh, std::vector<u32> const& boundaries) {
+    const u32 triangleCount = static_cast<u32>(mesh.indices.size() / 3);
+    const u32 clusterCount = static_cast<u32>(boundaries.size());
+    if (clusterCount < 2) {
+        return;
+    }
+
+    auto position = [&](u32 index, u32 axis) -> f32 {
+        Vertex const& v = mesh.vertices[index];
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    };
+
+    f32 meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+    f32 meshArea = 0.0f;
+
+    struct Cluster {
+        u32 first;
+        u32 count;
+        f32 center[3];
+        f32 normal[3];
+        f32 area;
+        f32 sortKey;
+    };
+    std::vector<Cluster> clusters(clusterCount);
+    for (u32 c = 0; c < clusterCount; ++c) {
+        Cluster& cluster = clusters[c];
+        cluster = {};
+        cluster.first = boundaries[c];
+        cluster.count = (c + 1 < clusterCount ? boundaries[c + 1] : triangleCount) - cluster.first;
+
+        for (u32 t = cluster.first; t < cluster.first + cluster.count; ++t) {
+            u32 const* tri = &mesh.indices[t * 3];
+            f32 e1[3];
+            f32 e2[3];
+            for (u32 axis = 0; axis < 3; ++axis) {
+                e1[axis] = position(tri[1], axis) - position(tri[0], axis);
+                e2[axis] = position(tri[2], axis) - position(tri[0], axis);
+            }
+            // cross product, its length is twice the triangle's area so the sum is an area weighted normal
+            f32 n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            f32 area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (u32 axis = 0; axis < 3; ++axis) {
+                f32 centroid = (position(tri[0], axis) + position(tri[1], axis) + position(tri[2], axis)) / 3.0f;
+                cluster.center[axis] += centroid * area;
+                cluster.normal[axis] += n[axis];
+            }
+            cluster.area += area;
+        }
+
+        for (u32 axis = 0; axis < 3; ++axis) {
+            meshCenter[axis] += cluster.center[axis];
+        }
+        meshArea += cluster.area;
+        if (cluster.area > 0.0f) {
+            for (u32 axis = 0; axis < 3; ++axis) {
+                cluster.center[axis] /= cluster.area;
+            }
+        }
+    }
+    if (meshArea > 0.0f) {
+        for (u32 axis = 0; axis < 3; ++axis) {
+            meshCenter[axis] /= meshArea;
+        }
+    }
+
+    for (Cluster& cluster : clusters) {
+        f32 length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+        cluster.sortKey = 0.0f;
+        if (length > 0.0f) {
+            for (u32 axis = 0; axis < 3; ++axis) {
+                cluster.sortKey += (cluster.center[axis] - meshCenter[axis]) * cluster.normal[axis] / length;
+            }
+        }
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](Cluster const& a, Cluster const& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<u32> sorted;
+    sorted.reserve(mesh.indices.size());
+    for (Cluster const& cluster : clusters) {
+        sorted.insert(sorted.end(), mesh.indices.begin() + cluster.first * 3, mesh.indices.begin() + (cluster.first + cluster.count) * 3);
+    }
+    mesh.indices.swap(sorted);
+}
+
+// Renumbers vertices in the order the index buffer first touches them. Unreferenced vertices are dropped.
+static void optimizeVertexFetch(MeshData& mesh) {
+    const u32 NONE = ~0u;
+    const bool withNormals = !mesh.normals.empty();
+
+    std::vector<u32> remap(mesh.vertices.size(), NONE);
+    std::vector<Vertex> vertices;
+    std::vector<f32> normals;
+    vertices.reserve(mesh.vertices.size());
+    normals.reserve(mesh.normals.size());
+
+    for (u32& index : mesh.indices) {
+        if (remap[index] == NONE) {
+            remap[index] = static_cast<u32>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+            if (withNormals) {
+                normals.insert(normals.end(), mesh.normals.begin() + index * 3, mesh.normals.begin() + index * 3 + 3);
+            }
+        }
+        index = remap[index];
+    }
+
+    mesh.vertices.swap(vertices);
+    mesh.normals.swap(normals);
+}
+
+void optimizeMesh(MeshData& mesh, u32 cacheSize) {
+    if (mesh.indices.empty()) {
+        return;
+    }
+
+    // any levels from before would index vertices that are about to move
+    mesh.lods.clear();
+    deduplicateVertices(mesh);
+    std::vector<u32> boundaries = optimizeVertexCache(mesh.indices, static_cast<u32>(mesh.vertices.size()), cacheSize);
+    optimizeOverdraw(mesh, boundaries);
+    optimizeVertexFetch(mesh);
+}
+
+// Sum of squared distances to a set of planes as a symmetric 4x4 matrix, each plane weighted by its triangle's area.
+// Dividing by weight turns the error into an average squared distance, a length once its square root is taken.
+struct Quadric {
+    f64 a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    f64 weight;
+
+    void addPlane(f64 const n[3], f64 d, f64 w) {
+        a2 += w * n[0] * n[0];
+        ab += w * n[0] * n[1];
+        ac += w * n[0] * n[2];
+        ad += w * n[0] * d;
+        b2 += w * n[1] * n[1];
+        bc += w * n[1] * n[2];
+        bd += w * n[1] * d;
+        c2 += w * n[2] * n[2];
+        cd += w * n[2] * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    void add(Quadric const& q) {
+        a2 += q.a2;
+        ab += q.ab;
+        ac += q.ac;
+        ad += q.ad;
+        b2 += q.b2;
+        bc += q.bc;
+        bd += q.bd;
+        c2 += q.c2;
+        cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+    }
+
+    f64 error(Vertex const& v) const {
+        f64 x = v.x;
+        f64 y = v.y;
+        f64 z = v.z;
+        f64 e = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z) + d2;
+        return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+static void triangleNormal(Vertex const& a, Vertex const& b, Vertex const& c, f64 n[3]) {
+    f64 e1[3] = { static_cast<f64>(b.x) - a.x, static_cast<f64>(b.y) - a.y, static_cast<f64>(b.z) - a.z };
+    f64 e2[3] = { static_cast<f64>(c.x) - a.x, static_cast<f64>(c.y) - a.y, static_cast<f64>(c.z) - a.z };
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// Edge collapse state shared by all levels, quadrics keep accumulating so every level measures its error against
+// the full mesh and errors only grow from one level to the next.
+struct Simplifier {
+    std::vector<Vertex> const& vertices;
+    std::vector<Quadric> quadrics;
+    std::vector<bool> locked;
+    f64 maxError = 0.0;
+
+    Simplifier(MeshData const& mesh, std::vector<u32> const& indices) : vertices(mesh.vertices) {
+        const u32 vertexCount = static_cast<u32>(vertices.size());
+
+        // vertices that only differ in their attributes are one point of the surface, they can't move without
+        // tearing the seam between them
+        std::vector<u32> weld(vertexCount);
+        {
+            usize tableSize = 1;
+            while (tableSize < static_cast<usize>(vertexCount) * 2) {
+                tableSize <<= 1;
+            }
+            const u32 EMPTY = ~0u;
+            std::vector<u32> table(tableSize, EMPTY);
+            for (u32 v = 0; v < vertexCount; ++v) {
+                u64 h = 14695981039346656037ull;
+                u8 const* bytes = reinterpret_cast<u8 const*>(&vertices[v].x);
+                for (usize i = 0; i < sizeof(f32) * 3; ++i) {
+                    h = (h ^ bytes[i]) * 1099511628211ull;
+                }
+                usize slot = h & (tableSize - 1);
+                while (table[slot] != EMPTY && memcmp(&vertices[table[slot]].x, &vertices[v].x, sizeof(f32) * 3) != 0) {
+                    slot = (slot + 1) & (tableSize - 1);
+                }
+                if (table[slot] == EMPTY) {
+                    table[slot] = v;
+                }
+                weld[v] = table[slot];
+            }
+        }
+
+        locked.assign(vertexCount, false);
+        std::vector<u32> welded(vertexCount, 0);
+        for (u32 v = 0; v < vertexCount; ++v) {
+            ++welded[weld[v]];
+        }
+        for (u32 v = 0; v < vertexCount; ++v) {
+            locked[v] = welded[weld[v]] > 1;
+        }
+
+        // an edge of the welded surface with a single triangle is an open border, collapsing along it would eat
+        // into the outline
+        std::vector<u64> edges;
+        edges.reserve(indices.size());
+        for (usize t = 0; t < indices.size(); t += 3) {
+            for (u32 k = 0; k < 3; ++k) {
+                u32 a = weld[indices[t + k]];
+                u32 b = weld[indices[t + (k + 1) % 3]];
+                edges.push_back((static_cast<u64>(std::min(a, b)) << 32) | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        std::vector<bool> borderPoint(vertexCount, false);
+        for (usize i = 0; i < edges.size();) {
+            usize j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i]) {
+                ++j;
+            }
+            if (j - i == 1) {
+                borderPoint[edges[i] >> 32] = true;
+                borderPoint[edges[i] & 0xffffffff] = true;
+            }
+            i = j;
+        }
+        for (u32 v = 0; v < vertexCount; ++v) {
+            locked[v] = locked[v] || borderPoint[weld[v]];
+        }
+
+        quadrics.assign(vertexCount, Quadric{});
+        for (usize t = 0; t < indices.size(); t += 3) {
+            Vertex const& a = vertices[indices[t]];
+            f64 n[3];
+            triangleNormal(a, vertices[indices[t + 1]], vertices[indices[t + 2]], n);
+            f64 length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length == 0.0) {
+                continue;
+            }
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+            f64 d = -(n[0] * a.x + n[1] * a.y + n[2] * a.z);
+            for (u32 k = 0; k < 3; ++k) {
+                quadrics[indices[t + k]].addPlane(n, d, length * 0.5);
+            }
+        }
+    }
+
+    // Collapses edges cheapest first until indices is down to targetTriangles or no collapse is left. Each pass
+    // only touches vertices whose neighbourhood nothing else changed in the same pass, so adjacency and quadrics
+    // can be rebuilt once per pass instead of per collapse.
+    void simplify(std::vector<u32>& indices, u32 targetTriangles) {
+        const u32 vertexCount = static_cast<u32>(vertices.size());
+
+        std::vector<u32> adjacencyOffsets(vertexCount + 1);
+        std::vector<u32> adjacency;
+        std::vector<u32> remap(vertexCount);
+        std::vector<bool> dirty(vertexCount);
+
+        struct Collapse {
+            f64 cost;
+            u32 from;
+            u32 to;
+        };
+        std::vector<Collapse> collapses;
+
+        while (indices.size() / 3 > targetTriangles) {
+            const u32 triangleCount = static_cast<u32>(indices.size() / 3);
+
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (u32 index : indices) {
+                ++adjacencyOffsets[index + 1];
+            }
+            for (u32 v = 0; v < vertexCount; ++v) {
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            }
+            adjacency.resize(indices.size());
+            std::vector<u32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (u32 t = 0; t < triangleCount; ++t) {
+                for (u32 k = 0; k < 3; ++k) {
+                    adjacency[fill[indices[t * 3 + k]]++] = t;
+                }
+            }
+
+            collapses.clear();
+            for (u32 t = 0; t < triangleCount; ++t) {
+                for (u32 k = 0; k < 3; ++k) {
+                    u32 a = indices[t * 3 + k];
+                    u32 b = indices[t * 3 + (k + 1) % 3];
+                    for (u32 direction = 0; direction < 2; ++direction) {
+                        if (!locked[a]) {
+                            Quadric q = quadrics[a];
+                            q.add(quadrics[b]);
+                            collapses.push_back({ q.error(vertices[b]), a, b });
+                        }
+                        std::swap(a, b);
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](Collapse const& x, Collapse const& y) {
+                return x.cost < y.cost;
+            });
+
+            for (u32 v = 0; v < vertexCount; ++v) {
+                remap[v] = v;
+            }
+            std::fill(dirty.begin(), dirty.end(), false);
+
+            // every collapse takes out the two triangles along its edge, more on a mesh that is already degenerate
+            u32 removed = 0;
+            const u32 wanted = triangleCount - targetTriangles;
+            bool collapsedAny = false;
+            for (Collapse const& c : collapses) {
+                if (removed >= wanted) {
+                    break;
+                }
+                if (dirty[c.from] || dirty[c.to]) {
+                    continue;
+                }
+
+                // moving `from` onto `to` must not turn any remaining triangle around it over
+                bool flips = false;
+                u32 shared = 0;
+                for (u32 i = adjacencyOffsets[c.from]; i < adjacencyOffsets[c.from + 1] && !flips; ++i) {
+                    u32 const* tri = &indices[adjacency[i] * 3];
+                    if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                        ++shared;
+                        continue;
+                    }
+
+                    u32 moved[3] = { tri[0], tri[1], tri[2] };
+                    for (u32& v : moved) {
+                        v = v == c.from ? c.to : v;
+                    }
+                    f64 before[3];
+                    f64 after[3];
+                    triangleNormal(vertices[tri[0]], vertices[tri[1]], vertices[tri[2]], before);
+                    triangleNormal(vertices[moved[0]], vertices[moved[1]], vertices[moved[2]], after);
+                    flips = before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0;
+                }
+                if (flips || shared == 0) {
+                    continue;
+                }
+
+                remap[c.from] = c.to;
+                quadrics[c.to].add(quadrics[c.from]);
+                maxError = std::max(maxError, c.cost);
+                removed += shared;
+                collapsedAny = true;
+
+                dirty[c.from] = true;
+                dirty[c.to] = true;
+                for (u32 i = adjacencyOffsets[c.from]; i < adjacencyOffsets[c.from + 1]; ++i) {
+                    u32 const* tri = &indices[adjacency[i] * 3];
+                    dirty[tri[0]] = true;
+                    dirty[tri[1]] = true;
+                    dirty[tri[2]] = true;
+                }
+            }
+
+            if (!collapsedAny) {
+                break;
+            }
+
+            usize write = 0;
+            for (usize t = 0; t < indices.size(); t += 3) {
+                u32 a = remap[indices[t]];
+                u32 b = remap[indices[t + 1]];
+                u32 c = remap[indices[t + 2]];
+                if (a != b && b != c && a != c) {
+                    indices[write++] = a;
+                    indices[write++] = b;
+                    indices[write++] = c;
+                }
+            }
+            indices.resize(write);
+        }
+    }
+};
+
+void generateLods(MeshData& mesh, u32 lodCount, u32 cacheSize) {
+    if (mesh.indices.empty()) {
+        return;
+    }
+
+    if (mesh.lods.empty()) {
+        mesh.lods.push_back({ 0, static_cast<u32>(mesh.indices.size()), 0.0f });
+    }
+
+    MeshLod const& finest = mesh.lods.back();
+    std::vector<u32> level(mesh.indices.begin() + finest.firstIndex, mesh.indices.begin() + finest.firstIndex + finest.indexCount);
+    Simplifier simplifier(mesh, level);
+
+    while (mesh.lods.size() < lodCount) {
+        const u32 previous = static_cast<u32>(level.size() / 3);
+        simplifier.simplify(level, previous / 2);
+
+        // a level that barely shrank costs index memory without saving much, nor will the ones after it
+        if (level.empty() || level.size() / 3 > previous - previous / 4) {
+            break;
+        }
+
+        std::vector<u32> optimized = level;
+        optimizeVertexCache(optimized, static_cast<u32>(mesh.vertices.size()), cacheSize);
+
+        mesh.lods.push_back({ static_cast<u32>(mesh.indices.size()), static_cast<u32>(optimized.size()), static_cast<f32>(std::sqrt(simplifier.maxError)) });
+        mesh.indices.insert(mesh.indices.end(), optimized.begin(), optimized.end());
+    }
+}
+
+f32 averageCacheMissRatio(std::vector<u32> const& indices, u32 vertexCount, u32 cacheSize) {
+    if (indices.empty()) {
+        return 0.0f;
+    }
+
+    // timestamps instead of a queue: a vertex stays cached until cacheSize more misses have pushed it out
+    std::vector<u32> insertedAt(vertexCount, 0);
+    u32 misses = 0;
+    for (u32 index : indices) {
+        if (insertedAt[index] == 0 || misses - insertedAt[index] >= cacheSize) {
+            ++misses;
+            insertedAt[index] = misses;
+        }
+    }
+
+    return static_cast<f32>(misses) / static_cast<f32>(indices.size() / 3);
+}
+
+bool cookMesh(MeshData const& mesh, VertexFormat const& format, const char* path) {
+    const u32 vertexCount = static_cast<u32>(mesh.vertices.size());
+    if (vertexCount == 0 || mesh.lods.size() > CookedMeshHeader::MAX_LODS) {
+        return false;
+    }
+
+    std::vector<u8> vertexData;
+    VertexDecode decode = encodeVertices(format, mesh.vertices.data(), mesh.normals.empty() ? nullptr : mesh.normals.data(), vertexCount, vertexData);
+
+    // stored the way GeometryPool keeps them, so loading copies them as they are
+    const bool shortIndices = GeometryPool::indexTypeFor(vertexCount) == VK_INDEX_TYPE_UINT16;
+    std::vector<u8> indexData(mesh.indices.size() * (shortIndices ? sizeof(u16) : sizeof(u32)));
+    if (shortIndices) {
+        u16* dst = reinterpret_cast<u16*>(indexData.data());
+        for (usize i = 0; i < mesh.indices.size(); ++i) {
+            dst[i] = static_cast<u16>(mesh.indices[i]);
+        }
+    } else {
+        memcpy(indexData.data(), mesh.indices.data(), indexData.size());
+    }
+
+    auto align = [](u64 offset) -> u64 {
+        return (offset + 15) & ~u64(15);
+    };
+
+    CookedMeshHeader header = {};
+    header.magic = CookedMeshHeader::MAGIC;
+    header.version = CookedMeshHeader::VERSION;
+    header.position = format.position;
+    header.color = format.color;
+    header.uv = format.uv;
+    header.normal = format.normal;
+    header.vertexStride = format.stride();
+    header.vertexCount = vertexCount;
+    header.indexCount = static_cast<u32>(mesh.indices.size());
+    header.indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    header.decode = decode;
+    header.boundsMin[0] = header.boundsMin[1] = header.boundsMin[2] = std::numeric_limits<f32>::max();
+    header.boundsMax[0] = header.boundsMax[1] = header.boundsMax[2] = -std::numeric_limits<f32>::max();
+    for (Vertex const& v : mesh.vertices) {
+        f32 p[3] = { v.x, v.y, v.z };
+        for (u32 axis = 0; axis < 3; ++axis) {
+            header.boundsMin[axis] = std::min(header.boundsMin[axis], p[axis]);
+            header.boundsMax[axis] = std::max(header.boundsMax[axis], p[axis]);
+        }
+    }
+    if (mesh.lods.empty()) {
+        header.lodCount = 1;
+        header.lods[0] = { 0, header.indexCount, 0.0f };
+    } else {
+        header.lodCount = static_cast<u32>(mesh.lods.size());
+        std::copy(mesh.lods.begin(), mesh.lods.end(), header.lods);
+    }
+    header.vertexDataOffset = align(sizeof(CookedMeshHeader));
+    header.indexDataOffset = align(header.vertexDataOffset + vertexData.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const char padding[16] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, header.vertexDataOffset - sizeof(header));
+    file.write(reinterpret_cast<const char*>(vertexData.data()), vertexData.size());
+    file.write(padding, header.indexDataOffset - header.vertexDataOffset - vertexData.size());
+    file.write(reinterpret_cast<const char*>(indexData.data()), indexData.size());
+
+    return file.good();
+}
+
+bool CookedMesh::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<usize>(info.st_size) < sizeof(CookedMeshHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    mappingSize = static_cast<usize>(info.st_size);
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file alive on its own
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        mappingSize = 0;
+        return false;
+    }
+
+    u8 const* bytes = static_cast<u8 const*>(mapping);
+    header = reinterpret_cast<CookedMeshHeader const*>(bytes);
+
+    u64 indexSize = header->indexType == VK_INDEX_TYPE_UINT16 ? sizeof(u16) : sizeof(u32);
+    if (header->magic != CookedMeshHeader::MAGIC || header->version != CookedMeshHeader::VERSION
+        || header->vertexStride != header->format().stride()
+        || header->vertexDataOffset + static_cast<u64>(header->vertexCount) * header->vertexStride > mappingSize
+        || header->indexDataOffset + static_cast<u64>(header->indexCount) * indexSize > mappingSize
+        || header->lodCount == 0 || header->lodCount > CookedMeshHeader::MAX_LODS) {
+        close();
+        return false;
+    }
+    for (u32 i = 0; i < header->lodCount; ++i) {
+        if (static_cast<u64>(header->lods[i].firstIndex) + header->lods[i].indexCount > header->indexCount) {
+            close();
+            return false;
+        }
+    }
+
+    vertices = bytes + header->vertexDataOffset;
+    indices = bytes + header->indexDataOffset;
+    return true;
+}
+
+void CookedMesh::close() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    vertices = nullptr;
+    indices = nullptr;
+}
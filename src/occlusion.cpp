@@ -0,0 +1,377 @@
+#include <occlusion.hpp>
+#include <memory.hpp>
+#include <hostalloc.hpp>
+
+#include <algorithm>
+
+struct ReduceConstants {
+    s32 sourceSize[2];
+    s32 destinationSize[2];
+};
+
+bool HiZPyramid::create(VkDevice dev, VkPhysicalDevice physicalDevice, VkShaderModule reduceModule) {
+    device = dev;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &setLayout) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ReduceConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = reduceModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE), &pipeline) != VK_SUCCESS) {
+        pipeline = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    // everything is read with texelFetch, the sampler only has to exist
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(device, &samplerInfo, hostAllocator(VK_OBJECT_TYPE_SAMPLER), &sampler) != VK_SUCCESS) {
+        sampler = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    descriptorAllocator.init(device, 16, {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+    });
+
+    return true;
+}
+
+void HiZPyramid::destroyImage() {
+    for (VkImageView v : levelViews) {
+        vkDestroyImageView(device, v, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+    }
+    levelViews.clear();
+    sets.clear();
+    descriptorAllocator.reset();
+
+    vkDestroyImageView(device, view, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+    vkDestroyImage(device, image, hostAllocator(VK_OBJECT_TYPE_IMAGE));
+    freeMemory(device, memory);
+    view = VK_NULL_HANDLE;
+    image = VK_NULL_HANDLE;
+    memory = VK_NULL_HANDLE;
+    levelCount = 0;
+}
+
+void HiZPyramid::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    destroyImage();
+    descriptorAllocator.cleanup();
+
+    vkDestroySampler(device, sampler, hostAllocator(VK_OBJECT_TYPE_SAMPLER));
+    vkDestroyPipeline(device, pipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(device, pipelineLayout, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    vkDestroyDescriptorSetLayout(device, setLayout, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    sampler = VK_NULL_HANDLE;
+    pipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    setLayout = VK_NULL_HANDLE;
+}
+
+bool HiZPyramid::resize(VkImage depth, VkImageView depthView, VkFormat depthFormat, VkExtent2D depthSize) {
+    destroyImage();
+
+    depthImage = depth;
+    depthExtent = depthSize;
+    depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (depthFormat == VK_FORMAT_D24_UNORM_S8_UINT || depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D16_UNORM_S8_UINT) {
+        depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    extent.width = std::max(depthExtent.width / 2, 1u);
+    extent.height = std::max(depthExtent.height / 2, 1u);
+    levelCount = 1;
+    for (u32 w = extent.width, h = extent.height; w > 1 || h > 1; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u)) {
+        ++levelCount;
+    }
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R32_SFLOAT;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = levelCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE), &image) != VK_SUCCESS) {
+        image = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+
+    if (!allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_TARGETS, &memory)) {
+        memory = VK_NULL_HANDLE;
+        destroyImage();
+        return false;
+    }
+    vkBindImageMemory(device, image, memory, 0);
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R32_SFLOAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = levelCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device, &viewInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), &view) != VK_SUCCESS) {
+        view = VK_NULL_HANDLE;
+        destroyImage();
+        return false;
+    }
+
+    DescriptorWriter writer(device);
+    levelViews.resize(levelCount, VK_NULL_HANDLE);
+    sets.resize(levelCount, VK_NULL_HANDLE);
+    for (u32 i = 0; i < levelCount; ++i) {
+        viewInfo.subresourceRange.baseMipLevel = i;
+        viewInfo.subresourceRange.levelCount = 1;
+
+        if (vkCreateImageView(device, &viewInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), &levelViews[i]) != VK_SUCCESS) {
+            levelViews.resize(i);
+            destroyImage();
+            return false;
+        }
+
+        if (!descriptorAllocator.allocate(setLayout, &sets[i])) {
+            destroyImage();
+            return false;
+        }
+
+        if (i == 0) {
+            writer.writeImage(sets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, depthView, sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        } else {
+            writer.writeImage(sets[i], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levelViews[i - 1], sampler, VK_IMAGE_LAYOUT_GENERAL);
+        }
+        writer.writeImage(sets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levelViews[i], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL);
+    }
+    writer.flush();
+
+    return true;
+}
+
+void HiZPyramid::record(VkCommandBuffer commandBuffer) const {
+    VkImageMemoryBarrier barriers[2] = {};
+    barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image = depthImage;
+    barriers[0].subresourceRange = { depthAspect, 0, 1, 0, 1 };
+
+    // the whole pyramid is rewritten, the previous contents only have to be done being read
+    barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[1].srcAccessMask = 0;
+    barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[1].image = image;
+    barriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 2, barriers);
+
+    recordReduce(commandBuffer);
+
+    // the last level to the cull and the depth attachment back to the late pass
+    VkImageMemoryBarrier after[2] = {};
+    after[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    after[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    after[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    after[0].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    after[0].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    after[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    after[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    after[0].image = image;
+    after[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, levelCount - 1, 1, 0, 1 };
+
+    after[1] = barriers[0];
+    after[1].srcAccessMask = 0;
+    after[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    after[1].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    after[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0, 0, nullptr, 0, nullptr, 2, after);
+}
+
+void HiZPyramid::recordReduce(VkCommandBuffer commandBuffer) const {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+    ReduceConstants constants = {};
+    constants.sourceSize[0] = static_cast<s32>(depthExtent.width);
+    constants.sourceSize[1] = static_cast<s32>(depthExtent.height);
+    for (u32 i = 0; i < levelCount; ++i) {
+        constants.destinationSize[0] = static_cast<s32>(std::max(extent.width >> i, 1u));
+        constants.destinationSize[1] = static_cast<s32>(std::max(extent.height >> i, 1u));
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &sets[i], 0, nullptr);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReduceConstants), &constants);
+        vkCmdDispatch(commandBuffer, (constants.destinationSize[0] + GROUP_SIZE - 1) / GROUP_SIZE, (constants.destinationSize[1] + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+        // the next level reads this one; whoever reads the last level orders itself after it
+        if (i + 1 == levelCount) {
+            break;
+        }
+
+        VkImageMemoryBarrier levelBarrier = {};
+        levelBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        levelBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        levelBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        levelBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        levelBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        levelBarrier.image = image;
+        levelBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+
+        constants.sourceSize[0] = constants.destinationSize[0];
+        constants.sourceSize[1] = constants.destinationSize[1];
+    }
+}
+
+bool supportsDepthSampling(VkPhysicalDevice physicalDevice, VkFormat depthFormat) {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, depthFormat, &props);
+    return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+bool createTwoPhaseRenderPasses(VkDevice device, VkFormat colorFormat, VkFormat depthFormat, VkImageLayout finalColorLayout, VkRenderPass* earlyPass, VkRenderPass* latePass) {
+    VkAttachmentDescription attachments[2] = {};
+    attachments[0].format = colorFormat;
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[1].format = depthFormat;
+    attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+    subpass.pDepthStencilAttachment = &depthReference;
+
+    // same as the single pass, the depth buffer is shared between frames in flight
+    VkSubpassDependency dependency = {};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 2;
+    renderPassInfo.pAttachments = attachments;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
+
+    if (vkCreateRenderPass(device, &renderPassInfo, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS), earlyPass) != VK_SUCCESS) {
+        return false;
+    }
+
+    // the late pass continues on top of the early one, the Hi-Z build already moved depth back to an attachment
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[0].finalLayout = finalColorLayout;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    if (vkCreateRenderPass(device, &renderPassInfo, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS), latePass) != VK_SUCCESS) {
+        vkDestroyRenderPass(device, *earlyPass, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS));
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,40 @@
+#include <pacing.hpp>
+
+#include <thread>
+
+void FramePacer::waitForFrame() {
+    Clock::time_point start = Clock::now();
+    if (targetFrameSeconds > 0.0) {
+        const auto spin = std::chrono::microseconds(1500);
+        if (nextFrame - start > spin) {
+            std::this_thread::sleep_until(nextFrame - spin);
+        }
+        while (Clock::now() < nextFrame) {
+            std::this_thread::yield();
+        }
+
+        // a frame that ran late starts the schedule over rather than rushing the following ones to catch up
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(targetFrameSeconds));
+        Clock::time_point now = Clock::now();
+        nextFrame = nextFrame + period < now ? now + period : nextFrame + period;
+    }
+
+    input = Clock::now();
+    stats.sleepMs += std::chrono::duration<f64, std::milli>(input - start).count();
+}
+
+void FramePacer::frameSubmitted(u64 graphicsValue) {
+    Clock::time_point now = Clock::now();
+    ++stats.frames;
+    stats.inputToSubmitMs += std::chrono::duration<f64, std::milli>(now - input).count();
+    inFlight.push_back({ graphicsValue, input });
+}
+
+void FramePacer::poll(QueueTimeline& graphicsTimeline) {
+    Clock::time_point now = Clock::now();
+    while (!inFlight.empty() && graphicsTimeline.isComplete(inFlight.front().value)) {
+        stats.inputToGpuMs += std::chrono::duration<f64, std::milli>(now - inFlight.front().input).count();
+        ++stats.gpuFrames;
+        inFlight.pop_front();
+    }
+}
@@ -0,0 +1,345 @@
+#include <particles.hpp>
+#include <memory.hpp>
+#include <hostalloc.hpp>
+
+#include <cmath>
+#include <cstddef>
+
+// the Counters block of assets/particles.comp, the two uvec4 dispatch arguments start at 32 and 48
+static constexpr VkDeviceSize COUNTER_BYTES = 64;
+static constexpr VkDeviceSize EMIT_DISPATCH_OFFSET = 32;
+static constexpr VkDeviceSize SIMULATE_DISPATCH_OFFSET = 48;
+static constexpr VkDeviceSize PARTICLE_BYTES = 32;
+
+bool ParticleSystem::create(VkDevice dev, VkPhysicalDevice physicalDevice, VkRenderPass renderPass, VkShaderModule computeModule, VkShaderModule vertexModule, VkShaderModule fragmentModule, u32 maxParticles, u32 frameCount, std::vector<u32> const& queueFamilies) {
+    device = dev;
+    capacity = maxParticles;
+
+    // 0 uniform, 1 particles, 2 dead list, 3 alive lists, 4 counters, 5 instances, 6 draw arguments
+    VkDescriptorSetLayoutBinding bindings[7] = {};
+    for (u32 i = 0; i < 7; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = i == 0 ? VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT : VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 7;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &setLayout) != VK_SUCCESS) {
+        setLayout = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    // the compute stages and the draw share one layout, so a frame's single set serves both
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS) {
+        pipelineLayout = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    for (u32 stage = 0; stage < STAGE_COUNT; ++stage) {
+        VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(u32) };
+
+        VkSpecializationInfo specializationInfo = {};
+        specializationInfo.mapEntryCount = 1;
+        specializationInfo.pMapEntries = &specializationEntry;
+        specializationInfo.dataSize = sizeof(u32);
+        specializationInfo.pData = &stage;
+
+        VkComputePipelineCreateInfo pipelineInfo = {};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = computeModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.stage.pSpecializationInfo = &specializationInfo;
+        pipelineInfo.layout = pipelineLayout;
+
+        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE), &computePipelines[stage]) != VK_SUCCESS) {
+            computePipelines[stage] = VK_NULL_HANDLE;
+            cleanup();
+            return false;
+        }
+    }
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertexModule;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragmentModule;
+    stages[1].pName = "main";
+
+    // one instance per live particle, the billboard's four corners come from gl_VertexIndex
+    VkVertexInputBindingDescription vertexBinding = {};
+    vertexBinding.binding = 0;
+    vertexBinding.stride = sizeof(ParticleInstance);
+    vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription attributes[2] = {};
+    attributes[0] = { 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ParticleInstance, position) };
+    attributes[1] = { 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(ParticleInstance, color) };
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &vertexBinding;
+    vertexInput.vertexAttributeDescriptionCount = 2;
+    vertexInput.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // additive blending is order independent, so particles are hidden by the scene but not sorted among themselves
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blendAttachment.blendEnable = VK_TRUE;
+    blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo colorBlend = {};
+    colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+
+    VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = stages;
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlend;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+
+    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE), &drawPipeline) != VK_SUCCESS) {
+        drawPipeline = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    // the state never leaves the GPU, only the uniforms are host visible. The draw arguments can be copied out for
+    // statistics, hence TRANSFER_SRC
+    const VkDeviceSize count = capacity;
+    if (!createBuffer(device, memoryProperties, PARTICLE_BYTES * count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &particleBuffer, &particleMemory)
+        || !createBuffer(device, memoryProperties, sizeof(u32) * count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &deadBuffer, &deadMemory)
+        || !createBuffer(device, memoryProperties, sizeof(u32) * count * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &aliveBuffer, &aliveMemory)
+        || !createBuffer(device, memoryProperties, COUNTER_BYTES, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &counterBuffer, &counterMemory)) {
+        cleanup();
+        return false;
+    }
+
+    descriptorAllocator.init(device, frameCount, {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6.0f },
+    });
+
+    DescriptorWriter writer(device);
+    frames.resize(frameCount);
+    for (Frame& frame : frames) {
+        if (!createBuffer(device, memoryProperties, sizeof(ParticleUniform), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_UNIFORMS, queueFamilies, &frame.uniformBuffer, &frame.uniformMemory)
+            || vkMapMemory(device, frame.uniformMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&frame.uniform)) != VK_SUCCESS
+            || !createBuffer(device, memoryProperties, sizeof(ParticleInstance) * count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &frame.instanceBuffer, &frame.instanceMemory)
+            || !createBuffer(device, memoryProperties, sizeof(VkDrawIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_OTHER, queueFamilies, &frame.drawBuffer, &frame.drawMemory)
+            || !descriptorAllocator.allocate(setLayout, &frame.set)) {
+            cleanup();
+            return false;
+        }
+
+        *frame.uniform = {};
+
+        // the shader sizes everything off the dead list's length, so it is bound whole
+        writer.writeBuffer(frame.set, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frame.uniformBuffer, 0, sizeof(ParticleUniform));
+        writer.writeBuffer(frame.set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, particleBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.set, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, deadBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.set, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, aliveBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.set, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, counterBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.set, 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frame.instanceBuffer, 0, VK_WHOLE_SIZE);
+        writer.writeBuffer(frame.set, 6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frame.drawBuffer, 0, VK_WHOLE_SIZE);
+    }
+    writer.flush();
+
+    emitRemainder = 0.0f;
+    step = 0;
+    return true;
+}
+
+void ParticleSystem::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    for (Frame& frame : frames) {
+        vkDestroyBuffer(device, frame.uniformBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.uniformMemory);
+        vkDestroyBuffer(device, frame.instanceBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.instanceMemory);
+        vkDestroyBuffer(device, frame.drawBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.drawMemory);
+    }
+    frames.clear();
+    descriptorAllocator.cleanup();
+
+    vkDestroyBuffer(device, particleBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, particleMemory);
+    vkDestroyBuffer(device, deadBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, deadMemory);
+    vkDestroyBuffer(device, aliveBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, aliveMemory);
+    vkDestroyBuffer(device, counterBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, counterMemory);
+    particleBuffer = VK_NULL_HANDLE;
+    particleMemory = VK_NULL_HANDLE;
+    deadBuffer = VK_NULL_HANDLE;
+    deadMemory = VK_NULL_HANDLE;
+    aliveBuffer = VK_NULL_HANDLE;
+    aliveMemory = VK_NULL_HANDLE;
+    counterBuffer = VK_NULL_HANDLE;
+    counterMemory = VK_NULL_HANDLE;
+    capacity = 0;
+
+    for (VkPipeline& pipeline : computePipelines) {
+        vkDestroyPipeline(device, pipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+        pipeline = VK_NULL_HANDLE;
+    }
+    vkDestroyPipeline(device, drawPipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(device, pipelineLayout, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    vkDestroyDescriptorSetLayout(device, setLayout, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    drawPipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    setLayout = VK_NULL_HANDLE;
+}
+
+// every stage reads what the one before it wrote, the counters included, some of them as dispatch arguments
+static void computeBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccess;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void ParticleSystem::recordReset(VkCommandBuffer commandBuffer) const {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelines[STAGE_RESET]);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frames[0].set, 0, nullptr);
+    vkCmdDispatch(commandBuffer, (capacity + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+    computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void ParticleSystem::update(u32 frame, f32 dt, mat4x4 viewProj, mat4x4 view, f32 const emitterPosition[3]) {
+    ParticleUniform* uniform = frames[frame].uniform;
+    mat4x4_dup(uniform->viewProj, viewProj);
+
+    // linmath is column major, the view's first two rows are the camera's right and up axes in world space
+    for (u32 i = 0; i < 3; ++i) {
+        uniform->cameraRight[i] = view[i][0];
+        uniform->cameraUp[i] = view[i][1];
+    }
+
+    uniform->emitter[0] = emitterPosition[0];
+    uniform->emitter[1] = emitterPosition[1];
+    uniform->emitter[2] = emitterPosition[2];
+    uniform->emitter[3] = 0.05f;
+    uniform->gravity[0] = 0.0f;
+    uniform->gravity[1] = -0.5f;
+    uniform->gravity[2] = 0.0f;
+    uniform->gravity[3] = dt;
+
+    f32 emit = emitRemainder + emitRate * dt;
+    f32 whole = std::floor(emit);
+    emitRemainder = emit - whole;
+    uniform->emitCount = static_cast<u32>(whole);
+    uniform->seed = ++step * 0x9e3779b9u;
+    uniform->lifetime = lifetime;
+    uniform->speed = 0.5f;
+    uniform->size = 0.004f;
+}
+
+void ParticleSystem::recordSimulate(VkCommandBuffer commandBuffer, u32 frame) const {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frames[frame].set, 0, nullptr);
+
+    // the previous step's simulate and end, on this queue, are done with the state before begin touches the counters
+    computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelines[STAGE_BEGIN]);
+    vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+    computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelines[STAGE_EMIT]);
+    vkCmdDispatchIndirect(commandBuffer, counterBuffer, EMIT_DISPATCH_OFFSET);
+
+    computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelines[STAGE_SIMULATE]);
+    vkCmdDispatchIndirect(commandBuffer, counterBuffer, SIMULATE_DISPATCH_OFFSET);
+
+    computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelines[STAGE_END]);
+    vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+    // covers a draw recorded later on the same queue, a semaphore takes care of it across queues
+    computeBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+}
+
+void ParticleSystem::recordDraw(VkCommandBuffer commandBuffer, u32 frame) const {
+    Frame const& f = frames[frame];
+
+    VkDeviceSize offset = 0;
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &f.set, 0, nullptr);
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &f.instanceBuffer, &offset);
+    vkCmdDrawIndirect(commandBuffer, f.drawBuffer, 0, 1, sizeof(VkDrawIndirectCommand));
+}
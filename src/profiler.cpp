@@ -0,0 +1,112 @@
+#include <profiler.hpp>
+
+#ifdef VKHELLOWORLD_PROFILER
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace profiler {
+
+namespace {
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<Ring>> rings;
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+void writeEscaped(std::ofstream& out, const char* s) {
+    out << '"';
+    for (; *s != '\0'; ++s) {
+        if (*s == '"' || *s == '\\') {
+            out << '\\';
+        }
+        out << *s;
+    }
+    out << '"';
+}
+
+}
+
+u64 now() {
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+Ring& threadRing() {
+    thread_local Ring* ring = nullptr;
+    if (ring == nullptr) {
+        // rings are never freed, a thread that exits still has its zones exported
+        std::lock_guard<std::mutex> lock(registryMutex);
+        rings.push_back(std::make_unique<Ring>());
+        ring = rings.back().get();
+        ring->threadIndex = static_cast<u32>(rings.size());
+    }
+    return *ring;
+}
+
+void setThreadName(const char* name) {
+    threadRing().threadName = name;
+}
+
+bool writeChromeTrace(const char* path) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    std::vector<Ring*> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto const& ring : rings) {
+            snapshot.push_back(ring.get());
+        }
+    }
+
+    // microseconds with nanosecond digits, the default precision would round long traces to exponents
+    out << std::fixed;
+    out.precision(3);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    std::vector<Zone> zones;
+    for (Ring* ring : snapshot) {
+        u64 head = ring->head.load(std::memory_order_acquire);
+        u64 begin = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+        zones.clear();
+        for (u64 i = begin; i < head; ++i) {
+            zones.push_back(ring->zones[i % RING_CAPACITY]);
+        }
+
+        // anything the writer lapped while it was being copied may be torn, and so may the slot it is filling now:
+        // entry after goes into the slot of after - RING_CAPACITY before head says so. The fence keeps the copies
+        // above from moving past the second load.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        u64 after = ring->head.load(std::memory_order_relaxed);
+        u64 firstIntact = after + 1 > RING_CAPACITY ? after + 1 - RING_CAPACITY : 0;
+        usize skip = firstIntact > begin ? static_cast<usize>(std::min<u64>(firstIntact - begin, zones.size())) : 0;
+
+        if (ring->threadName != nullptr) {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadIndex << ",\"args\":{\"name\":";
+            writeEscaped(out, ring->threadName);
+            out << "}}";
+            first = false;
+        }
+        for (usize i = skip; i < zones.size(); ++i) {
+            Zone const& zone = zones[i];
+            out << (first ? "" : ",") << "\n{\"name\":";
+            writeEscaped(out, zone.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadIndex
+                << ",\"ts\":" << static_cast<f64>(zone.startNs) / 1000.0
+                << ",\"dur\":" << static_cast<f64>(zone.endNs - zone.startNs) / 1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+}
+
+#endif
@@ -0,0 +1,665 @@
+#include <rendergraph.hpp>
+#include <memory.hpp>
+#include <hostalloc.hpp>
+
+#include <algorithm>
+
+namespace {
+
+struct AccessInfo {
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    VkImageUsageFlags usage;
+};
+
+const AccessInfo ACCESS_INFOS[RenderGraph::ACCESS_COUNT] = {
+    { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+    { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT },
+    { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT },
+    { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT },
+    { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT },
+    { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT },
+    { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT },
+    { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT },
+    { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT },
+    { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 },
+    { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 },
+};
+
+// only writes have to be made available, a read access in srcAccessMask means nothing
+const VkAccessFlags WRITE_ACCESS = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+// where a resource stands between passes: the last writes and which stages and accesses have seen them since,
+// and the reads since, which a later write has to wait for
+struct ResourceState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags writeStages = 0;
+    VkAccessFlags writeAccess = 0;
+    VkPipelineStageFlags visibleStages = 0;
+    VkAccessFlags visibleAccess = 0;
+    VkPipelineStageFlags readStages = 0;
+    bool touched = false;
+};
+
+// every use of one resource in a pass folded into one, conflicting image layouts fall back to GENERAL
+struct MergedUse {
+    u32 resource;
+    bool image;
+    bool write;
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    VkImageLayout layout;
+};
+
+std::vector<MergedUse> mergeUses(std::vector<RenderGraph::Use> const& uses) {
+    std::vector<MergedUse> merged;
+    for (RenderGraph::Use const& use : uses) {
+        AccessInfo const& info = ACCESS_INFOS[use.access];
+        auto it = std::find_if(merged.begin(), merged.end(), [&](MergedUse const& m) { return m.resource == use.resource && m.image == use.image; });
+        if (it == merged.end()) {
+            merged.push_back({ use.resource, use.image, use.write, info.stages, info.access, info.layout });
+            continue;
+        }
+        it->write = it->write || use.write;
+        it->stages |= info.stages;
+        it->access |= info.access;
+        if (it->layout != info.layout) {
+            it->layout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+    }
+    return merged;
+}
+
+}
+
+void RenderGraph::init(VkDevice dev, VkPhysicalDevice physicalDevice) {
+    cleanup();
+    device = dev;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+}
+
+void RenderGraph::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    destroyCompiled();
+    images.clear();
+    buffers.clear();
+    passes.clear();
+    outputImages.clear();
+    outputBuffers.clear();
+}
+
+void RenderGraph::destroyCompiled() {
+    for (Pass& pass : passes) {
+        vkDestroyFramebuffer(device, pass.framebuffer, hostAllocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+        vkDestroyRenderPass(device, pass.renderPass, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS));
+        pass.framebuffer = VK_NULL_HANDLE;
+        pass.renderPass = VK_NULL_HANDLE;
+        pass.live = false;
+        pass.srcStages = 0;
+        pass.dstStages = 0;
+        pass.memoryBarrier = {};
+        pass.imageBarriers.clear();
+    }
+
+    for (Image& image : images) {
+        if (image.imported) {
+            continue;
+        }
+        vkDestroyImageView(device, image.view, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+        vkDestroyImage(device, image.image, hostAllocator(VK_OBJECT_TYPE_IMAGE));
+        image.view = VK_NULL_HANDLE;
+        image.image = VK_NULL_HANDLE;
+        image.usage = 0;
+        image.block = INVALID;
+        image.firstPass = INVALID;
+        image.lastPass = INVALID;
+    }
+
+    for (Block& block : blocks) {
+        freeMemory(device, block.memory);
+    }
+    blocks.clear();
+
+    finalSrcStages = 0;
+    finalDstStages = 0;
+    finalMemoryBarrier = {};
+    finalImageBarriers.clear();
+    culledPasses = 0;
+    barrierCount = 0;
+    transientBytes = 0;
+    unaliasedTransientBytes = 0;
+}
+
+u32 RenderGraph::importImage(VkImage handle, VkImageView view, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect, VkImageLayout initialLayout, VkPipelineStageFlags initialStages, VkAccessFlags initialAccess, VkImageLayout finalLayout, VkPipelineStageFlags finalStages, VkAccessFlags finalAccess) {
+    Image image;
+    image.image = handle;
+    image.view = view;
+    image.format = format;
+    image.extent = extent;
+    image.aspect = aspect;
+    image.imported = true;
+    image.initialLayout = initialLayout;
+    image.initialStages = initialStages;
+    image.initialAccess = initialAccess;
+    image.finalLayout = finalLayout;
+    image.finalStages = finalStages;
+    image.finalAccess = finalAccess;
+    images.push_back(image);
+    return static_cast<u32>(images.size() - 1);
+}
+
+u32 RenderGraph::importBuffer(VkBuffer handle, VkPipelineStageFlags finalStages, VkAccessFlags finalAccess) {
+    Buffer buffer;
+    buffer.buffer = handle;
+    buffer.finalStages = finalStages;
+    buffer.finalAccess = finalAccess;
+    buffers.push_back(buffer);
+    return static_cast<u32>(buffers.size() - 1);
+}
+
+u32 RenderGraph::createImage(VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect) {
+    Image image;
+    image.format = format;
+    image.extent = extent;
+    image.aspect = aspect;
+    images.push_back(image);
+    return static_cast<u32>(images.size() - 1);
+}
+
+void RenderGraph::markOutput(u32 image) {
+    outputImages.push_back(image);
+}
+
+void RenderGraph::markBufferOutput(u32 buffer) {
+    outputBuffers.push_back(buffer);
+}
+
+u32 RenderGraph::addPass(const char* name, PassType type, std::function<void(VkCommandBuffer)> execute) {
+    Pass pass;
+    pass.name = name;
+    pass.type = type;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+    return static_cast<u32>(passes.size() - 1);
+}
+
+void RenderGraph::setSideEffects(u32 pass) {
+    passes[pass].sideEffects = true;
+}
+
+void RenderGraph::readImage(u32 pass, u32 image, Access access) {
+    passes[pass].uses.push_back({ image, true, access, false });
+}
+
+void RenderGraph::writeImage(u32 pass, u32 image, Access access) {
+    passes[pass].uses.push_back({ image, true, access, true });
+}
+
+void RenderGraph::readBuffer(u32 pass, u32 buffer, Access access) {
+    passes[pass].uses.push_back({ buffer, false, access, false });
+}
+
+void RenderGraph::writeBuffer(u32 pass, u32 buffer, Access access) {
+    passes[pass].uses.push_back({ buffer, false, access, true });
+}
+
+void RenderGraph::colorAttachment(u32 pass, u32 image, VkAttachmentLoadOp loadOp, VkClearColorValue clear) {
+    Attachment attachment;
+    attachment.image = image;
+    attachment.loadOp = loadOp;
+    attachment.clear.color = clear;
+    passes[pass].colors.push_back(attachment);
+
+    if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+        readImage(pass, image, ACCESS_COLOR_ATTACHMENT);
+    }
+    writeImage(pass, image, ACCESS_COLOR_ATTACHMENT);
+}
+
+void RenderGraph::depthAttachment(u32 pass, u32 image, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clear) {
+    Attachment& attachment = passes[pass].depth;
+    attachment.image = image;
+    attachment.loadOp = loadOp;
+    attachment.clear.depthStencil = clear;
+
+    if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+        readImage(pass, image, ACCESS_DEPTH_ATTACHMENT);
+    }
+    writeImage(pass, image, ACCESS_DEPTH_ATTACHMENT);
+}
+
+bool RenderGraph::compile() {
+    destroyCompiled();
+
+    // culling walks backwards tracking which resources someone downstream still reads; a live pass produces what
+    // it writes, so earlier writers of the same resource are only needed if this pass reads it too
+    std::vector<bool> imageNeeded(images.size(), false);
+    std::vector<bool> bufferNeeded(buffers.size(), false);
+    for (u32 image : outputImages) {
+        imageNeeded[image] = true;
+    }
+    for (u32 buffer : outputBuffers) {
+        bufferNeeded[buffer] = true;
+    }
+
+    for (usize p = passes.size(); p-- > 0;) {
+        Pass& pass = passes[p];
+        pass.live = pass.sideEffects;
+        for (Use const& use : pass.uses) {
+            if (use.write && (use.image ? imageNeeded[use.resource] : bufferNeeded[use.resource])) {
+                pass.live = true;
+            }
+        }
+        if (!pass.live) {
+            ++culledPasses;
+            continue;
+        }
+
+        for (Use const& use : pass.uses) {
+            if (use.write) {
+                (use.image ? imageNeeded : bufferNeeded)[use.resource] = false;
+            }
+        }
+        for (Use const& use : pass.uses) {
+            if (!use.write) {
+                (use.image ? imageNeeded : bufferNeeded)[use.resource] = true;
+            }
+        }
+    }
+
+    std::vector<std::vector<MergedUse>> passUses(passes.size());
+    for (u32 p = 0; p < passes.size(); ++p) {
+        if (!passes[p].live) {
+            continue;
+        }
+        passUses[p] = mergeUses(passes[p].uses);
+        for (Use const& use : passes[p].uses) {
+            if (!use.image || images[use.resource].imported) {
+                continue;
+            }
+            Image& image = images[use.resource];
+            image.usage |= ACCESS_INFOS[use.access].usage;
+            image.firstPass = std::min(image.firstPass, p);
+            image.lastPass = image.lastPass == INVALID ? p : std::max(image.lastPass, p);
+        }
+    }
+
+    // largest first, each into the first block whose tenants are all dead before it starts or born after it ends
+    std::vector<u32> transients;
+    std::vector<VkMemoryRequirements> requirements(images.size());
+    for (u32 i = 0; i < images.size(); ++i) {
+        Image& image = images[i];
+        if (image.imported || image.firstPass == INVALID) {
+            continue;
+        }
+        if (!createTransientImage(image)) {
+            destroyCompiled();
+            return false;
+        }
+        vkGetImageMemoryRequirements(device, image.image, &requirements[i]);
+        unaliasedTransientBytes += requirements[i].size;
+        transients.push_back(i);
+    }
+    std::sort(transients.begin(), transients.end(), [&](u32 a, u32 b) { return requirements[a].size > requirements[b].size; });
+
+    for (u32 i : transients) {
+        Image& image = images[i];
+        for (u32 b = 0; b < blocks.size() && image.block == INVALID; ++b) {
+            Block& block = blocks[b];
+            if ((block.memoryTypeBits & requirements[i].memoryTypeBits) == 0) {
+                continue;
+            }
+            bool overlaps = std::any_of(block.images.begin(), block.images.end(), [&](u32 other) {
+                return images[other].firstPass <= image.lastPass && image.firstPass <= images[other].lastPass;
+            });
+            if (!overlaps) {
+                block.memoryTypeBits &= requirements[i].memoryTypeBits;
+                block.size = std::max(block.size, requirements[i].size);
+                block.images.push_back(i);
+                image.block = b;
+            }
+        }
+        if (image.block == INVALID) {
+            Block block;
+            block.memoryTypeBits = requirements[i].memoryTypeBits;
+            block.size = requirements[i].size;
+            block.images.push_back(i);
+            image.block = static_cast<u32>(blocks.size());
+            blocks.push_back(block);
+        }
+    }
+
+    for (Block& block : blocks) {
+        VkMemoryRequirements blockRequirements = {};
+        blockRequirements.size = block.size;
+        blockRequirements.memoryTypeBits = block.memoryTypeBits;
+
+        if (!allocateMemory(device, memoryProperties, blockRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_TARGETS, &block.memory)) {
+            destroyCompiled();
+            return false;
+        }
+        transientBytes += block.size;
+
+        for (u32 i : block.images) {
+            Image& image = images[i];
+            vkBindImageMemory(device, image.image, block.memory, 0);
+
+            VkImageViewCreateInfo viewInfo = {};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = image.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = image.format;
+            viewInfo.subresourceRange.aspectMask = image.aspect;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(device, &viewInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), &image.view) != VK_SUCCESS) {
+                image.view = VK_NULL_HANDLE;
+                destroyCompiled();
+                return false;
+            }
+        }
+    }
+
+    std::vector<ResourceState> imageStates(images.size());
+    std::vector<ResourceState> bufferStates(buffers.size());
+    for (u32 i = 0; i < images.size(); ++i) {
+        if (images[i].imported) {
+            imageStates[i].layout = images[i].initialLayout;
+            imageStates[i].writeStages = images[i].initialStages;
+            imageStates[i].writeAccess = images[i].initialAccess;
+        }
+    }
+
+    // a block's first tenant in a frame follows its last tenant of the previous frame, whose final pass is known
+    // up front, so the wait carries over across execute() calls
+    struct BlockState {
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags access = 0;
+    };
+    std::vector<BlockState> blockStates(blocks.size());
+    for (u32 b = 0; b < blocks.size(); ++b) {
+        u32 last = *std::max_element(blocks[b].images.begin(), blocks[b].images.end(), [&](u32 x, u32 y) { return images[x].lastPass < images[y].lastPass; });
+        for (MergedUse const& use : passUses[images[last].lastPass]) {
+            if (use.image && use.resource == last) {
+                blockStates[b] = { use.stages, use.write ? use.access & WRITE_ACCESS : 0 };
+            }
+        }
+    }
+
+    for (u32 p = 0; p < passes.size(); ++p) {
+        Pass& pass = passes[p];
+        if (!pass.live) {
+            continue;
+        }
+
+        VkAccessFlags srcAccess = 0;
+        VkAccessFlags dstAccess = 0;
+        for (MergedUse const& use : passUses[p]) {
+            ResourceState& state = use.image ? imageStates[use.resource] : bufferStates[use.resource];
+            Image const* image = use.image ? &images[use.resource] : nullptr;
+
+            // a transient's contents start over every frame, after whatever last used its memory
+            if (image != nullptr && !image->imported && !state.touched) {
+                BlockState const& previous = blockStates[image->block];
+                state = {};
+                state.writeStages = previous.stages;
+                state.writeAccess = previous.access;
+            }
+            state.touched = true;
+
+            bool transition = image != nullptr && state.layout != use.layout;
+            bool readAfterWrite = state.writeStages != 0 && ((use.stages & ~state.visibleStages) != 0 || (use.access & ~state.visibleAccess) != 0);
+            bool writeAfterRead = use.write && state.readStages != 0;
+
+            if (transition) {
+                VkImageMemoryBarrier barrier = {};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask = state.writeAccess;
+                barrier.dstAccessMask = use.access;
+                barrier.oldLayout = state.layout;
+                barrier.newLayout = use.layout;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = image->image;
+                barrier.subresourceRange.aspectMask = image->aspect;
+                barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+                barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+                pass.imageBarriers.push_back(barrier);
+                pass.srcStages |= state.writeStages | state.readStages;
+                pass.dstStages |= use.stages;
+            } else if (readAfterWrite || (use.write && state.writeStages != 0)) {
+                srcAccess |= state.writeAccess;
+                dstAccess |= use.access;
+                pass.srcStages |= state.writeStages | (writeAfterRead ? state.readStages : 0);
+                pass.dstStages |= use.stages;
+            } else if (writeAfterRead) {
+                pass.srcStages |= state.readStages;
+                pass.dstStages |= use.stages;
+            }
+
+            state.layout = image != nullptr ? use.layout : state.layout;
+            if (use.write) {
+                state.writeStages = use.stages;
+                state.writeAccess = use.access & WRITE_ACCESS;
+                state.visibleStages = 0;
+                state.visibleAccess = 0;
+                state.readStages = 0;
+            } else {
+                // a transition counts as a write that the barrier made visible to this use only
+                if (transition) {
+                    state.writeStages = use.stages;
+                    state.writeAccess = 0;
+                    state.visibleStages = 0;
+                    state.visibleAccess = 0;
+                }
+                state.visibleStages |= use.stages;
+                state.visibleAccess |= use.access;
+                state.readStages |= use.stages;
+            }
+
+            if (image != nullptr && !image->imported) {
+                blockStates[image->block] = { use.stages, use.write ? use.access & WRITE_ACCESS : 0 };
+            }
+        }
+
+        if (srcAccess != 0 || dstAccess != 0) {
+            pass.memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            pass.memoryBarrier.srcAccessMask = srcAccess;
+            pass.memoryBarrier.dstAccessMask = dstAccess;
+        }
+        if (pass.dstStages != 0) {
+            pass.srcStages = pass.srcStages != 0 ? pass.srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            ++barrierCount;
+        }
+
+        if (pass.type == PASS_GRAPHICS && !createRenderPass(pass)) {
+            destroyCompiled();
+            return false;
+        }
+    }
+
+    for (u32 i = 0; i < images.size(); ++i) {
+        Image const& image = images[i];
+        ResourceState const& state = imageStates[i];
+        if (!image.imported || image.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || (state.layout == image.finalLayout && state.writeAccess == 0)) {
+            continue;
+        }
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = state.writeAccess;
+        barrier.dstAccessMask = image.finalAccess;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = image.finalLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.image;
+        barrier.subresourceRange.aspectMask = image.aspect;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        finalImageBarriers.push_back(barrier);
+        finalSrcStages |= state.writeStages | state.readStages;
+        finalDstStages |= image.finalStages;
+    }
+    for (u32 i = 0; i < buffers.size(); ++i) {
+        ResourceState const& state = bufferStates[i];
+        // only read here but written after the graph: that write has to wait for the reads, which takes an execution
+        // dependency and no access
+        if (state.writeAccess == 0 && state.readStages != 0 && (buffers[i].finalAccess & WRITE_ACCESS) != 0) {
+            finalSrcStages |= state.readStages;
+            finalDstStages |= buffers[i].finalStages;
+            continue;
+        }
+        if (state.writeAccess == 0 || buffers[i].finalAccess == 0) {
+            continue;
+        }
+        finalMemoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        finalMemoryBarrier.srcAccessMask |= state.writeAccess;
+        finalMemoryBarrier.dstAccessMask |= buffers[i].finalAccess;
+        finalSrcStages |= state.writeStages | ((buffers[i].finalAccess & WRITE_ACCESS) != 0 ? state.readStages : 0);
+        finalDstStages |= buffers[i].finalStages;
+    }
+    if (finalDstStages != 0) {
+        finalSrcStages = finalSrcStages != 0 ? finalSrcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        ++barrierCount;
+    }
+
+    return true;
+}
+
+bool RenderGraph::createTransientImage(Image& image) {
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = image.format;
+    imageInfo.extent = { image.extent.width, image.extent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = image.usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE), &image.image) != VK_SUCCESS) {
+        image.image = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+bool RenderGraph::createRenderPass(Pass& pass) {
+    // the barrier in front of the pass already put every attachment in its layout, so it is kept throughout. A
+    // transient attachment nobody reads after this pass isn't stored
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<VkAttachmentReference> colorReferences;
+    std::vector<VkImageView> views;
+    u32 passIndex = static_cast<u32>(&pass - passes.data());
+
+    auto addAttachment = [&](Attachment const& attachment, VkImageLayout layout) {
+        Image const& image = images[attachment.image];
+        VkAttachmentDescription description = {};
+        description.format = image.format;
+        description.samples = VK_SAMPLE_COUNT_1_BIT;
+        description.loadOp = attachment.loadOp;
+        description.storeOp = !image.imported && image.lastPass == passIndex ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.initialLayout = layout;
+        description.finalLayout = layout;
+        attachments.push_back(description);
+        views.push_back(image.view);
+        pass.extent = image.extent;
+        return VkAttachmentReference{ static_cast<u32>(attachments.size() - 1), layout };
+    };
+
+    for (Attachment const& color : pass.colors) {
+        colorReferences.push_back(addAttachment(color, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+    }
+    VkAttachmentReference depthReference = {};
+    if (pass.depth.image != INVALID) {
+        depthReference = addAttachment(pass.depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+    }
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<u32>(colorReferences.size());
+    subpass.pColorAttachments = colorReferences.data();
+    subpass.pDepthStencilAttachment = pass.depth.image != INVALID ? &depthReference : nullptr;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<u32>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(device, &renderPassInfo, hostAllocator(VK_OBJECT_TYPE_RENDER_PASS), &pass.renderPass) != VK_SUCCESS) {
+        pass.renderPass = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = pass.renderPass;
+    framebufferInfo.attachmentCount = static_cast<u32>(views.size());
+    framebufferInfo.pAttachments = views.data();
+    framebufferInfo.width = pass.extent.width;
+    framebufferInfo.height = pass.extent.height;
+    framebufferInfo.layers = 1;
+
+    if (vkCreateFramebuffer(device, &framebufferInfo, hostAllocator(VK_OBJECT_TYPE_FRAMEBUFFER), &pass.framebuffer) != VK_SUCCESS) {
+        pass.framebuffer = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer) const {
+    std::vector<VkClearValue> clearValues;
+    for (Pass const& pass : passes) {
+        if (!pass.live) {
+            continue;
+        }
+
+        if (pass.dstStages != 0) {
+            bool memory = pass.memoryBarrier.sType == VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            vkCmdPipelineBarrier(commandBuffer, pass.srcStages, pass.dstStages, 0, memory ? 1 : 0, &pass.memoryBarrier, 0, nullptr, static_cast<u32>(pass.imageBarriers.size()), pass.imageBarriers.data());
+        }
+
+        if (pass.type != PASS_GRAPHICS) {
+            pass.execute(commandBuffer);
+            continue;
+        }
+
+        clearValues.clear();
+        for (Attachment const& color : pass.colors) {
+            clearValues.push_back(color.clear);
+        }
+        if (pass.depth.image != INVALID) {
+            clearValues.push_back(pass.depth.clear);
+        }
+
+        VkRenderPassBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        beginInfo.renderPass = pass.renderPass;
+        beginInfo.framebuffer = pass.framebuffer;
+        beginInfo.renderArea.extent = pass.extent;
+        beginInfo.clearValueCount = static_cast<u32>(clearValues.size());
+        beginInfo.pClearValues = clearValues.data();
+
+        vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        pass.execute(commandBuffer);
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    if (finalDstStages != 0) {
+        bool memory = finalMemoryBarrier.sType == VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        vkCmdPipelineBarrier(commandBuffer, finalSrcStages, finalDstStages, 0, memory ? 1 : 0, &finalMemoryBarrier, 0, nullptr, static_cast<u32>(finalImageBarriers.size()), finalImageBarriers.data());
+    }
+}
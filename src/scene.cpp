@@ -0,0 +1,86 @@
+#include <scene.hpp>
+
+#include <algorithm>
+
+bool sortFrontToBack(std::vector<DrawItem>& draws, mat4x4 modelView) {
+    struct Key {
+        f32 distance;
+        u32 index;
+    };
+
+    std::vector<Key> keys(draws.size());
+    for (usize i = 0; i < draws.size(); ++i) {
+        vec4 center = { draws[i].center[0], draws[i].center[1], draws[i].center[2], 1.0f };
+        vec4 viewCenter;
+        mat4x4_mul_vec4(viewCenter, modelView, center);
+
+        keys[i].distance = viewCenter[0] * viewCenter[0] + viewCenter[1] * viewCenter[1] + viewCenter[2] * viewCenter[2];
+        keys[i].index = static_cast<u32>(i);
+    }
+
+    // stable so equally distant draws keep submission order and the result does not flicker between frames
+    std::stable_sort(keys.begin(), keys.end(), [](Key const& a, Key const& b) {
+        return a.distance < b.distance;
+    });
+
+    bool changed = false;
+    std::vector<DrawItem> sorted(draws.size());
+    for (usize i = 0; i < keys.size(); ++i) {
+        sorted[i] = draws[keys[i].index];
+        changed |= keys[i].index != i;
+    }
+
+    if (changed) {
+        draws.swap(sorted);
+    }
+
+    return changed;
+}
+
+bool selectDrawLods(std::vector<DrawItem>& draws, f32 const eye[3], f32 projectionScale, f32 thresholdPixels, u64* triangles) {
+    std::vector<u32> order;
+    for (usize i = 0; i < draws.size(); ++i) {
+        if (draws[i].lods != nullptr) {
+            order.push_back(static_cast<u32>(i));
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+        return draws[a].lods < draws[b].lods;
+    });
+
+    std::vector<f32> x(order.size());
+    std::vector<f32> y(order.size());
+    std::vector<f32> z(order.size());
+    std::vector<u8> picked(order.size());
+    for (usize i = 0; i < order.size(); ++i) {
+        x[i] = draws[order[i]].center[0];
+        y[i] = draws[order[i]].center[1];
+        z[i] = draws[order[i]].center[2];
+    }
+
+    bool changed = false;
+    for (usize begin = 0; begin < order.size();) {
+        LodChain const& chain = *draws[order[begin]].lods;
+        usize end = begin + 1;
+        while (end < order.size() && draws[order[end]].lods == &chain) {
+            ++end;
+        }
+
+        u64 chosen = selectLods(chain, &x[begin], &y[begin], &z[begin], static_cast<u32>(end - begin), eye, projectionScale, thresholdPixels, &picked[begin]);
+        if (triangles != nullptr) {
+            *triangles += chosen;
+        }
+
+        for (usize i = begin; i < end; ++i) {
+            DrawItem& draw = draws[order[i]];
+            u32 firstIndex = chain.firstIndex[picked[i]];
+            changed |= draw.firstIndex != firstIndex;
+            draw.firstIndex = firstIndex;
+            draw.indexCount = chain.indexCount[picked[i]];
+        }
+
+        begin = end;
+    }
+
+    return changed;
+}
@@ -0,0 +1,30 @@
+#include <shader.hpp>
+#include <types.hpp>
+#include <hostalloc.hpp>
+
+#include <vector>
+#include <fstream>
+
+bool loadShaderModule(VkDevice device, const char* path, VkShaderModule* module) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    usize size = file.tellg();
+    if (size == 0 || size % sizeof(u32) != 0) {
+        return false;
+    }
+
+    std::vector<u32> code(size / sizeof(u32));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(code.data()), size);
+    file.close();
+
+    VkShaderModuleCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.codeSize = size;
+    info.pCode = code.data();
+
+    return vkCreateShaderModule(device, &info, hostAllocator(VK_OBJECT_TYPE_SHADER_MODULE), module) == VK_SUCCESS;
+}
@@ -0,0 +1,600 @@
+#include <sprites.hpp>
+#include <memory.hpp>
+#include <hostalloc.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+struct SpriteConstants {
+    f32 scale[2];
+    f32 offset[2];
+};
+
+namespace {
+
+// 2x2 box filter down to half the size, an odd last row or column is averaged with itself
+void halve(u8 const* rgba, u32 width, u32 height, std::vector<u8>& half) {
+    const u32 halfWidth = std::max(width / 2, 1u);
+    const u32 halfHeight = std::max(height / 2, 1u);
+    half.resize(static_cast<usize>(halfWidth) * halfHeight * 4);
+    for (u32 y = 0; y < halfHeight; ++y) {
+        const usize row0 = std::min(y * 2, height - 1);
+        const usize row1 = std::min(y * 2 + 1, height - 1);
+        for (u32 x = 0; x < halfWidth; ++x) {
+            const usize column0 = std::min(x * 2, width - 1);
+            const usize column1 = std::min(x * 2 + 1, width - 1);
+            for (u32 c = 0; c < 4; ++c) {
+                u32 sum = rgba[(row0 * width + column0) * 4 + c] + rgba[(row0 * width + column1) * 4 + c]
+                    + rgba[(row1 * width + column0) * 4 + c] + rgba[(row1 * width + column1) * 4 + c];
+                half[(static_cast<usize>(y) * halfWidth + x) * 4 + c] = static_cast<u8>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+}
+
+void SkylinePacker::init(u32 w, u32 h) {
+    width = w;
+    height = h;
+    skyline.clear();
+    skyline.push_back({ 0, 0, width });
+}
+
+bool SkylinePacker::pack(u32 rectWidth, u32 rectHeight, u32* x, u32* y) {
+    usize best = skyline.size();
+    u32 bestY = height;
+    for (usize i = 0; i < skyline.size(); ++i) {
+        u32 left = skyline[i].x;
+        if (left + rectWidth > width) {
+            break;
+        }
+
+        // the rectangle rests on the highest segment under its width
+        u32 top = 0;
+        u32 covered = 0;
+        for (usize j = i; j < skyline.size() && covered < rectWidth; ++j) {
+            top = std::max(top, skyline[j].y);
+            covered = skyline[j].x + skyline[j].width - left;
+        }
+
+        if (top + rectHeight <= height && top < bestY) {
+            best = i;
+            bestY = top;
+        }
+    }
+
+    if (best == skyline.size()) {
+        return false;
+    }
+
+    *x = skyline[best].x;
+    *y = bestY;
+
+    // the new segment replaces everything it covers, a partly covered segment keeps its uncovered right part
+    Segment placed = { *x, bestY + rectHeight, rectWidth };
+    u32 right = placed.x + placed.width;
+    usize end = best;
+    while (end < skyline.size() && skyline[end].x + skyline[end].width <= right) {
+        ++end;
+    }
+    if (end < skyline.size() && skyline[end].x < right) {
+        skyline[end].width -= right - skyline[end].x;
+        skyline[end].x = right;
+    }
+    skyline.erase(skyline.begin() + best, skyline.begin() + end);
+    skyline.insert(skyline.begin() + best, placed);
+
+    for (usize i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+
+    return true;
+}
+
+bool SpriteBatch::create(VkDevice dev, VkPhysicalDevice physicalDevice, VkRenderPass renderPass, VkShaderModule vertexModule, VkShaderModule fragmentModule, u32 spriteCapacity, u32 frameCount, u32 atlasPageSize) {
+    device = dev;
+    maxSprites = spriteCapacity;
+    pageSize = atlasPageSize;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &setLayout) != VK_SUCCESS) {
+        setLayout = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(SpriteConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout) != VK_SUCCESS) {
+        pipelineLayout = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertexModule;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragmentModule;
+    stages[1].pName = "main";
+
+    // one instance per sprite, the strip's four corners come from gl_VertexIndex
+    VkVertexInputBindingDescription vertexBinding = {};
+    vertexBinding.binding = 0;
+    vertexBinding.stride = sizeof(SpriteInstance);
+    vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription attributes[3] = {};
+    attributes[0] = { 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(SpriteInstance, rect) };
+    attributes[1] = { 1, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(SpriteInstance, uv) };
+    attributes[2] = { 2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SpriteInstance, color) };
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &vertexBinding;
+    vertexInput.vertexAttributeDescriptionCount = 3;
+    vertexInput.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // sprites are layered by submission order, depth is neither tested nor written
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_FALSE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+
+    VkPipelineColorBlendAttachmentState blendAttachment = {};
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blendAttachment.blendEnable = VK_TRUE;
+    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+    VkPipelineColorBlendStateCreateInfo colorBlend = {};
+    colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlend.attachmentCount = 1;
+    colorBlend.pAttachments = &blendAttachment;
+
+    VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = stages;
+    pipelineInfo.pVertexInputState = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterization;
+    pipelineInfo.pMultisampleState = &multisample;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlend;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+
+    for (u32 blend = 0; blend < BLEND_COUNT; ++blend) {
+        blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        blendAttachment.dstColorBlendFactor = blend == BLEND_ADDITIVE ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+        if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, hostAllocator(VK_OBJECT_TYPE_PIPELINE), &pipelines[blend]) != VK_SUCCESS) {
+            pipelines[blend] = VK_NULL_HANDLE;
+            cleanup();
+            return false;
+        }
+    }
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    if (vkCreateSampler(device, &samplerInfo, hostAllocator(VK_OBJECT_TYPE_SAMPLER), &sampler) != VK_SUCCESS) {
+        sampler = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+
+    descriptorAllocator.init(device, 8, {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+    });
+
+    frames.resize(frameCount);
+    for (Frame& frame : frames) {
+        if (!createBuffer(device, memoryProperties, sizeof(SpriteInstance) * static_cast<VkDeviceSize>(maxSprites), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_OTHER, {}, &frame.buffer, &frame.memory)
+            || vkMapMemory(device, frame.memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&frame.sprites)) != VK_SUCCESS) {
+            cleanup();
+            return false;
+        }
+    }
+
+    currentFrame = 0;
+    return true;
+}
+
+void SpriteBatch::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    finishAtlasUploads();
+
+    for (Frame& frame : frames) {
+        vkDestroyBuffer(device, frame.buffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+        freeMemory(device, frame.memory);
+    }
+    frames.clear();
+
+    for (Page& page : pages) {
+        vkDestroyImageView(device, page.view, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+        vkDestroyImage(device, page.image, hostAllocator(VK_OBJECT_TYPE_IMAGE));
+        freeMemory(device, page.memory);
+    }
+    pages.clear();
+    descriptorAllocator.cleanup();
+
+    vkDestroySampler(device, sampler, hostAllocator(VK_OBJECT_TYPE_SAMPLER));
+    for (VkPipeline& pipeline : pipelines) {
+        vkDestroyPipeline(device, pipeline, hostAllocator(VK_OBJECT_TYPE_PIPELINE));
+        pipeline = VK_NULL_HANDLE;
+    }
+    vkDestroyPipelineLayout(device, pipelineLayout, hostAllocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    vkDestroyDescriptorSetLayout(device, setLayout, hostAllocator(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    sampler = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    setLayout = VK_NULL_HANDLE;
+
+    runs.clear();
+    spriteCount = 0;
+}
+
+bool SpriteBatch::createPage() {
+    Page page;
+    page.packer.init(pageSize, pageSize);
+    page.pixels.assign(static_cast<usize>(pageSize) * pageSize * 4, 0);
+    if (!makeResident(page)) {
+        return false;
+    }
+    pages.push_back(std::move(page));
+    return true;
+}
+
+bool SpriteBatch::makeResident(Page& page) {
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = { pageSize, pageSize, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE), &page.image) != VK_SUCCESS) {
+        page.image = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(device, page.image, &memoryRequirements);
+
+    if (!reserve(memoryRequirements) || !allocateMemory(device, memoryProperties, memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryBudget::CATEGORY_TEXTURES, &page.memory)) {
+        evict(page);
+        return false;
+    }
+    vkBindImageMemory(device, page.image, page.memory, 0);
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = page.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device, &viewInfo, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW), &page.view) != VK_SUCCESS) {
+        page.view = VK_NULL_HANDLE;
+        evict(page);
+        return false;
+    }
+    // kept through evictions, only the image behind it changes
+    if (page.set == VK_NULL_HANDLE && !descriptorAllocator.allocate(setLayout, &page.set)) {
+        page.set = VK_NULL_HANDLE;
+        evict(page);
+        return false;
+    }
+
+    DescriptorWriter writer(device);
+    writer.writeImage(page.set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, page.view, sampler);
+    writer.flush();
+
+    // the whole page is uploaded again, and it isn't evicted before a frame had the chance to draw from it
+    page.dirty = true;
+    page.lastUsed = frameNumber;
+    return true;
+}
+
+bool SpriteBatch::reserve(VkMemoryRequirements const& requirements) {
+    MemoryBudget& budget = MemoryBudget::instance();
+    budget.update();
+
+    while (true) {
+        u32 type = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memoryProperties, requirements.size);
+        // allocateMemory() says what is wrong when there is no type at all
+        if (type == MEMORY_TYPE_NONE || budget.fits(memoryProperties.memoryTypes[type].heapIndex, requirements.size)) {
+            return true;
+        }
+
+        // an upload in flight may be writing any page, and frames in flight may still sample the ones they drew from
+        Page* oldest = nullptr;
+        for (Page& page : pages) {
+            if (page.isResident() && page.lastUsed + frames.size() <= frameNumber && (oldest == nullptr || page.lastUsed < oldest->lastUsed)) {
+                oldest = &page;
+            }
+        }
+        if (oldest == nullptr || stagingBuffer != VK_NULL_HANDLE) {
+            return false;
+        }
+
+        evict(*oldest);
+        ++evictions;
+    }
+}
+
+void SpriteBatch::evict(Page& page) {
+    vkDestroyImageView(device, page.view, hostAllocator(VK_OBJECT_TYPE_IMAGE_VIEW));
+    vkDestroyImage(device, page.image, hostAllocator(VK_OBJECT_TYPE_IMAGE));
+    freeMemory(device, page.memory);
+    page.view = VK_NULL_HANDLE;
+    page.image = VK_NULL_HANDLE;
+    page.memory = VK_NULL_HANDLE;
+    // the pixels are kept, use() wants the page back when it is drawn again
+    page.dirty = false;
+    page.uploaded = false;
+}
+
+AtlasRegion SpriteBatch::addTexture(u8 const* rgba, u32 width, u32 height) {
+    AtlasRegion region;
+    if (width == 0 || height == 0 || width + 2 * PADDING > pageSize || height + 2 * PADDING > pageSize) {
+        return region;
+    }
+    region.width = width;
+    region.height = height;
+
+    u32 x = 0;
+    u32 y = 0;
+    u32 page = 0;
+    bool newPage = true;
+    std::vector<u8> downsampled;
+    while (true) {
+        const u32 paddedWidth = width + 2 * PADDING;
+        const u32 paddedHeight = height + 2 * PADDING;
+        page = 0;
+        while (page < pages.size() && !pages[page].packer.pack(paddedWidth, paddedHeight, &x, &y)) {
+            ++page;
+        }
+        if (page < pages.size() || (newPage && createPage() && pages[page].packer.pack(paddedWidth, paddedHeight, &x, &y))) {
+            break;
+        }
+
+        // no room for another page, the texture makes do with fewer texels in the ones there are
+        if (width == 1 && height == 1) {
+            return region;
+        }
+        downsampledTextures += newPage;
+        newPage = false;
+        std::vector<u8> half;
+        halve(rgba, width, height, half);
+        downsampled.swap(half);
+        rgba = downsampled.data();
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    // the padding repeats the edge texels, so filtering at the border never blends in a neighbour
+    const u32 paddedWidth = width + 2 * PADDING;
+    const u32 paddedHeight = height + 2 * PADDING;
+    Page& target = pages[page];
+    for (u32 row = 0; row < paddedHeight; ++row) {
+        u32 sourceRow = std::min(std::max(row, PADDING) - PADDING, height - 1);
+        for (u32 column = 0; column < paddedWidth; ++column) {
+            u32 sourceColumn = std::min(std::max(column, PADDING) - PADDING, width - 1);
+            memcpy(&target.pixels[((static_cast<usize>(y) + row) * pageSize + x + column) * 4], &rgba[(static_cast<usize>(sourceRow) * width + sourceColumn) * 4], 4);
+        }
+    }
+    target.dirty = true;
+
+    auto unorm = [&](u32 texel) -> u16 {
+        return static_cast<u16>((static_cast<u64>(texel) * 65535 + pageSize / 2) / pageSize);
+    };
+    region.page = page;
+    region.uv[0] = unorm(x + PADDING);
+    region.uv[1] = unorm(y + PADDING);
+    region.uv[2] = unorm(x + PADDING + width);
+    region.uv[3] = unorm(y + PADDING + height);
+    return region;
+}
+
+bool SpriteBatch::recordAtlasUploads(VkCommandBuffer commandBuffer) {
+    const VkDeviceSize pageBytes = static_cast<VkDeviceSize>(pageSize) * pageSize * 4;
+
+    // a previous upload may still be reading its staging buffer
+    if (stagingBuffer != VK_NULL_HANDLE) {
+        for (Page const& page : pages) {
+            if (page.dirty) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // evicted pages drawn from since come back first, a page that can't stays out until it is drawn again
+    for (Page& page : pages) {
+        if (page.dirty && !page.isResident()) {
+            makeResident(page);
+        }
+    }
+    u32 dirtyPages = 0;
+    for (Page const& page : pages) {
+        dirtyPages += page.dirty && page.isResident();
+    }
+    if (dirtyPages == 0) {
+        return true;
+    }
+
+    u8* staging;
+    if (!createBuffer(device, memoryProperties, pageBytes * dirtyPages, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryBudget::CATEGORY_STAGING, {}, &stagingBuffer, &stagingMemory)
+        || vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&staging)) != VK_SUCCESS) {
+        finishAtlasUploads();
+        return false;
+    }
+
+    VkDeviceSize offset = 0;
+    for (Page& page : pages) {
+        if (!page.dirty || !page.isResident()) {
+            continue;
+        }
+        memcpy(staging + offset, page.pixels.data(), pageBytes);
+
+        // a page drawn from before has to be done being sampled, its old contents are all replaced
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = page.image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(commandBuffer, page.uploaded ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = offset;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { pageSize, pageSize, 1 };
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, page.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        page.dirty = false;
+        page.uploaded = true;
+        offset += pageBytes;
+    }
+
+    return true;
+}
+
+void SpriteBatch::finishAtlasUploads() {
+    vkDestroyBuffer(device, stagingBuffer, hostAllocator(VK_OBJECT_TYPE_BUFFER));
+    freeMemory(device, stagingMemory);
+    stagingBuffer = VK_NULL_HANDLE;
+    stagingMemory = VK_NULL_HANDLE;
+}
+
+void SpriteBatch::begin(u32 frame) {
+    currentFrame = frame;
+    ++frameNumber;
+    spriteCount = 0;
+    runs.clear();
+}
+
+void SpriteBatch::record(VkCommandBuffer commandBuffer, VkViewport const& viewport) const {
+    if (runs.empty()) {
+        return;
+    }
+
+    // framebuffer pixels to NDC through the inverse of the viewport transform
+    SpriteConstants constants;
+    constants.scale[0] = 2.0f / viewport.width;
+    constants.scale[1] = 2.0f / viewport.height;
+    constants.offset[0] = -1.0f - 2.0f * viewport.x / viewport.width;
+    constants.offset[1] = -1.0f - 2.0f * viewport.y / viewport.height;
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SpriteConstants), &constants);
+
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &frames[currentFrame].buffer, &offset);
+
+    u32 boundBlend = BLEND_COUNT;
+    u32 boundPage = ~0u;
+    for (Run const& run : runs) {
+        if (run.blend != boundBlend) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[run.blend]);
+            boundBlend = run.blend;
+        }
+        if (run.page != boundPage) {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &pages[run.page].set, 0, nullptr);
+            boundPage = run.page;
+        }
+        vkCmdDraw(commandBuffer, 4, run.spriteCount, 0, run.firstSprite);
+    }
+}
@@ -0,0 +1,139 @@
+#include <startup.hpp>
+#include <profiler.hpp>
+
+#include <iomanip>
+#include <iostream>
+
+void TaskPool::create(u32 threadCount) {
+    for (u32 i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&TaskPool::workerLoop, this, i + 1);
+    }
+}
+
+void TaskPool::cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    stopping = false;
+}
+
+u32 TaskPool::submit(const char* name, std::function<void()> run) {
+    u32 task;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = static_cast<u32>(tasks.size());
+        tasks.push_back({ name, std::move(run) });
+        if (!workers.empty()) {
+            queue.push_back(task);
+        }
+    }
+
+    if (workers.empty()) {
+        runTask(task, 0);
+    } else {
+        wake.notify_one();
+    }
+    return task;
+}
+
+void TaskPool::wait(u32 task) {
+    std::unique_lock<std::mutex> lock(mutex);
+    // not picked up yet, the caller would only sit idle so it runs the task itself
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (*it == task) {
+            queue.erase(it);
+            lock.unlock();
+            runTask(task, 0);
+            return;
+        }
+    }
+
+    finished.wait(lock, [&]() {
+        return tasks[task].done;
+    });
+}
+
+void TaskPool::workerLoop(u32 worker) {
+    PROFILE_THREAD_NAME("startup worker");
+    while (true) {
+        u32 task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() {
+                return stopping || !queue.empty();
+            });
+            if (queue.empty()) {
+                return;
+            }
+
+            task = queue.front();
+            queue.pop_front();
+        }
+
+        runTask(task, worker);
+    }
+}
+
+void TaskPool::runTask(u32 task, u32 worker) {
+    std::function<void()> run;
+    const char* name;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        run = std::move(tasks[task].run);
+        name = tasks[task].name;
+        tasks[task].worker = worker;
+        tasks[task].start = Clock::now();
+    }
+
+    {
+        PROFILE_ZONE(name);
+        run();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks[task].end = Clock::now();
+        tasks[task].done = true;
+    }
+    finished.notify_all();
+}
+
+void StartupReport::print(TaskPool& pool) const {
+    auto ms = [&](Clock::time_point t) {
+        return std::chrono::duration<f64, std::milli>(t - origin).count();
+    };
+
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1) << "Startup:\n";
+    Clock::time_point begin = origin;
+    for (Step const& s : steps) {
+        std::cout << "    " << std::setw(8) << ms(s.end) - ms(begin) << " ms  " << s.name << "\n";
+        begin = s.end;
+    }
+
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    for (TaskPool::Task const& t : pool.tasks) {
+        if (!t.done) {
+            continue;
+        }
+
+        std::cout << "    " << std::setw(8) << ms(t.end) - ms(t.start) << " ms  " << t.name << " (" << ms(t.start) << " - " << ms(t.end) << " ms, ";
+        if (t.worker == 0) {
+            std::cout << "main thread)\n";
+        } else {
+            std::cout << "worker " << t.worker << ")\n";
+        }
+    }
+
+    if (!steps.empty()) {
+        std::cout << "    " << std::setw(8) << ms(steps.back().end) << " ms  total\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(precision);
+}
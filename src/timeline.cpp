@@ -0,0 +1,198 @@
+#include <timeline.hpp>
+#include <hostalloc.hpp>
+
+#include <algorithm>
+
+bool QueueTimeline::create(VkDevice dev, DeviceCaps const& caps, VkQueue q) {
+    cleanup();
+    device = dev;
+    queue = q;
+    submitted = 0;
+    completed = 0;
+
+    timeline = caps.timelineSemaphore;
+    if (!timeline) {
+        return true;
+    }
+
+    if (caps.apiVersion >= VK_API_VERSION_1_2) {
+        waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphores>(vkGetDeviceProcAddr(device, "vkWaitSemaphores"));
+        getCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValue"));
+    } else {
+        waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphores>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+        getCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+    }
+
+    if (waitSemaphores == nullptr || getCounterValue == nullptr) {
+        timeline = false;
+        return true;
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo = {};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    if (vkCreateSemaphore(device, &semaphoreInfo, hostAllocator(VK_OBJECT_TYPE_SEMAPHORE), &semaphore) != VK_SUCCESS) {
+        semaphore = VK_NULL_HANDLE;
+        cleanup();
+        return false;
+    }
+    return true;
+}
+
+void QueueTimeline::cleanup() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    vkDestroySemaphore(device, semaphore, hostAllocator(VK_OBJECT_TYPE_SEMAPHORE));
+    semaphore = VK_NULL_HANDLE;
+
+    for (auto const& pending : pendingFences) {
+        vkDestroyFence(device, pending.second, hostAllocator(VK_OBJECT_TYPE_FENCE));
+    }
+    for (VkFence fence : freeFences) {
+        vkDestroyFence(device, fence, hostAllocator(VK_OBJECT_TYPE_FENCE));
+    }
+    pendingFences.clear();
+    freeFences.clear();
+}
+
+u64 QueueTimeline::submit(u32 commandBufferCount, VkCommandBuffer const* commandBuffers, std::initializer_list<Wait> waits, VkSemaphore signalSemaphore) {
+    std::vector<VkSemaphore> waitHandles;
+    std::vector<u64> waitValues;
+    std::vector<VkPipelineStageFlags> waitStages;
+    for (Wait const& w : waits) {
+        waitHandles.push_back(w.semaphore);
+        waitValues.push_back(w.value);
+        waitStages.push_back(w.stages);
+    }
+
+    u64 value = submitted + 1;
+    VkSemaphore signalHandles[2] = { semaphore, signalSemaphore };
+    u64 signalValues[2] = { value, 0 };
+    // the timeline semaphore, when there is one, comes first
+    u32 firstSignal = timeline ? 0 : 1;
+    u32 signalCount = (timeline ? 1 : 0) + (signalSemaphore != VK_NULL_HANDLE ? 1 : 0);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = static_cast<u32>(waitHandles.size());
+    submitInfo.pWaitSemaphores = waitHandles.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = commandBufferCount;
+    submitInfo.pCommandBuffers = commandBuffers;
+    submitInfo.signalSemaphoreCount = signalCount;
+    submitInfo.pSignalSemaphores = signalHandles + firstSignal;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = static_cast<u32>(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+    timelineInfo.signalSemaphoreValueCount = signalCount;
+    timelineInfo.pSignalSemaphoreValues = signalValues + firstSignal;
+
+    VkFence fence = VK_NULL_HANDLE;
+    if (timeline) {
+        submitInfo.pNext = &timelineInfo;
+    } else {
+        // a queue whose completion is only ever seen through semaphores never calls wait() or isComplete(), so the
+        // fences come back here or the pool grows by one every submit
+        retireFences();
+        if (!freeFences.empty()) {
+            fence = freeFences.back();
+            freeFences.pop_back();
+        } else {
+            VkFenceCreateInfo fenceInfo = {};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(device, &fenceInfo, hostAllocator(VK_OBJECT_TYPE_FENCE), &fence) != VK_SUCCESS) {
+                return 0;
+            }
+        }
+    }
+
+    if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+        if (fence != VK_NULL_HANDLE) {
+            freeFences.push_back(fence);
+        }
+        return 0;
+    }
+
+    if (fence != VK_NULL_HANDLE) {
+        pendingFences.push_back({ value, fence });
+    }
+    submitted = value;
+    return value;
+}
+
+bool QueueTimeline::wait(u64 value, u64 timeout) {
+    if (value <= completed) {
+        return true;
+    }
+
+    if (timeline) {
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+
+        if (waitSemaphores(device, &waitInfo, timeout) != VK_SUCCESS) {
+            return false;
+        }
+        completed = value;
+        return true;
+    }
+
+    // every fence up to the value, a queue's fences aren't guaranteed to signal in submit order
+    std::vector<VkFence> fences;
+    for (auto const& pending : pendingFences) {
+        if (pending.first <= value) {
+            fences.push_back(pending.second);
+        }
+    }
+    if (!fences.empty() && vkWaitForFences(device, static_cast<u32>(fences.size()), fences.data(), VK_TRUE, timeout) != VK_SUCCESS) {
+        return false;
+    }
+    retireFences();
+    return value <= completed;
+}
+
+bool QueueTimeline::isComplete(u64 value) {
+    if (value <= completed) {
+        return true;
+    }
+
+    if (timeline) {
+        u64 counter = 0;
+        if (getCounterValue(device, semaphore, &counter) == VK_SUCCESS) {
+            completed = std::max(completed, counter);
+        }
+    } else {
+        retireFences();
+    }
+    return value <= completed;
+}
+
+void QueueTimeline::retireFences() {
+    usize retired = 0;
+    while (retired < pendingFences.size() && vkGetFenceStatus(device, pendingFences[retired].second) == VK_SUCCESS) {
+        completed = pendingFences[retired].first;
+        ++retired;
+    }
+
+    for (usize i = 0; i < retired; ++i) {
+        vkResetFences(device, 1, &pendingFences[i].second);
+        freeFences.push_back(pendingFences[i].second);
+    }
+    pendingFences.erase(pendingFences.begin(), pendingFences.begin() + retired);
+
+    if (pendingFences.empty()) {
+        completed = std::max(completed, submitted);
+    }
+}
@@ -0,0 +1,203 @@
+#include <vertex.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static u32 positionSize(VertexFormat::Position position) {
+    return position == VertexFormat::POSITION_SNORM16 ? 4 * sizeof(s16) : 3 * sizeof(f32);
+}
+
+static u32 colorSize(VertexFormat::Color color) {
+    return color == VertexFormat::COLOR_UNORM8 ? 4 * sizeof(u8) : 3 * sizeof(f32);
+}
+
+static u32 uvSize(VertexFormat::Uv uv) {
+    return uv == VertexFormat::UV_FLOAT16 ? 2 * sizeof(u16) : 2 * sizeof(f32);
+}
+
+static u32 normalSize(VertexFormat::Normal normal) {
+    switch (normal) {
+        case VertexFormat::NORMAL_FLOAT32:
+            return 3 * sizeof(f32);
+        case VertexFormat::NORMAL_OCTAHEDRAL:
+            return 2 * sizeof(s16);
+        default:
+            return 0;
+    }
+}
+
+u32 VertexFormat::stride() const {
+    return positionSize(position) + colorSize(color) + uvSize(uv) + normalSize(normal);
+}
+
+u32 VertexFormat::attributes(u32 binding, VkVertexInputAttributeDescription* descriptions) const {
+    u32 count = 0;
+    u32 offset = 0;
+    auto add = [&](u32 location, VkFormat format, u32 size) {
+        descriptions[count].binding = binding;
+        descriptions[count].location = location;
+        descriptions[count].format = format;
+        descriptions[count].offset = offset;
+        ++count;
+        offset += size;
+    };
+
+    add(0, position == POSITION_SNORM16 ? VK_FORMAT_R16G16B16A16_SNORM : VK_FORMAT_R32G32B32_SFLOAT, positionSize(position));
+    add(1, color == COLOR_UNORM8 ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R32G32B32_SFLOAT, colorSize(color));
+    add(2, uv == UV_FLOAT16 ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32_SFLOAT, uvSize(uv));
+    if (normal != NORMAL_NONE) {
+        add(5, normal == NORMAL_OCTAHEDRAL ? VK_FORMAT_R16G16_SNORM : VK_FORMAT_R32G32B32_SFLOAT, normalSize(normal));
+    }
+
+    return count;
+}
+
+u16 floatToHalf(f32 value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    u32 sign = (bits >> 16) & 0x8000;
+    s32 exponent = static_cast<s32>((bits >> 23) & 0xff) - 127 + 15;
+    u32 mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff) {
+        return static_cast<u16>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 31) {
+        return static_cast<u16>(sign | 0x7c00);
+    }
+    if (exponent <= 0) {
+        // subnormal half, or zero once the value is too small to represent
+        if (exponent < -10) {
+            return static_cast<u16>(sign);
+        }
+        mantissa |= 0x800000;
+        u32 shift = static_cast<u32>(14 - exponent);
+        u32 half = mantissa >> shift;
+        u32 rest = mantissa & ((1u << shift) - 1);
+        u32 halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) {
+            ++half;
+        }
+        return static_cast<u16>(sign | half);
+    }
+
+    // round to nearest even, a carry out of the mantissa correctly bumps the exponent
+    u32 half = (static_cast<u32>(exponent) << 10) | (mantissa >> 13);
+    u32 rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        ++half;
+    }
+    return static_cast<u16>(sign | half);
+}
+
+static s16 toSnorm16(f32 value) {
+    return static_cast<s16>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Folds the unit sphere onto the [-1, 1] square, the lower hemisphere mirrored into the corners. A shader gets
+// the normal back with n = vec3(e, 1 - |e.x| - |e.y|); if (n.z < 0) n.xy = (1 - abs(n.yx)) * sign(n.xy); normalize(n).
+static void encodeOctahedral(f32 const normal[3], s16 out[2]) {
+    f32 length = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+    if (length == 0.0f) {
+        out[0] = 0;
+        out[1] = 0;
+        return;
+    }
+
+    f32 x = normal[0] / length;
+    f32 y = normal[1] / length;
+    if (normal[2] < 0.0f) {
+        f32 folded = (1.0f - std::abs(y)) * (x < 0.0f ? -1.0f : 1.0f);
+        y = (1.0f - std::abs(x)) * (y < 0.0f ? -1.0f : 1.0f);
+        x = folded;
+    }
+
+    out[0] = toSnorm16(x);
+    out[1] = toSnorm16(y);
+}
+
+VertexDecode encodeVertices(VertexFormat const& format, Vertex const* vertices, f32 const* normals, u32 count, std::vector<u8>& out) {
+    VertexDecode decode;
+    if (format.position == VertexFormat::POSITION_SNORM16 && count > 0) {
+        f32 min[3] = { vertices[0].x, vertices[0].y, vertices[0].z };
+        f32 max[3] = { min[0], min[1], min[2] };
+        for (u32 i = 1; i < count; ++i) {
+            f32 p[3] = { vertices[i].x, vertices[i].y, vertices[i].z };
+            for (u32 axis = 0; axis < 3; ++axis) {
+                min[axis] = std::min(min[axis], p[axis]);
+                max[axis] = std::max(max[axis], p[axis]);
+            }
+        }
+
+        // a flat axis keeps scale 1 so everything on it encodes to 0 and decodes to the bias
+        for (u32 axis = 0; axis < 3; ++axis) {
+            decode.bias[axis] = (min[axis] + max[axis]) * 0.5f;
+            decode.scale[axis] = max[axis] > min[axis] ? (max[axis] - min[axis]) * 0.5f : 1.0f;
+        }
+    }
+
+    const u32 stride = format.stride();
+    usize base = out.size();
+    out.resize(base + static_cast<usize>(stride) * count);
+
+    static const f32 up[3] = { 0.0f, 0.0f, 1.0f };
+    for (u32 i = 0; i < count; ++i) {
+        Vertex const& v = vertices[i];
+        u8* dst = out.data() + base + static_cast<usize>(stride) * i;
+
+        if (format.position == VertexFormat::POSITION_SNORM16) {
+            s16 p[4] = {
+                toSnorm16((v.x - decode.bias[0]) / decode.scale[0]),
+                toSnorm16((v.y - decode.bias[1]) / decode.scale[1]),
+                toSnorm16((v.z - decode.bias[2]) / decode.scale[2]),
+                0,
+            };
+            memcpy(dst, p, sizeof(p));
+            dst += sizeof(p);
+        } else {
+            f32 p[3] = { v.x, v.y, v.z };
+            memcpy(dst, p, sizeof(p));
+            dst += sizeof(p);
+        }
+
+        if (format.color == VertexFormat::COLOR_UNORM8) {
+            u8 c[4] = {
+                static_cast<u8>(std::lround(std::clamp(v.r, 0.0f, 1.0f) * 255.0f)),
+                static_cast<u8>(std::lround(std::clamp(v.g, 0.0f, 1.0f) * 255.0f)),
+                static_cast<u8>(std::lround(std::clamp(v.b, 0.0f, 1.0f) * 255.0f)),
+                255,
+            };
+            memcpy(dst, c, sizeof(c));
+            dst += sizeof(c);
+        } else {
+            f32 c[3] = { v.r, v.g, v.b };
+            memcpy(dst, c, sizeof(c));
+            dst += sizeof(c);
+        }
+
+        if (format.uv == VertexFormat::UV_FLOAT16) {
+            u16 uv[2] = { floatToHalf(v.u), floatToHalf(v.v) };
+            memcpy(dst, uv, sizeof(uv));
+            dst += sizeof(uv);
+        } else {
+            f32 uv[2] = { v.u, v.v };
+            memcpy(dst, uv, sizeof(uv));
+            dst += sizeof(uv);
+        }
+
+        if (format.normal != VertexFormat::NORMAL_NONE) {
+            f32 const* n = normals != nullptr ? normals + static_cast<usize>(i) * 3 : up;
+            if (format.normal == VertexFormat::NORMAL_OCTAHEDRAL) {
+                s16 e[2];
+                encodeOctahedral(n, e);
+                memcpy(dst, e, sizeof(e));
+            } else {
+                memcpy(dst, n, 3 * sizeof(f32));
+            }
+        }
+    }
+
+    return decode;
+}